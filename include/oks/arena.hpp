@@ -0,0 +1,134 @@
+#ifndef OKS_ARENA_H
+#define OKS_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <atomic>
+
+#include <boost/pool/pool_alloc.hpp>
+
+namespace oks {
+
+    /**
+     *  The arena of objects and values read from data file.
+     *
+     *  In the file arenas mode (see OksKernel::set_file_arenas_mode()) the objects, their values and
+     *  the strings read from a data file are allocated from an arena created for the file loading job,
+     *  instead of the global pools. An arena takes memory by chunks of fixed size from the region of
+     *  virtual memory reserved on first use. The memory of chunk %is returned to the system, when all
+     *  items allocated in the chunk are freed (e.g. when the file %is closed or reloaded).
+     *
+     *  The arena used by a thread %is set by Arena::Scope; items allocated outside of scope, the items
+     *  which do not fit into chunk or when the region %is exhausted, are taken from the global pools.
+     *  An item allocated from arena can be freed by any thread.
+     */
+
+  class Arena {
+
+    public:
+
+      Arena() noexcept : m_ptr(nullptr), m_end(nullptr), m_chunk(0), m_count(0) { ; }
+
+        /** Retire current chunk; its memory %is released when all items allocated in it are freed. **/
+      ~Arena();
+
+        /** Allocate memory from arena; return nullptr, if size %is too big or virtual memory region %is exhausted. **/
+      void * allocate(size_t size) noexcept;
+
+
+        /** Set arena used by current thread to allocate items (nullptr means global pools). **/
+
+      class Scope {
+
+        public:
+
+          Scope(Arena * a) noexcept : m_prev(s_current) { s_current = a; }
+          ~Scope() { s_current = m_prev; }
+
+        private:
+
+          Arena * m_prev;
+
+          Scope(const Scope&);
+          Scope& operator=(const Scope&);
+      };
+
+
+        /** Return true, if the item was allocated from an arena. **/
+
+      static bool contains(const void * p) noexcept {
+        return ((reinterpret_cast<uintptr_t>(p) - s_base.load(std::memory_order_relaxed)) < s_size.load(std::memory_order_relaxed));
+      }
+
+        /** Free item allocated from an arena. **/
+      static void release(void * p) noexcept;
+
+        /** Return number of chunks used by all arenas. **/
+      static size_t chunks_in_use() noexcept;
+
+        /** Size of chunk in bytes. **/
+      static const size_t chunk_size = 1024 * 1024;
+
+
+        /** Allocate item from current arena or from the pool of T. **/
+
+      template<class T> static void * new_item() {
+        if (Arena * a = s_current)
+          if (void * p = a->allocate(sizeof(T)))
+            return p;
+
+        return boost::fast_pool_allocator<T>::allocate();
+      }
+
+        /** Free item allocated by new_item(). **/
+
+      template<class T> static void delete_item(void * p) {
+        if (contains(p))
+          release(p);
+        else
+          boost::fast_pool_allocator<T>::deallocate(reinterpret_cast<T*>(p));
+      }
+
+        /** Allocate array from current arena or from the heap. **/
+
+      static void * new_array(size_t size) {
+        if (Arena * a = s_current)
+          if (void * p = a->allocate(size))
+            return p;
+
+        return ::operator new(size);
+      }
+
+        /** Free array allocated by new_array(). **/
+
+      static void delete_array(void * p) {
+        if (contains(p))
+          release(p);
+        else
+          ::operator delete(p);
+      }
+
+
+    private:
+
+      friend struct ArenaRegion;
+
+      char * m_ptr;       // next free byte in current chunk
+      char * m_end;       // end of current chunk
+      uint32_t m_chunk;   // index of current chunk
+      uint32_t m_count;   // number of items allocated in current chunk
+
+      void retire() noexcept;
+
+      static inline thread_local Arena * s_current = nullptr;
+      static inline std::atomic<uintptr_t> s_base {0};
+      static inline std::atomic<size_t> s_size {0};
+
+      Arena(const Arena&);
+      Arena& operator=(const Arena&);
+  };
+
+}
+
+#endif
@@ -617,6 +617,17 @@ private:
   void
   save(OksXmlOutputStream&) const;
 
+
+  /** Private constructor from schema image */
+
+  OksAttribute(oks::BinaryInputStream&, OksClass *);
+
+
+  /** Private method to save in schema image */
+
+  void
+  put(oks::BinaryOutputStream&) const;
+
   void
   init_enum();
 
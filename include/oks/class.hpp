@@ -209,6 +209,9 @@ class OksClass
   friend class	OksMethod;
   friend class	OksMethodImplementation;
   friend class	OksIndex;
+  friend class	OksHashIndex;
+  friend class	OksCompositeIndex;
+  friend class	OksInvertedIndex;
   friend class	OksSortedClass;
 
   public:
@@ -961,6 +964,9 @@ class OksClass
     OksDataInfo::Map *			p_data_info;
     OksObject::Map *			p_objects;
     OksIndex::Map *			p_indices;
+    OksHashIndex::Map *			p_hash_indices;
+    OksCompositeIndex::List *		p_composite_indices;
+    OksInvertedIndex::Map *		p_inverted_indices;
 
     mutable std::shared_mutex           p_mutex;
     mutable std::mutex                  p_unique_id_mutex;
@@ -977,6 +983,7 @@ class OksClass
 
     ~OksClass();
     OksClass				(OksXmlInputStream &, OksKernel *);
+    OksClass				(oks::BinaryInputStream &, OksKernel *);
 
     template<class T> static void       destroy_map(T map);
     template<class T> static void       destroy_list(T list);
@@ -987,9 +994,23 @@ class OksClass
 
     void save(OksXmlOutputStream &) const;
 
+      // put class definition and its registration (inheritance closures) into schema image
+
+    void put(oks::BinaryOutputStream &) const;
+    void put_registration(oks::BinaryOutputStream &) const;
+
     void add(OksObject *);
     void remove(OksObject *);
+
+      // call function for hash (composite, inverted) indices containing objects of this class,
+      // i.e. indices of this class and indices of its superclasses built with subclasses
+
+    template<class F> void for_each_hash_index(F f) const;
+    template<class F> void for_each_composite_index(F f) const;
+    template<class F> void for_each_inverted_index(F f) const;
+
     void registrate_class(bool skip_registered);
+    void registrate_class(oks::BinaryInputStream &);
     void registrate_class_change(ChangeType, const void *, bool = true);
     void registrate_attribute_change(OksAttribute *);
     void registrate_relationship_change(OksRelationship *);
@@ -1090,7 +1111,70 @@ OksClass::OksClass (const char * name, size_t len) :
   p_instance_size	  (0),
   p_data_info		  (0),
   p_objects		  (0),
-  p_indices		  (0)
+  p_indices		  (0),
+  p_hash_indices	  (0),
+  p_composite_indices	  (0),
+  p_inverted_indices	  (0)
 { ; }
 
+
+template<class F>
+void
+OksClass::for_each_hash_index(F f) const
+{
+  if(p_hash_indices) {
+    for(const auto& i : *p_hash_indices) f(i.second);
+  }
+
+  if(p_all_super_classes) {
+    for(const auto& c : *p_all_super_classes) {
+      if(c->p_hash_indices) {
+        for(const auto& i : *c->p_hash_indices) {
+          if(i.second->spans_subclasses()) f(i.second);
+        }
+      }
+    }
+  }
+}
+
+
+template<class F>
+void
+OksClass::for_each_composite_index(F f) const
+{
+  if(p_composite_indices) {
+    for(const auto& i : *p_composite_indices) f(i);
+  }
+
+  if(p_all_super_classes) {
+    for(const auto& c : *p_all_super_classes) {
+      if(c->p_composite_indices) {
+        for(const auto& i : *c->p_composite_indices) {
+          if(i->spans_subclasses()) f(i);
+        }
+      }
+    }
+  }
+}
+
+
+template<class F>
+void
+OksClass::for_each_inverted_index(F f) const
+{
+  if(p_inverted_indices) {
+    for(const auto& i : *p_inverted_indices) f(i.second);
+  }
+
+  if(p_all_super_classes) {
+    for(const auto& c : *p_all_super_classes) {
+      if(c->p_inverted_indices) {
+        for(const auto& i : *c->p_inverted_indices) {
+          if(i.second->spans_subclasses()) f(i.second);
+        }
+      }
+    }
+  }
+}
+
 #endif
@@ -27,6 +27,13 @@ class OksXmlOutputStream;
 class OksXmlInputStream;
 class OksKernel;
 class OksFile;
+class OksObject;
+
+namespace oks
+{
+  class BinaryInputStream;
+  class BinaryOutputStream;
+}
 
 namespace boost
 {
@@ -351,6 +358,12 @@ class OksFile {
       ReadWrite
     };
 
+    enum Compression {
+      Uncompressed,
+      Gzip,
+      Zstd
+    };
+
     enum FileStatus {
       FileNotModified,
       FileModified,
@@ -518,6 +531,16 @@ class OksFile {
     const std::string& get_full_file_name() const {return p_full_name;}
 
 
+      /**
+       *   \brief Return name of the journal of data file.
+       *
+       *   In journal mode of OKS kernel the changes of data file are appended to its journal
+       *   instead of rewriting the file; see OksKernel::set_journal_mode() for more information.
+       */
+
+    std::string get_journal_file_name() const {return p_full_name + ".journal";}
+
+
       /**
        *   \brief Get information about repository, the file belongs to.
        *
@@ -563,6 +586,27 @@ class OksFile {
     const std::string& get_oks_format() const {return p_oks_format;}
 
 
+      /**
+       *   \brief Get compression of file.
+       *
+       *   The compressed files are detected by magic bytes when loaded; the data files are saved using the same compression.
+       */
+
+    Compression get_compression() const {return p_compression;}
+
+
+      /**
+       *   \brief Set compression used to save data file.
+       *
+       *   The gzip- and zstd-compressed data files are transparently read by OKS kernel.
+       *   Note, the compressed files cannot be read by old OKS releases.
+       *
+       *   \param c the compression
+       */
+
+    void set_compression(Compression c) {p_compression = c;}
+
+
       /** Return number of classes in schema file, or number of objects in data file. */
 
     long get_number_of_items() const {return p_number_of_items;}
@@ -573,6 +617,11 @@ class OksFile {
     long get_size() const {return p_size;}
 
 
+      /** Return number of parts the data file was split into to be parsed by several threads (see OksKernel::set_split_data_files_mode()), or 1. */
+
+    long get_number_of_parts() const {return p_number_of_parts;}
+
+
       /** Return name of user who created this file. */
 
     const std::string& get_created_by() const {return p_created_by;}
@@ -666,6 +715,33 @@ class OksFile {
        */
 
     void update_status_of_file(bool update_local = true, bool update_repository = true);
+
+
+      /**
+       *   \brief Return checksum of file contents.
+       *
+       *   The checksum %is stored in the header comment of uncompressed xml file, when the file %is saved.
+       *   If the file was modified by external process, but its contents match the checksum,
+       *   the get_status_of_file() method reports the file as not modified, so it %is not reloaded.
+       *
+       *   \return  the checksum or 0, if it %is unknown (e.g. compressed file or file saved by old version of OKS)
+       */
+
+    uint64_t get_checksum() const { return p_checksum; }
+
+
+      /**
+       *   \brief Return checksum of file contents excluding last-modification information.
+       *
+       *   The checksum %is calculated from the info, include, comments and objects sections written in canonical order
+       *   and it %is stored in the header comment next to the file checksum. When the file %is saved
+       *   and the checksum of new contents %is equal to the one of the file on disk (e.g. the changes were reverted),
+       *   the file on disk %is not touched.
+       *
+       *   \return  the checksum or 0, if it %is unknown
+       */
+
+    uint64_t get_content_checksum() const { return p_content_checksum; }
   
 
       /**
@@ -738,6 +814,9 @@ class OksFile {
     std::string p_oks_format;  // format of file: "data" or "schema"
     long p_number_of_items;    // number of objects or classes
     long p_size;               // size of file in bytes
+    long p_number_of_parts;    // number of parts the file was split into to be parsed in parallel
+    std::string p_cache_key;   // key of file image in parse cache, if the cache is used
+    Compression p_compression; // compression of file
     std::string p_created_by;
     boost::posix_time::ptime p_creation_time;
     std::string p_created_on;
@@ -752,12 +831,21 @@ class OksFile {
     std::list<std::string> p_list_of_include_files;
     time_t p_last_modified;
     time_t p_repository_last_modified;
+    uint64_t p_checksum;       // checksum of file contents following the header comment storing it, or 0 if unknown
+    uint64_t p_content_checksum; // checksum of file contents excluding last-modification information, or 0 if unknown
     std::map<std::string, oks::Comment *> p_comments;
     bool p_is_on_disk;
     const OksFile * p_included_by;
     OksKernel * p_kernel;
+    std::unordered_set<OksObject *> p_objects; // objects of data file; protected by the kernel's objects mutex
+    std::unordered_set<OksObject *> p_journal_objects; // created or modified objects to be appended to journal; protected by the kernel's objects mutex
+    std::set<std::pair<std::string, std::string>> p_journal_removed; // class names and ids of removed objects to be appended to journal
+    bool p_journal_complete; // all changes since last save are recorded for journal, i.e. the file has no modified header
 
     static const char xml_file_header[];
+    static const char xml_checksum_start[];
+    static const char xml_checksum_content[];
+    static const char xml_checksum_end[];
     static const char xml_schema_file_dtd[];
     static const char xml_data_file_dtd[];
     static const char xml_info_tag[];
@@ -782,10 +870,18 @@ class OksFile {
     OksFile(const OksFile &f) { *this = f; }
 
     OksFile(std::shared_ptr<OksXmlInputStream>, const std::string&, const std::string&, OksKernel *);
-    void write(OksXmlOutputStream&);
+    void write(OksXmlOutputStream&, bool checksum = false);
+
+    OksFile(oks::BinaryInputStream&, const std::string&, const std::string&, OksKernel *);
+    void write(oks::BinaryOutputStream&, bool update_last_modified = true);
 
     void set_updated() {p_is_updated = true;} // in-memory
 
+    static const size_t checksum_header_len;                             // length of xml file header with checksum comment
+    void write_checksums(OksXmlOutputStream&, std::ostream *);          // set checksums calculated by write(xmls, ...); replace placeholders of header comment in given stream
+    static uint64_t read_checksum(const char *, size_t len, uint64_t * content = nullptr) noexcept; // return checksum stored in the header or 0
+    static uint64_t verify_checksum(const char *, size_t len) noexcept; // return checksum stored in the header, if it matches the contents, or 0
+
     void rename(const std::string& short_name, const std::string& full_name);
     void rename(const std::string& full_name);  // repository rename
     void create_lock_name();
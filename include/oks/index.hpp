@@ -5,7 +5,12 @@
 #include "oks/attribute.hpp"
 #include "oks/object.hpp"
 
+#include <atomic>
 #include <set>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 class OksObjectSortBy {
 
@@ -91,6 +96,236 @@ class OksObjectSortBy {
 
     static size_t       get_offset(OksClass *, OksAttribute *);
 
+};
+
+
+  /**
+   *  \brief The hash index of objects by value of attribute.
+   *
+   *  Unlike OksIndex, the hash index only supports search of objects having attribute value equal to given one;
+   *  it is used by OksClass::execute_query() for queries with \b equal_cmp comparator instead of ordered index of the same attribute.
+   *  The index uses open addressing with linear probing on OksData::hash(); a slot keeps all objects with equal values.
+   *
+   *  If the index %is built with \b subclasses parameter, it contains objects of the class and of all its subclasses
+   *  (the class can be abstract) and it %is used by queries searching in subclasses.
+   */
+
+class OksHashIndex {
+  friend class OksClass;
+  friend class OksObject;
+
+
+  public:
+
+    typedef std::map<const OksAttribute *, OksHashIndex *, OksIndex::SortByName> Map;
+
+
+    OksHashIndex	(OksClass *, OksAttribute *, bool subclasses = false);
+    ~OksHashIndex	();
+
+    OksObject::List *	FindEqual(const OksData *d) const;
+
+    size_t		size() const {return p_size;}
+
+    bool		spans_subclasses() const {return p_subclasses;}
+
+      /** Return number of searches done in the index (e.g. to check that a query %is executed using the index). */
+
+    size_t		number_of_lookups() const {return p_number_of_lookups.load(std::memory_order_relaxed);}
+
+
+  private:
+
+    struct Slot {
+      size_t hash = 0;
+      enum { empty, used, removed } state = empty;
+      std::vector<OksObject *> objects;
+    };
+
+    OksClass *		c;
+    OksAttribute *	a;
+    size_t		offset;
+    bool		p_subclasses;
+
+    std::map<const OksClass *, size_t>	p_class_offsets;   // offsets of attribute in subclasses
+
+    std::vector<Slot>	p_slots;
+    size_t		p_size;           // number of objects
+    size_t		p_used_slots;     // number of slots in used or removed state
+
+    mutable std::atomic<size_t> p_number_of_lookups {0};
+
+    void		insert(OksObject *);
+    OksObject *		remove_obj(OksObject *);
+
+    const Slot *	find(const OksData&, size_t) const;
+    void		rehash(size_t);
+
+    void		add_class(const OksClass *);
+    const OksData&	value(const OksObject *) const;
+
+};
+
+
+  /**
+   *  \brief The index of objects by values of several attributes.
+   *
+   *  The objects are ordered by values of attributes in the order they are given to the constructor
+   *  (i.e. by the first attribute, then objects with equal values of first attribute by the second one, etc.).
+   *  The OksClass::execute_query() uses the index for a comparator or an \b and expression, if there are
+   *  \b equal_cmp comparators for a prefix of index attributes, which may be followed by one or two range
+   *  comparators (less, greater, etc.) for the next attribute; other comparators of \b and expression are
+   *  tested on objects found by the index.
+   *
+   *  If the index %is built with \b subclasses parameter, it contains objects of the class and of all its subclasses
+   *  (the class can be abstract) and it %is used by queries searching in subclasses.
+   *
+   *  The multi-value attributes are not supported.
+   */
+
+class OksCompositeIndex {
+  friend class OksClass;
+  friend class OksObject;
+
+
+  public:
+
+    typedef std::list<OksCompositeIndex *> List;
+
+
+    OksCompositeIndex	(OksClass *, const std::vector<OksAttribute *>&, bool subclasses = false);
+    ~OksCompositeIndex	();
+
+    const std::vector<OksAttribute *>& attributes() const {return p_attributes;}
+
+
+      /**
+       *  \brief Find objects by values of index attributes.
+       *
+       *  The parameters are:
+       *  \param eq       values of prefix of index attributes
+       *  \param low      optional low limit for value of next attribute (can be null)
+       *  \param low_eq   if true, the value of next attribute can be equal to low limit
+       *  \param high     optional high limit for value of next attribute (can be null)
+       *  \param high_eq  if true, the value of next attribute can be equal to high limit
+       *
+       *  \return the list of objects (can be null, if there are no such objects); the user is responsible to destroy the returned list
+       */
+
+    OksObject::List *	find_all(const std::vector<const OksData *>& eq, const OksData * low = nullptr, bool low_eq = true, const OksData * high = nullptr, bool high_eq = true) const;
+
+    size_t		size() const {return p_objects.size();}
+
+    bool		spans_subclasses() const {return p_subclasses;}
+
+      /** Return number of searches done in the index (e.g. to check that a query %is executed using the index). */
+
+    size_t		number_of_lookups() const {return p_number_of_lookups.load(std::memory_order_relaxed);}
+
+
+  private:
+
+      // position before (or after) all objects which values are equal to the key
+
+    struct Key {
+      const OksData * const * values;
+      size_t num;
+      bool after;
+    };
+
+    struct SortBy {
+      typedef void is_transparent;
+
+      const OksCompositeIndex * index;
+
+      int compare(const OksObject *, const OksObject *) const;
+      int compare(const OksObject *, const Key&) const;
+
+      bool operator()(const OksObject * o1, const OksObject * o2) const {return (compare(o1, o2) < 0);}
+      bool operator()(const OksObject * o, const Key& k) const {int c = compare(o, k); return (k.after ? c <= 0 : c < 0);}
+      bool operator()(const Key& k, const OksObject * o) const {int c = compare(o, k); return (k.after ? c > 0 : c >= 0);}
+    };
+
+    OksClass *				c;
+    std::vector<OksAttribute *>		p_attributes;
+    std::vector<size_t>			p_offsets;
+    bool				p_subclasses;
+    std::map<const OksClass *, std::vector<size_t>> p_class_offsets;   // offsets of attributes in subclasses
+    std::multiset<OksObject *, SortBy>	p_objects;
+
+    mutable std::atomic<size_t>		p_number_of_lookups {0};
+
+    void		insert(OksObject *);
+    OksObject *		remove_obj(OksObject *);
+    bool		contains(const OksAttribute *) const;
+
+    void		add_class(const OksClass *);
+    const size_t *	offsets(const OksObject *) const;
+
+};
+
+
+  /**
+   *  \brief The inverted index of objects by items of multi-value attribute.
+   *
+   *  The index maps each item value of multi-value attribute to objects containing such item;
+   *  it %is used by OksClass::execute_query() for queries with \b contains_cmp comparator.
+   *
+   *  If the index %is built with \b subclasses parameter, it contains objects of the class and of all its subclasses
+   *  (the class can be abstract) and it %is used by queries searching in subclasses.
+   */
+
+class OksInvertedIndex {
+  friend class OksClass;
+  friend class OksObject;
+
+
+  public:
+
+    typedef std::map<const OksAttribute *, OksInvertedIndex *, OksIndex::SortByName> Map;
+
+
+    OksInvertedIndex	(OksClass *, OksAttribute *, bool subclasses = false);
+    ~OksInvertedIndex	();
+
+      /** Return objects having an item equal to given value (can be null, if there are no such objects); the user is responsible to destroy the returned list. */
+
+    OksObject::List *	FindContaining(const OksData *d) const;
+
+    size_t		size() const {return p_size;}
+    size_t		number_of_items() const {return p_items.size();}
+
+    bool		spans_subclasses() const {return p_subclasses;}
+
+      /** Return number of searches done in the index (e.g. to check that a query %is executed using the index). */
+
+    size_t		number_of_lookups() const {return p_number_of_lookups.load(std::memory_order_relaxed);}
+
+
+  private:
+
+    struct Hash {
+      size_t operator()(const OksData& d) const noexcept {return d.hash();}
+    };
+
+    OksClass *		c;
+    OksAttribute *	a;
+    size_t		offset;
+    bool		p_subclasses;
+
+    std::map<const OksClass *, size_t>	p_class_offsets;   // offsets of attribute in subclasses
+
+    std::unordered_map<OksData, std::unordered_set<OksObject *>, Hash> p_items;
+    size_t		p_size;           // number of objects
+
+    mutable std::atomic<size_t> p_number_of_lookups {0};
+
+    void		insert(OksObject *);
+    OksObject *		remove_obj(OksObject *);
+
+    void		add_class(const OksClass *);
+    const OksData&	value(const OksObject *) const;
+
 };
 
 #endif
@@ -19,6 +19,8 @@
 #include <shared_mutex>
 #include <set>
 #include <vector>
+#include <unordered_map>
+#include <atomic>
 
 #include <boost/shared_ptr.hpp>
 
@@ -203,16 +205,21 @@ namespace oks {
     public:
 
         /** The constructor gets reason from nested oks exception. **/
-      CanNotWriteToFile(const char * prefix, const char * item, const std::string& name, const exception& reason) noexcept : exception (fill(prefix, item, name, reason.what()), reason.level() + 1) {}
+      CanNotWriteToFile(const char * prefix, const char * item, const std::string& name, const exception& reason) noexcept : exception (fill(prefix, item, name, reason.what()), reason.level() + 1), p_reason(reason.what()) {}
 
         /** The constructor gets reason from non-oks exception. **/
-      CanNotWriteToFile(const char * prefix, const char * item, const std::string& name, const std::string& reason) noexcept : exception (fill(prefix, item, name, reason), 0) {}
+      CanNotWriteToFile(const char * prefix, const char * item, const std::string& name, const std::string& reason) noexcept : exception (fill(prefix, item, name, reason), 0), p_reason(reason) {}
 
       virtual ~CanNotWriteToFile() noexcept { }
 
+        /** Return the reason without the name of file. **/
+      const std::string& reason() const noexcept { return p_reason; }
+
 
     private:
 
+      std::string p_reason;
+
       static std::string fill(const char * prefix, const char * item, const std::string& name, const std::string& reason) noexcept;
 
   };
@@ -581,6 +588,7 @@ class OksKernel
   friend class OksClass;
   friend class OksObject;
   friend struct OksLoadObjectsJob;
+  friend struct OksSaveDataJob;
   friend struct OksData;
 
 
@@ -809,6 +817,237 @@ class OksKernel
 
     static void set_skip_string_range(const bool b) {p_skip_string_range = b;}
 
+
+      /**
+       *  \brief Get status of mapped files mode.
+       *  The method returns true, if the mapped files mode %is switched 'On'.
+       *  In such case the OKS reads schema and data files mapped into memory instead of using file streams.
+       */
+
+    bool get_use_mapped_files_mode() const {return p_use_mapped_files;}
+
+
+      /**
+       *  \brief Set status of mapped files mode.
+       *  To switch 'On'/'Off' use the method's parameter:
+       *    \param b  - set 'true' to switch 'On' or 'false' to switch 'Off'.
+       *
+       *  The mapped files mode can also be switched 'On' using the "OKS_KERNEL_USE_MAPPED_FILES"
+       *  environment variable set to any value except 'no'.
+       */
+
+    void set_use_mapped_files_mode(const bool b) {p_use_mapped_files = b;}
+
+
+      /**
+       *  \brief Get status of split data files mode.
+       *  The method returns true, if the split data files mode %is switched 'On'.
+       *  In such case a large data file %is split at object boundaries into several parts parsed in parallel.
+       *  The mode %is only used for files in normal and extended formats read in mapped files mode.
+       */
+
+    bool get_split_data_files_mode() const {return p_split_data_files;}
+
+
+      /**
+       *  \brief Set status of split data files mode.
+       *  To switch 'On'/'Off' use the method's parameter:
+       *    \param b  - set 'true' to switch 'On' or 'false' to switch 'Off'.
+       *
+       *  The split data files mode can also be switched 'On' using the "OKS_KERNEL_SPLIT_DATA_FILES"
+       *  environment variable set to any value except 'no'.
+       */
+
+    void set_split_data_files_mode(const bool b) {p_split_data_files = b;}
+
+
+      /**
+       *  \brief Get status of lazy objects mode.
+       *  The method returns true, if the lazy objects mode %is switched 'On'.
+       *  In such case only the class and identity of an object are read when a data file %is loaded;
+       *  the values of object's attributes and relationships are read on first access to them.
+       *  The mode %is only used for files in normal and extended formats read in mapped files mode.
+       *  It %is not used for objects of classes having indices or composite relationships.
+       *  A data file must not be modified in place while its objects are not read (the files saved by OKS are replaced).
+       */
+
+    bool get_lazy_objects_mode() const {return p_lazy_objects;}
+
+
+      /**
+       *  \brief Set status of lazy objects mode.
+       *  To switch 'On'/'Off' use the method's parameter:
+       *    \param b  - set 'true' to switch 'On' or 'false' to switch 'Off'.
+       *
+       *  The lazy objects mode can also be switched 'On' using the "OKS_KERNEL_LAZY_OBJECTS"
+       *  environment variable set to any value except 'no'.
+       */
+
+    void set_lazy_objects_mode(const bool b) {p_lazy_objects = b;}
+
+
+      /**
+       *  \brief Get status of parallel save mode.
+       *  The method returns true, if the parallel save mode %is switched 'On'.
+       *  In such case the save_all_data() method writes data files in parallel using the threads pool.
+       *  If any file cannot be saved, the other files are still saved and all errors are reported by single exception.
+       */
+
+    bool get_parallel_save_mode() const {return p_parallel_save;}
+
+
+      /**
+       *  \brief Set status of parallel save mode.
+       *  To switch 'On'/'Off' use the method's parameter:
+       *    \param b  - set 'true' to switch 'On' or 'false' to switch 'Off'.
+       *
+       *  The parallel save mode can also be switched 'On' using the "OKS_KERNEL_PARALLEL_SAVE"
+       *  environment variable set to any value except 'no'.
+       */
+
+    void set_parallel_save_mode(const bool b) {p_parallel_save = b;}
+
+
+      /**
+       *  \brief Get status of journal mode.
+       *  The method returns true, if the journal mode %is switched 'On'.
+       *  In such case the save_data() method appends objects created, modified or removed since last save
+       *  to the journal of data file (see OksFile::get_journal_file_name()) instead of rewriting the file.
+       *  The changes are recorded via the create, change and delete object notification points.
+       *  If the header of file was modified (e.g. includes or comments), the file %is rewritten as usual.
+       *  The journal %is replayed, when the file %is loaded or reloaded, independently of this mode.
+       *  Use compact_data() to rewrite the file and to remove its journal.
+       */
+
+    bool get_journal_mode() const {return p_journal;}
+
+
+      /**
+       *  \brief Set status of journal mode.
+       *  To switch 'On'/'Off' use the method's parameter:
+       *    \param b  - set 'true' to switch 'On' or 'false' to switch 'Off'.
+       *
+       *  The changes made before the mode %is switched 'On' are not recorded, so the files
+       *  updated at that moment will be rewritten on next save.
+       *
+       *  The journal mode can also be switched 'On' using the "OKS_KERNEL_JOURNAL"
+       *  environment variable set to any value except 'no'.
+       */
+
+    void set_journal_mode(const bool b);
+
+
+      /**
+       *  \brief Get status of shared strings mode.
+       *  The method returns true, if the shared strings mode %is switched 'On'.
+       *  In such case the string values of attributes read from data files are taken
+       *  from the oks::SharedStrings pool, so equal values of different objects use single string.
+       *  Such strings must not be modified in place via OksData::data.STRING (use OksData::Set() or
+       *  OksObject::SetAttributeValue() instead); the OksData::shared flag %is set for them.
+       */
+
+    bool get_shared_strings_mode() const {return p_shared_strings;}
+
+
+      /**
+       *  \brief Set status of shared strings mode.
+       *  To switch 'On'/'Off' use the method's parameter:
+       *    \param b  - set 'true' to switch 'On' or 'false' to switch 'Off'.
+       *
+       *  The mode %is applied to files loaded after the call.
+       *
+       *  The shared strings mode can also be switched 'On' using the "OKS_KERNEL_SHARED_STRINGS"
+       *  environment variable set to any value except 'no'.
+       */
+
+    void set_shared_strings_mode(const bool b) {p_shared_strings = b;}
+
+
+      /**
+       *  \brief Get status of file arenas mode.
+       *  The method returns true, if the file arenas mode %is switched 'On'.
+       *  In such case the objects, their values and strings read from a data file are allocated
+       *  from an arena of the file loading job (see oks::Arena) instead of the global pools.
+       *  The memory of arena %is returned to the system, when the objects of file are destroyed
+       *  (e.g. when the file %is closed or reloaded), and parallel loading of files does not contend on the pools.
+       *  The memory of values freed by modification of objects %is only reused after all items of arena chunk are freed.
+       *  The arena %is not owned by OksFile: its chunks are released by counting of not freed items, so objects moved
+       *  to another file or destroyed after the file %is closed stay valid. On reload_data() the objects keep the memory
+       *  of previous load, while their new values are taken from the arena of reload job.
+       */
+
+    bool get_file_arenas_mode() const {return p_file_arenas;}
+
+
+      /**
+       *  \brief Set status of file arenas mode.
+       *  To switch 'On'/'Off' use the method's parameter:
+       *    \param b  - set 'true' to switch 'On' or 'false' to switch 'Off'.
+       *
+       *  The file arenas mode can also be switched 'On' using the "OKS_KERNEL_FILE_ARENAS"
+       *  environment variable set to any value except 'no'.
+       */
+
+    void set_file_arenas_mode(const bool b) {p_file_arenas = b;}
+
+
+      /**
+       *  \brief The durability level of saved files.
+       *  - NoSync - the data are left in the operating system buffers
+       *  - DataSync - the contents of file are flushed to the storage device using fdatasync() before it replaces old file
+       *  - FullSync - the contents and metadata of file are flushed using fsync() and the directory %is flushed after the file %is renamed
+       */
+
+    enum DurabilityLevel {
+      NoSync,
+      DataSync,
+      FullSync
+    };
+
+
+      /**
+       *  \brief Get durability level of saved files.
+       *  The level %is used when schema and data files are saved and when journals are appended.
+       */
+
+    DurabilityLevel get_durability_level() const {return p_durability_level;}
+
+
+      /**
+       *  \brief Set durability level of saved files.
+       *    \param level  - the new level; the NoSync %is used by default.
+       *
+       *  The durability level can also be set using the "OKS_KERNEL_DURABILITY"
+       *  environment variable set to 'fdatasync' or 'fsync'.
+       */
+
+    void set_durability_level(const DurabilityLevel level) {p_durability_level = level;}
+
+
+      /**
+       *  \brief Get directory of parse cache.
+       *  The method returns path to directory used to store binary images of loaded schema and data files.
+       *  The empty string means the parse cache %is not used.
+       */
+
+    const std::string& get_cache_dir() const {return p_cache_dir;}
+
+
+      /**
+       *  \brief Set directory of parse cache.
+       *  When set, the binary image of each schema and data file loaded from xml %is stored in given directory.
+       *  The image %is keyed by full path, size, modification time and content hash of the file
+       *  and it %is used instead of xml parsing on next load, when all of them match.
+       *  Otherwise the file %is loaded from xml and its image %is (re)written.
+       *  The image of schema file also contains registered inheritance closures of its classes,
+       *  that are used while the files defining their superclasses are not changed.
+       *    \param dir  - path to cache directory or empty string to switch the cache 'Off'.
+       *
+       *  The cache directory can also be set using the "OKS_KERNEL_CACHE_DIR" environment variable.
+       */
+
+    void set_cache_dir(const std::string& dir) {p_cache_dir = dir;}
+
       /**
        *  \brief Return OKS kernel mutex.
        * 
@@ -1286,6 +1525,26 @@ class OksKernel
     OksFile * load_data(const std::string& name, bool bind = true);
 
 
+      /**
+       *  \brief Stream through objects of OKS data file.
+       *
+       *  The method reads objects of data file one by one and passes their classes, identities and values
+       *  of attributes and relationships to the visitor, see oks::DataVisitor for details.
+       *  No OKS objects are created and the file %is not added to the kernel, so the used memory
+       *  does not depend on the size of the file. The included files are not read.
+       *  Only data files stored in normal format are supported.
+       *
+       *  The method %is thread-safe.
+       *
+       *  \param name     name of the data file
+       *  \param visitor  the visitor of objects
+       *
+       *  \throw Throw oks::exception in case of problems.
+       */
+
+    void visit_data(const std::string& name, oks::DataVisitor& visitor);
+
+
       /**
        *  \brief Reload OKS data files.
        *
@@ -1381,6 +1640,43 @@ class OksKernel
     void backup_data(OksFile * pf, const char * suffix = ".bak");
 
 
+      /**
+       *  \brief Save binary snapshot of OKS data file.
+       *
+       *  The method writes objects of given OKS data file into new file using binary snapshot format.
+       *  Such file %is loaded much faster than xml file, since the values of attributes and relationships are stored as
+       *  type-tagged binary data, and names of classes, attributes and relationships are resolved against the schema
+       *  once per file. The binary files are recognised by their magic header on load and can include or
+       *  be included by xml files. Data file used as a snapshot source remains unchanged.
+       *
+       *  The method %is thread-safe. The user must not have the OKS kernel lock set in the thread which calls this method.
+       *
+       *  \param file_h      a pointer to the OKS data file descriptor
+       *  \param file_name   name of binary file to be written
+       *
+       *  \throw Throw oks::exception in case of problems.
+       */
+
+    void save_binary_data(OksFile * file_h, const std::string& file_name);
+
+
+      /**
+       *  \brief Compact OKS data file.
+       *
+       *  The method rewrites given OKS data file including changes stored in its journal and removes the journal.
+       *  See set_journal_mode() for more information.
+       *
+       *  The method %is thread-safe. The user must not have the OKS kernel lock set in the thread which calls this method.
+       *
+       *  \param file_h              a pointer to the OKS data file descriptor
+       *  \param ignore_bad_objects  save the file if it has inconsistent objects or misses includes
+       *
+       *  \throw Throw oks::exception in case of problems.
+       */
+
+    void compact_data(OksFile * file_h, bool ignore_bad_objects = false);
+
+
       /**
        *  \brief Save OKS data file under new name.
        *
@@ -2022,6 +2318,18 @@ class OksKernel
     bool p_allow_duplicated_classes;
     bool p_allow_duplicated_objects;
     bool p_test_duplicated_objects_via_inheritance;
+    bool p_use_mapped_files;
+    bool p_split_data_files;
+    bool p_lazy_objects;
+    bool p_parallel_save;
+    bool p_journal;
+    bool p_shared_strings;
+    bool p_file_arenas;
+    DurabilityLevel p_durability_level;
+
+    std::string p_cache_dir;
+    std::vector<OksFile *> p_cache_images;
+    std::vector<OksFile *> p_journals; // loaded data files having journals to be replayed
 
     static bool p_skip_string_range;
     static bool p_use_strict_repository_paths;
@@ -2070,6 +2378,17 @@ class OksKernel
 
     OksObject::Set p_objects;
 
+
+      // reverse references index: referenced object => (referencing object, relationship) per each reference;
+      // it is built on first use and dropped by operations changing many objects (load, bind, close, schema changes)
+      // and when a relationship value which can be modified in place is returned to the user
+
+    typedef std::vector<std::pair<OksObject *, const OksRelationship *>> ReverseRefs;
+
+    mutable std::unordered_map<const OksObject *, ReverseRefs> p_reverse_refs;
+    mutable std::atomic<bool> p_reverse_refs_valid {false};
+    mutable std::mutex p_reverse_refs_mutex;
+
     static int p_threads_pool_size;
 
     std::string p_bind_objects_status;
@@ -2124,8 +2443,17 @@ class OksKernel
 
     OksFile * k_load_data(const std::string&, bool, const OksFile *, OksPipeline *);
     void k_load_data(OksFile * fp, char format, std::shared_ptr<OksXmlInputStream> xmls, long file_length, bool bind, const OksFile * parent_h, OksPipeline *);
+    void k_load_binary_data(OksFile * fp, std::shared_ptr<oks::BinaryInputStream> bins, long file_length, bool bind, const OksFile * parent_h, OksPipeline *);
+    OksFile * k_load_cached_file(const std::string& short_file_name, const std::string& full_file_name, bool bind, const OksFile * parent_h, OksPipeline *, std::string& key, char type);
+    bool k_load_schema_image(OksFile * fp, oks::BinaryInputStream& bins, long file_length, const OksFile * parent_h);
+    void k_registrate_loaded_classes(const std::list<OksClass *>& classes);
+    void k_write_cache_images();
+    void k_write_cache_image(OksFile * fp, bool is_data);
     void k_close_data(OksFile *, bool);
     void k_save_data(OksFile *, bool = false, OksFile * = nullptr, const OksObject::FSet * = nullptr, bool force_defaults = false);
+    bool k_append_journal(OksFile *, bool ignore_bad_objects);
+    void k_replay_journals();
+    void k_replay_journal(OksFile *, oks::ReloadObjects *);
     void k_rename_data(OksFile *, const std::string& short_name, const std::string& long_name);
 
     void k_bind_objects();
@@ -2141,11 +2469,33 @@ class OksKernel
 
     void unbind_all_rels(const OksObject::FSet& rm_objs, OksObject::FSet& updated) const;
 
+
+      /**
+       *  \brief Return objects referencing given one.
+       *  The method builds reverse references index, if it is not valid; it has to be called under p_reverse_refs_mutex lock.
+       *  \param o      referenced object
+       *  \return       pointer to (referencing object, relationship) pairs or null, if the object is not referenced
+       */
+
+    const ReverseRefs * k_get_reverse_refs(const OksObject * o) const;
+
+    void k_set_reverse_refs(OksObject * o, const OksRelationship * r, const OksData& d, bool add) const;
+    void k_invalidate_reverse_refs();
+    void k_drop_reverse_refs() const noexcept { if(p_reverse_refs_valid.load(std::memory_order_relaxed)) p_reverse_refs_valid = false; }
+    void k_update_reverse_refs(OksObject * o, const OksRelationship * r, const OksData& d, bool add);
+    void k_remove_reverse_refs(OksObject * o);
+
     void k_add(OksClass*);
     void k_remove(OksClass*);
 
-    void define(OksObject *o) { std::lock_guard lock(p_objects_mutex); p_objects.insert(o);  }
-    void undefine(OksObject *o) { if(!p_objects.empty()) { std::lock_guard lock(p_objects_mutex); p_objects.erase(o); } }
+    void define(OksObject *o) { std::lock_guard lock(p_objects_mutex); p_objects.insert(o); o->file->p_objects.insert(o); }
+    void undefine(OksObject *o) { if(!p_objects.empty()) { std::lock_guard lock(p_objects_mutex); p_objects.erase(o); o->file->p_objects.erase(o); } }
+    void redefine(OksObject *o, OksFile * f) { std::lock_guard lock(p_objects_mutex); o->file->p_objects.erase(o); f->p_objects.insert(o); o->file = f; }
+
+      // record changes of objects for journal
+
+    void journal_update(OksObject *o) { std::lock_guard lock(p_objects_mutex); if(o->file->p_journal_complete) o->file->p_journal_objects.insert(o); }
+    void journal_remove(OksObject *o) { std::lock_guard lock(p_objects_mutex); if(o->file->p_journal_complete) { o->file->p_journal_objects.erase(o); o->file->p_journal_removed.emplace(o->uid.class_id->get_name(), o->uid.object_id); } }
 
     void add_data_file(OksFile *);
     void add_schema_file(OksFile *);
@@ -20,6 +20,11 @@ class   OksXmlInputStream;
 class   OksClass;
 class   OksMethod;
 
+namespace oks {
+  class BinaryInputStream;
+  class BinaryOutputStream;
+}
+
 
   ///	OKS method implementation class.
   /**
@@ -282,6 +287,9 @@ class OksMethod
     OksMethod (OksXmlInputStream &, OksClass*);
     void save(OksXmlOutputStream &) const;
 
+    OksMethod (oks::BinaryInputStream &, OksClass*);
+    void put(oks::BinaryOutputStream &) const;
+
 
       // valid xml tags and attributes
 
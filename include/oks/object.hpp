@@ -13,6 +13,7 @@
 #include "oks/defs.hpp"
 #include "oks/file.hpp"
 #include "oks/exceptions.hpp"
+#include "oks/arena.hpp"
 
 #include <stdint.h>
 
@@ -378,8 +379,8 @@ class OksString : public std::string {
     OksString	(const char * s, size_t n) : std::string(s,n) {;}
     OksString	(const std::string&s, std::string::size_type n) : std::string(s,0,n) {;}
 
-    void *      operator new(size_t) {return boost::fast_pool_allocator<OksString>::allocate();}
-    void        operator delete(void *ptr) {boost::fast_pool_allocator<OksString>::deallocate(reinterpret_cast<OksString*>(ptr));}
+    void *      operator new(size_t) {return oks::Arena::new_item<OksString>();}
+    void        operator delete(void *ptr) {oks::Arena::delete_item<OksString>(ptr);}
 };
 
 
@@ -430,11 +431,44 @@ operator<<(std::ostream& s, const OksString& str)
 }
 
 
+namespace oks {
+
+    /**
+     *  The pool of shared strings.
+     *  In the shared strings mode (see OksKernel::set_shared_strings_mode()) the data file loaders
+     *  use the pool to keep single copy of equal string values of attributes.
+     *  The strings of the pool are reference-counted: a string %is removed from the pool,
+     *  when it %is released by last user. The pool %is thread-safe and %is common for all kernels.
+     */
+
+  class SharedStrings {
+
+    public:
+
+        /** Return string equal to given one from the pool and increase its reference counter. **/
+      static OksString * get(const char * s, size_t len);
+
+        /** Decrease reference counter of the string and remove it from the pool, if the string %is not used anymore. **/
+      static void release(OksString * s);
+
+        /** Return number of strings in the pool. **/
+      static size_t size();
+
+  };
+
+}
+
+
   // forward declaration for private OKS structures declared in non-installing src/oks_utils.h
 
 namespace oks {
   struct ReloadObjects;    ///< the structure for efficient search of objects to be re-read or to be deleted during reload
   struct ReadFileParams;   ///< the structure to pass common parameters to various read() methods of OksData and OksObject class
+  class BinaryInputStream; ///< the stream to read binary snapshot of data file
+  class BinaryOutputStream;///< the stream to write binary snapshot of data file
+  struct BinaryClassInfo;  ///< the description of class stored in binary snapshot of data file
+  struct LazyBody;         ///< the not yet parsed body of object read in lazy objects mode
+  class DataVisitor;       ///< the visitor of objects stored in data file
 }
 
 
@@ -447,6 +481,9 @@ namespace oks {
      *  Members:
      *    enumeration 'type' is used to define data type in run-time
      *    union 'data' is used to represent such type
+     *
+     *  If the 'shared' flag %is set, the string_type value %is taken from the oks::SharedStrings pool;
+     *  such value %is shared with other data and must not be modified in place.
      */
 
 struct OksData {
@@ -481,6 +518,8 @@ struct OksData {
       enum_type		= 20
     } type;
 
+    bool shared;  ///< the string_type value is taken from the oks::SharedStrings pool
+
     union Data {
       int8_t		       S8_INT;
       uint8_t	               U8_INT;
@@ -534,14 +573,14 @@ struct OksData {
     OksData(const OksClass * c)                         {Clear2(); Set(c);}
     OksData(List *l)                                    {Clear2(); Set(l);}
     OksData(OksObject *o)                               {Clear2(); Set(o);}
-    OksData(const OksClass *c, const char * o)          {Clear(); Set(c, o);}
-    OksData(const OksClass *c, const OksString& o)      {Clear(); Set(c, o);}
+    OksData(const OksClass *c, const char * o)          {Clear2(); Set(c, o);}
+    OksData(const OksClass *c, const OksString& o)      {Clear2(); Set(c, o);}
     OksData(const std::string &c, const std::string &o) {Clear2(); Set(c, o);}
 
     ~OksData()                                          {Clear();}
 
     void Clear();
-    void Clear2()                                       {type = unknown_type;}
+    void Clear2()                                       {type = unknown_type; shared = false;}
 
     void Set(int8_t c)			                {Clear(); type = s8_int_type; data.S8_INT = c;}
     void Set(uint8_t c)			                {Clear(); type = u8_int_type; data.U8_INT = c;}
@@ -559,6 +598,7 @@ struct OksData {
     void Set(boost::gregorian::date d)                  {Clear(); type = date_type; SetFast(d);}
     void Set(boost::posix_time::ptime t)                {Clear(); type = time_type; SetFast(t);}
     void Set(OksString *s)		                {Clear(); type = string_type; data.STRING = s;}
+    void SetShared(const char *s, size_t len)           {Clear(); type = string_type; data.STRING = oks::SharedStrings::get(s, len); shared = true;}
     void Set(const char *s)		                {Clear(); type = string_type; data.STRING = new OksString(s);}
     void Set(const std::string &s)	                {Clear(); type = string_type; data.STRING = new OksString(s);}
     void Set(const OksString &s)	                {Clear(); type = string_type; data.STRING = new OksString(s);}
@@ -696,8 +736,14 @@ struct OksData {
     bool operator<(const OksData &) const;  //report incompatible data types
     bool operator>(const OksData &) const;  //report incompatible data types
     friend std::ostream& operator<<(std::ostream&, const OksData&);
-    void* operator new(size_t) {return boost::fast_pool_allocator<OksData>::allocate();}
-    void operator delete(void *ptr) {boost::fast_pool_allocator<OksData>::deallocate(reinterpret_cast<OksData*>(ptr));}
+
+      /** Return hash of value; equal values (see operator==) have equal hashes. **/
+    size_t hash() const noexcept;
+
+    void* operator new(size_t) {return oks::Arena::new_item<OksData>();}
+    void operator delete(void *ptr) {oks::Arena::delete_item<OksData>(ptr);}
+    void* operator new[](size_t size) {return oks::Arena::new_array(size);}
+    void operator delete[](void *ptr) {oks::Arena::delete_array(ptr);}
 
     void sort(bool ascending = true);
 
@@ -719,7 +765,7 @@ struct OksData {
 
     void read(const oks::ReadFileParams&, const OksAttribute *, int32_t);     // read mv attribute
     void read(const oks::ReadFileParams&, const OksAttribute *);              // read sv attribute
-    void read(const OksAttribute *, const OksXmlValue&);                      // read sv attribute for "data" format
+    void read(const OksAttribute *, const OksXmlValue&, bool = false);        // read sv attribute for "data" format (optionally using shared strings)
     void read(const OksAttribute *, const oks::ReadFileParams&);              // read mv attribute for "data" format
 
     void read(const oks::ReadFileParams&, const OksRelationship*, int32_t);   // read mv relationship
@@ -727,9 +773,13 @@ struct OksData {
     void read(const OksRelationship *, const OksXmlRelValue&);                // read sv relationship for "data" format
     void read(const OksRelationship *, const oks::ReadFileParams&);           // read mv relationship for "data" format
 
+    void read(oks::BinaryInputStream&, const OksAttribute *);                 // read attribute from binary snapshot
+    void read(oks::BinaryInputStream&, const OksRelationship *, OksObject *); // read relationship from binary snapshot
+    void write(oks::BinaryOutputStream&) const;                              // write to binary snapshot
+
     OksData(const oks::ReadFileParams& params, const OksAttribute * a, int32_t n) {Clear2(); read(params, a, n);}
     OksData(const oks::ReadFileParams& params, const OksAttribute * a) {Clear2(); read(params, a);}
-    OksData(const OksAttribute * a, const OksXmlValue& value) {Clear2(); read(a, value);}
+    OksData(const OksAttribute * a, const OksXmlValue& value, bool shared_strings = false) {Clear2(); read(a, value, shared_strings);}
     OksData(const OksAttribute * a, const oks::ReadFileParams& params) {Clear2(); read(a, params);}
 
     OksData(const oks::ReadFileParams& params, const OksRelationship *r, int32_t n) {Clear2(); read(params, r, n);}
@@ -843,10 +893,14 @@ class OksObject
   friend struct	OksData;
   friend class	OksKernel;
   friend class	OksIndex;
+  friend class	OksHashIndex;
+  friend class	OksCompositeIndex;
+  friend class	OksInvertedIndex;
   friend class	OksObjectSortBy;
   friend struct OksLoadObjectsJob;
   friend struct oks::ReadFileParams;
   friend struct oks::ReloadObjects;
+  friend struct RefData;
 
   public:
 
@@ -962,12 +1016,12 @@ class OksObject
 
       /** Fast new operator to reduce resources consumption. */
 
-    void * operator new(size_t) {return boost::fast_pool_allocator<OksObject>::allocate();}
+    void * operator new(size_t) {return oks::Arena::new_item<OksObject>();}
 
 
       /** Fast delete operator. */
 
-    void operator delete(void *ptr) {boost::fast_pool_allocator<OksObject>::deallocate(reinterpret_cast<OksObject*>(ptr));}
+    void operator delete(void *ptr) {oks::Arena::delete_item<OksObject>(ptr);}
 
 
       /**
@@ -1064,13 +1118,14 @@ class OksObject
        *  \return           the OKS data value for given attribute
        */
 
-    OksData * GetAttributeValue(const OksDataInfo *i) const noexcept { return &(data[i->offset]); }
+    OksData * GetAttributeValue(const OksDataInfo *i) const noexcept { materialize(); return &(data[i->offset]); }
 
 
       /**
        * \brief Get value of relationship by name.
        *
        *  The method returns pointer on OksData value for given relationship.
+       *  Since the value can be modified in place, the method drops reverse references index of kernel (see get_all_rels()).
        *
        *  In case of problems (e.g. no relationship with such name) the oks::exception is thrown.
        *
@@ -1090,6 +1145,7 @@ class OksObject
        *
        *  The method returns pointer on OksData value for given relationship offset.
        *  The method is optimised for performance and does not check validity of offset.
+       *  Since the value can be modified in place, the method drops reverse references index of kernel (see get_all_rels()).
        *
        *  The parameter is:
        *  \param data_info  describes offset of relationship's value for given OKS class
@@ -1097,7 +1153,7 @@ class OksObject
        *  \return           the OKS data value for given relationship
        */
 
-    OksData * GetRelationshipValue(const OksDataInfo *i) const noexcept { return &(data[i->offset]); }
+    OksData * GetRelationshipValue(const OksDataInfo *i) const noexcept { materialize(); drop_reverse_refs(); return &(data[i->offset]); }
 
 
       /**
@@ -1320,8 +1376,11 @@ class OksObject
        *
        *  The method returns list of objects which have a reference on given one.
        *  If the relationship name is set to "*", then the method takes into account  all relationships of all objects.
-       *  The method performs full scan of all OKS objects and it is not recommended at large scale to build complete graph of relations between all database object;
-       *  if only composite parents are needed, them the reverse_composite_rels() method has to be used.
+       *  The method uses reverse references index of kernel; the index is built by full scan of all OKS objects on first call after
+       *  loading, binding or closing of data files, after schema changes and after GetRelationshipValue() calls (the returned value
+       *  can be modified in place), and it is updated by relationship set methods afterwards.
+       *  The pointer returned by GetRelationshipValue() must not be used to modify the value after get_all_rels() or destroy() calls.
+       *  If only composite parents are needed, them the reverse_composite_rels() method has to be used.
        *
        *  The parameters are:
        *  \param  name    the name of relationship used to reference given object (by default ANY relationship)
@@ -1408,6 +1467,7 @@ class OksObject
     } uid;
 
     OksData * data;
+    oks::LazyBody * p_lazy;
     std::list<OksRCR *> * p_rcr;
     mutable void * p_user_data;
     int32_t p_int32_id;
@@ -1438,6 +1498,13 @@ class OksObject
 
     void read_body(const oks::ReadFileParams&, bool);
 
+
+      // read object from data file in normal format and pass its values to visitor without creation of object;
+      // return false, if there are no more objects
+
+    static bool visit(const oks::ReadFileParams&, oks::DataVisitor&);
+    static void visit_values(OksXmlInputStream&, oks::DataVisitor&, bool, bool);
+
     /**
      *  Construct OKS object from input stream.
      *  \throw oks::exception is thrown in case of errors.
@@ -1445,6 +1512,35 @@ class OksObject
     OksObject (const oks::ReadFileParams&, OksClass *, const std::string&);
 
 
+      // read body of object created in lazy objects mode on first access to its data;
+      // the concurrent first access is serialized, the object keeps default values if the body cannot be read
+
+    void materialize() const { if( __builtin_expect((p_lazy != nullptr), 0) ) read_lazy_body(); }
+    void read_lazy_body() const;
+    bool is_read() const noexcept;
+    static bool can_read_lazy(const OksClass *);
+
+
+      // get value of relationship keeping reverse references index; it is used by methods which do not modify references
+
+    OksData * get_relationship_value(const OksDataInfo *i) const noexcept { materialize(); return &(data[i->offset]); }
+    OksData * get_relationship_value(const std::string& name) const;
+
+    void drop_reverse_refs() const noexcept;
+
+
+      /**
+       *  Read OKS object from binary snapshot of data file.
+       *
+       *  \return The method returns a pointer to OksObject, or NULL object to indicate end-of-stream.
+       *  \throw oks::exception is thrown in case of errors, e.g. bad input stream, duplicated object, abstract class of object.
+       **/
+
+    static OksObject * read(oks::BinaryInputStream&, OksFile *);
+    void read_body(oks::BinaryInputStream&, const oks::BinaryClassInfo&);
+    OksObject (oks::BinaryInputStream&, const oks::BinaryClassInfo&, const std::string&, OksFile *);
+
+
 
       // to be used by OksIndex only
 
@@ -1491,6 +1587,7 @@ class OksObject
     void set_unique_id();
     void put(OksXmlOutputStream&, bool force_defaults) const;
     static void put_object_attributes(OksXmlOutputStream&, const OksData&);
+    void put(oks::BinaryOutputStream&) const;
 
       // bind data and methods
 
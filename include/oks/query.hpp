@@ -71,6 +71,7 @@ class OksQuery
     static const char *	 GE;
     static const char *	 LS;
     static const char *	 GT;
+    static const char *	 CT;
     static const char *	 PATH_TO;
     static const char *	 DIRECT;
     static const char *	 NESTED;
@@ -82,6 +83,7 @@ class OksQuery
     static bool less_cmp(const OksData *, const OksData *);
     static bool greater_cmp(const OksData *, const OksData *);
     static bool reg_exp_cmp(const OksData *, const OksData * regexp);
+    static bool contains_cmp(const OksData *, const OksData * item);
 
     typedef bool (*Comparator)(const OksData *, const OksData *);
 
@@ -19,6 +19,11 @@ class	OksClass;
 class   OksXmlOutputStream;
 class   OksXmlInputStream;
 
+namespace oks {
+  class BinaryInputStream;
+  class BinaryOutputStream;
+}
+
   /// @addtogroup oks
 
 
@@ -373,6 +378,8 @@ class OksRelationship
 
     OksRelationship	  (OksXmlInputStream&, OksClass*); /// private constructor from XML stream
     void                  save(OksXmlOutputStream&) const; /// private method to save in XML stream
+    OksRelationship	  (oks::BinaryInputStream&, OksClass*); /// private constructor from schema image
+    void                  put(oks::BinaryOutputStream&) const; /// private method to save in schema image
 
 
 
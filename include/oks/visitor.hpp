@@ -0,0 +1,85 @@
+/**
+ *  \file oks/visitor.h
+ *
+ *  This file is part of the OKS package.
+ *
+ *  This file contains the declarations of the visitor used to stream through OKS data files.
+ */
+
+#ifndef OKS_VISITOR_H
+#define OKS_VISITOR_H
+
+#include <stddef.h>
+
+class OksFile;
+
+namespace oks {
+
+    /**
+     *  \brief The visitor of objects stored in OKS data file.
+     *
+     *  The visitor %is used by the OksKernel::visit_data() method to walk through objects of data file
+     *  without creation of OKS objects: the methods are called in the order of objects, attributes and
+     *  relationships stored in the file. The default implementation of all methods does nothing.
+     *
+     *  The values of attributes are passed as they are stored in the file (i.e. decimal, hexadecimal or octal
+     *  numbers, ISO dates, etc.). A null relationship value %is passed with empty class name and identity.
+     *
+     *  The pointers passed to the methods are valid only during the call.
+     */
+
+  class DataVisitor {
+
+    public:
+
+      virtual ~DataVisitor() { ; }
+
+
+        /** Called after the header of data file %is read. **/
+
+      virtual void begin_file(const OksFile&) { ; }
+
+
+        /** Called for every object. Return false to skip attributes and relationships of the object. **/
+
+      virtual bool begin_object(const char * /*class_name*/, const char * /*id*/) { return true; }
+
+
+        /** Called for single-value attribute. **/
+
+      virtual void attribute(const char * /*name*/, const char * /*type*/, const char * /*value*/, size_t /*len*/) { ; }
+
+
+        /** Called for multi-value attribute: begin, then each value, then end. **/
+
+      virtual void begin_multi_value_attribute(const char * /*name*/, const char * /*type*/) { ; }
+      virtual void attribute_value(const char * /*value*/, size_t /*len*/) { ; }
+      virtual void end_multi_value_attribute() { ; }
+
+
+        /** Called for single-value relationship. **/
+
+      virtual void relationship(const char * /*name*/, const char * /*class_name*/, const char * /*id*/) { ; }
+
+
+        /** Called for multi-value relationship: begin, then each value, then end. **/
+
+      virtual void begin_multi_value_relationship(const char * /*name*/) { ; }
+      virtual void relationship_value(const char * /*class_name*/, const char * /*id*/) { ; }
+      virtual void end_multi_value_relationship() { ; }
+
+
+        /** Called after the last attribute or relationship of object; is not called for skipped objects. **/
+
+      virtual void end_object() { ; }
+
+
+        /** Called after the last object of data file. **/
+
+      virtual void end_file() { ; }
+
+  };
+
+}
+
+#endif
@@ -3,10 +3,15 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <charconv>
 #include <memory>
 #include <stack>
 #include <fstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "oks/defs.hpp"
 #include "oks/exceptions.hpp"
@@ -24,6 +29,22 @@ namespace oks {
       /** Converts string literal to boolean **/
     inline bool str2bool(const char * s) noexcept { return oks::cmp_str3(s, "yes"); }
 
+
+      /**
+       *  Return pointer to first symbol in [begin, end) equal to any of n (n <= 8) symbols from set, or end if there is no such symbol.
+       *  The implementation using AVX2, SSE2 or scalar instructions %is selected at run time depending on the processor.
+       */
+
+    extern const char * (* const find_first_of)(const char * begin, const char * end, const char * set, size_t n);
+
+
+      /**
+       *  Return pointer to first symbol in [begin, end) not equal to any of n (n <= 8) symbols from set, or end if there is no such symbol.
+       *  The implementation %is selected at run time in the same way as for find_first_of().
+       */
+
+    extern const char * (* const find_first_not_of)(const char * begin, const char * end, const char * set, size_t n);
+
   }
 
     /** Bad file exception. **/
@@ -103,6 +124,77 @@ namespace oks {
   };
 
   struct ReadFileParams;
+
+
+    /**
+     *  The read-only memory-mapped file.
+     *  It %is used by the zero-copy input mode of the OksXmlInputStream.
+     */
+
+  class MappedFile {
+
+    public:
+
+        /** Map file into memory. \throw std::runtime_error if failed **/
+      MappedFile(const std::string& file_name);
+
+        /** Keep in memory content which cannot be mapped (e.g. decompressed content of file). **/
+      MappedFile(std::string&& content) : m_data(nullptr), m_size(content.size()), m_content(std::move(content)) { if(m_size) m_data = m_content.data(); }
+
+      ~MappedFile();
+
+      const char * data() const noexcept { return m_data; }
+      size_t size() const noexcept { return m_size; }
+
+
+    private:
+
+      const char * m_data;
+      size_t m_size;
+      std::string m_content;
+
+
+        // protect usage of copy constructor and assignment operator
+
+      MappedFile(const MappedFile&);
+      MappedFile& operator=(const MappedFile&);
+
+  };
+
+
+    /**
+     *  The 64-bit checksum of a sequence of bytes.
+     *  The sequence can be passed by several blocks; the result does not depend on how it %is split.
+     *  It %is used to detect changes of saved files and it %is not intended for cryptographic purposes.
+     */
+
+  class Checksum {
+
+    public:
+
+      Checksum() noexcept : m_value(0xcbf29ce484222325ULL), m_len(0), m_tail_len(0) { ; }
+
+        /** Append block of bytes. **/
+      void update(const char * data, size_t len) noexcept;
+
+        /** Return checksum of bytes passed so far. **/
+      uint64_t value() const noexcept;
+
+        /** Return number of bytes passed so far. **/
+      uint64_t length() const noexcept { return m_len; }
+
+        /** Return checksum of given block of bytes. **/
+      static uint64_t calculate(const char * data, size_t len) noexcept { Checksum c; c.update(data, len); return c.value(); }
+
+
+    private:
+
+      uint64_t m_value;
+      uint64_t m_len;
+      char m_tail[sizeof(uint64_t)];
+      size_t m_tail_len;
+
+  };
 }
 
 
@@ -111,17 +203,85 @@ class OksXmlOutputStream
 
 public:
 
-  OksXmlOutputStream(std::ostream &p) : f(p)
+  /**
+   *  The output %is formatted into a buffer owned by the object and %is written to the stream by large blocks,
+   *  when the buffer %is full or when flush() %is called. The destructor flushes the buffer ignoring errors,
+   *  so flush() has to be called explicitly to detect write problems.
+   */
+
+  OksXmlOutputStream(std::ostream &p) : f(p), m_buf(new char[s_buffer_size]), m_ptr(m_buf.get()), m_end(m_buf.get() + s_buffer_size), m_base(10)
   {
     ;
   }
 
+  ~OksXmlOutputStream()
+  {
+    try
+      {
+        flush();
+      }
+    catch (...)
+      {
+        ;
+      }
+  }
+
+  /**
+   *  Return output stream. The buffered symbols are written to the stream before.
+   *  \throw std::exception if failed
+   */
   std::ostream&
-  get_stream() const
+  get_stream()
   {
+    flush();
     return f;
   }
 
+  /**
+   *  Write buffered symbols to the stream.
+   *  \throw std::exception if failed
+   */
+  void
+  flush();
+
+  /**
+   *  Start calculation of checksum of symbols written after this call.
+   *  Several checksums can be calculated at the same time, e.g. of whole file and of its part.
+   *  The buffered symbols are written to the stream before.
+   *  \return index of the checksum used by suspend_checksum() and get_checksum()
+   *  \throw std::exception if failed
+   */
+  size_t
+  start_checksum()
+  {
+    flush();
+    m_checksums.emplace_back(oks::Checksum(), true);
+    return (m_checksums.size() - 1);
+  }
+
+  /**
+   *  Suspend or resume calculation of checksum, e.g. to exclude symbols which do not describe contents (like timestamps).
+   *  \throw std::exception if failed
+   */
+  void
+  suspend_checksum(size_t idx, bool suspend)
+  {
+    flush();
+    m_checksums[idx].second = !suspend;
+  }
+
+  /**
+   *  Return checksum of symbols written since start_checksum() returned given index.
+   *  The buffered symbols are written to the stream before.
+   *  \throw std::exception if failed
+   */
+  uint64_t
+  get_checksum(size_t idx)
+  {
+    flush();
+    return m_checksums[idx].first.value();
+  }
+
   /**
    *  Write char to xml output stream. Convert special symbols.
    *  \throw std::exception if failed
@@ -143,24 +303,74 @@ public:
   void
   put_raw(char c)
   {
-    if (__builtin_expect((f.rdbuf()->sputc(c) != c), 0))
-      __throw_write_failed();
+    if (__builtin_expect((m_ptr == m_end), 0))
+      flush();
+
+    *m_ptr++ = c;
   }
 
   void
   put_raw(const char * s, long len)
   {
-    if (__builtin_expect((f.rdbuf()->sputn(s, len) != len), 0))
-      __throw_write_failed();
+    if (__builtin_expect((m_end - m_ptr < len), 0))
+      {
+        put_raw_block(s, len);
+      }
+    else
+      {
+        memcpy(m_ptr, s, len);
+        m_ptr += len;
+      }
+  }
+
+  /**
+   *  Set base (8, 10 or 16) used to write integer numbers.
+   *  Non-zero octal and hexadecimal numbers are written with "0" and "0x" prefixes.
+   */
+  void
+  set_base(int base)
+  {
+    m_base = base;
   }
 
   template<class T>
     void
     put_value(T value)
     {
-      f << value;
+      char buf[32];
+      char * ptr = buf;
+
+      if (__builtin_expect((m_base == 10), 1))
+        {
+          ptr = std::to_chars(buf, buf + sizeof(buf), value).ptr;
+        }
+      else
+        {
+          const typename std::make_unsigned<T>::type v(value);
+
+          if (v != 0)
+            {
+              *ptr++ = '0';
+              if (m_base == 16)
+                *ptr++ = 'x';
+            }
+
+          ptr = std::to_chars(ptr, buf + sizeof(buf), v, m_base).ptr;
+        }
+
+      put_raw(buf, ptr - buf);
     }
 
+  /**
+   *  Write floating point numbers with std::numeric_limits<T>::digits10 significant digits.
+   *  \throw std::exception if failed
+   */
+  void
+  put_value(float value);
+
+  void
+  put_value(double value);
+
   void
   put_quoted(const char *);
 
@@ -187,7 +397,17 @@ public:
 
 private:
 
+  static const long s_buffer_size = 256 * 1024;
+
   std::ostream& f;
+  std::unique_ptr<char[]> m_buf;
+  char * m_ptr;
+  char * m_end;
+  int m_base;
+  std::vector<std::pair<oks::Checksum, bool>> m_checksums; // the checksums and their calculation status
+
+  void
+  put_raw_block(const char * s, long len);
 
   static void
   __throw_write_failed();
@@ -215,6 +435,19 @@ struct OksXmlToken {
     }
   }
 
+    // make sure len symbols can be appended at pos
+
+  void reserve(size_t pos, size_t len) {
+    if( __builtin_expect((pos + len >= m_len2), 0) ) {
+      m_len = ((pos + len + 2) / 2048 + 1) * 2048;
+      m_len2 = m_len-2;
+      char *ptr = new char [m_len];
+      memcpy(ptr, m_buf, pos);
+      delete [] m_buf;
+      m_buf = ptr;
+    }
+  }
+
 };
 
 
@@ -364,7 +597,33 @@ friend class  OksObject;
 public:
 
   OksXmlInputStream(std::shared_ptr<std::istream> p) :
-    f(p), m_pbuf(p->rdbuf()), line_no(1), line_pos(0)
+    f(p), m_pbuf(p->rdbuf()), m_ptr(nullptr), m_end(nullptr), line_no(1), line_pos(0)
+  {
+    init();
+  };
+
+
+    /**
+     *  Read the stream from memory-mapped file.
+     *  Symbols are taken directly from mapped memory avoiding std::streambuf calls;
+     *  the tokens are copied by blocks and only the encoded symbols are converted one by one.
+     */
+
+  OksXmlInputStream(std::shared_ptr<oks::MappedFile> m) :
+    m_mapped(m), m_pbuf(nullptr), m_ptr(m->data()), m_end(m->data() + m->size()), line_no(1), line_pos(0)
+  {
+    init();
+  };
+
+
+    /**
+     *  Read part [begin, end) of memory-mapped file.
+     *  The begin_line_no and begin_line_pos are the line number and position of the begin symbol
+     *  used to report correct position of errors.
+     */
+
+  OksXmlInputStream(std::shared_ptr<oks::MappedFile> m, size_t begin, size_t end, unsigned long begin_line_no, unsigned long begin_line_pos) :
+    m_mapped(m), m_pbuf(nullptr), m_ptr(m->data() + begin), m_end(m->data() + end), line_no(begin_line_no), line_pos(begin_line_pos)
   {
     init();
   };
@@ -379,30 +638,79 @@ public:
 
 
     // get token separated by whitespace or "last" symbol
-    // put result on m_cvt_char token
+    // put result on m_cvt_char token and return its length
 
-  void get_num_token(char last);
-
-
-    // throw exception
-
-  static void __throw_strto(const char * f, const char * where, const char * what, unsigned long line_no, unsigned long line_pos);
+  size_t get_num_token(char last);
 
   size_t get_quoted();
 
   const char * get_tag();
   const char * get_tag_start();
 
-  bool good() const { return f->good(); }
-  bool eof() const { return f->eof(); }
+  bool good() const { return (m_mapped ? (m_ptr < m_end) : f->good()); }
+  bool eof() const { return (m_mapped ? (m_ptr >= m_end) : f->eof()); }
+
+  bool is_mapped() const { return (m_mapped != nullptr); }
+
+  const std::shared_ptr<oks::MappedFile>& get_mapped_file() const { return m_mapped; }
+
+
+    /**
+     *  Skip empty symbols and return true, if the end of mapped stream %is reached.
+     */
+
+  bool at_end() {
+    static const char __spaces[4] = { ' ', '\n', '\r', '\t' };
+    skip_mapped(oks::xml::find_first_not_of(m_ptr, m_end, __spaces, 4));
+    return (m_ptr == m_end);
+  }
+
+
+    /**
+     *  Move position of mapped stream past the end tag of element, which start tag was just read.
+     *  Return false and do not move, if the start tag %is closed by "/>" or there %is no end tag.
+     */
+
+  bool skip_element(const char * end_tag, size_t len) {
+    if(m_ptr[-1] != '>') return false;
+    const char * p = static_cast<const char *>(memmem(m_ptr, m_end - m_ptr, end_tag, len));
+    if(p == nullptr) return false;
+    skip_mapped(p + len);
+    return true;
+  }
+
+    /**
+     *  Copy up to len symbols following current position to buffer without changing the position.
+     *  Return number of copied symbols.
+     */
+
+  size_t peek(char * buf, size_t len) {
+    if(m_mapped) {
+      len = std::min(len, static_cast<size_t>(m_end - m_ptr));
+      memcpy(buf, m_ptr, len);
+      return len;
+    }
+
+    const std::streamsize n(m_pbuf->sgetn(buf, len));
+    if(n > 0) m_pbuf->pubseekoff(-n, std::ios_base::cur, std::ios_base::in);
+    return (n > 0 ? n : 0);
+  }
+
+  void store_position() {
+    if(m_mapped) m_ptr_sav = m_ptr; else pos = f->tellg();
+    m_line_no_sav = line_no; m_line_pos_sav = line_pos;
+  }
+
+  void restore_position() {
+    if(m_mapped) m_ptr = m_ptr_sav; else f->seekg(pos);
+    line_no = m_line_no_sav; line_pos = m_line_pos_sav;
+  }
 
-  void store_position() { pos = f->tellg(); m_line_no_sav = line_no; m_line_pos_sav = line_pos; }
-  void restore_position() { f->seekg(pos); line_no = m_line_no_sav; line_pos = m_line_pos_sav; }
   long get_position() const {
-    return f->tellg();
+    return (m_mapped ? static_cast<long>(m_ptr - m_mapped->data()) : static_cast<long>(f->tellg()));
   }
 
-  void inline seek_position(std::streamoff off) { f->seekg(off, std::ios_base::cur); }
+  void inline seek_position(std::streamoff off) { if(m_mapped) m_ptr += off; else f->seekg(off, std::ios_base::cur); }
 
   std::ostream&	error_msg(const char *);
 
@@ -426,7 +734,11 @@ public:
 private:
 
   std::shared_ptr<std::istream> f;
+  std::shared_ptr<oks::MappedFile> m_mapped;
   std::streambuf * m_pbuf;
+  const char * m_ptr;      // current position in mapped file
+  const char * m_end;      // end of mapped file
+  const char * m_ptr_sav;
   unsigned long	line_no;
   unsigned long	line_pos;
   
@@ -446,8 +758,10 @@ private:
 
 
   void init() {
-    f->setf(std::ios::showbase, std::ios::basefield);
-    f->exceptions ( std::istream::eofbit | std::istream::failbit | std::istream::badbit );
+    if(!m_mapped) {
+      f->setf(std::ios::showbase, std::ios::basefield);
+      f->exceptions ( std::istream::eofbit | std::istream::failbit | std::istream::badbit );
+    }
 
     std::lock_guard lock(s_tokens_pool.m_mutex);
     m_cvt_char = s_tokens_pool.get();
@@ -463,6 +777,11 @@ private:
 
   inline char get_first_non_empty();
   inline char get();
+  inline void unget();
+
+  inline const char * scan_mapped(const char s1) const;                                                                      /*!< Find separator or '&' in mapped file */
+  inline size_t copy_mapped(OksXmlToken& token, size_t pos, const char * to);                                                /*!< Copy mapped symbols into token     */
+  inline void skip_mapped(const char * to);                                                                                  /*!< Skip mapped symbols                */
 
   inline unsigned long get_value_pre();
   inline void get_value_post(unsigned long);
@@ -486,15 +805,86 @@ private:
 inline char
 OksXmlInputStream::get()
 {
-  char c(m_pbuf->sbumpc());
+  char c;
+
+  if(m_mapped) {
+    line_pos++;
+    if( __builtin_expect((m_ptr == m_end), 0) ) __throw_eof();
+    c = *m_ptr++;
+  }
+  else {
+    c = m_pbuf->sbumpc();
+    line_pos++;
+    if( __builtin_expect((c == EOF), 0) ) __throw_eof();
+  }
 
-  line_pos++;
-  if( __builtin_expect((c == EOF), 0) ) __throw_eof();
-  else if( __builtin_expect((c == '\n'), 0) ) { line_no++; line_pos = 0; }
+  if( __builtin_expect((c == '\n'), 0) ) { line_no++; line_pos = 0; }
 
   return c;
 }
 
+inline void
+OksXmlInputStream::unget()
+{
+  if(m_mapped) m_ptr--;
+  else f->unget();
+}
+
+
+    //
+    // Return pointer to first separator or '&' symbol in mapped file
+    // (or end of file, if there are no such symbols)
+    //
+
+inline const char *
+OksXmlInputStream::scan_mapped(const char s1) const
+{
+  const char set[2] = { s1, '&' };
+  return oks::xml::find_first_of(m_ptr, m_end, set, 2);
+}
+
+
+    //
+    // Copy symbols from current position of mapped file till given one into token;
+    // change LINE and POS numbers and return new length of token
+    //
+
+inline size_t
+OksXmlInputStream::copy_mapped(OksXmlToken& token, size_t pos, const char * to)
+{
+  const size_t len(to - m_ptr);
+
+  if(len) {
+    token.reserve(pos, len);
+    memcpy(token.m_buf + pos, m_ptr, len);
+    skip_mapped(to);
+  }
+
+  return pos + len;
+}
+
+
+    //
+    // Move current position of mapped file till given one;
+    // change LINE and POS numbers
+    //
+
+inline void
+OksXmlInputStream::skip_mapped(const char * to)
+{
+  const size_t len(to - m_ptr);
+
+  if(const char * nl = static_cast<const char *>(memrchr(m_ptr, '\n', len))) {
+    line_no += std::count(m_ptr, nl + 1, '\n');
+    line_pos = to - nl - 1;
+  }
+  else {
+    line_pos += len;
+  }
+
+  m_ptr = to;
+}
+
 
     //
     // Read first non-null xml symbol
@@ -504,6 +894,11 @@ OksXmlInputStream::get()
 inline char
 OksXmlInputStream::get_first_non_empty()
 {
+  if(m_mapped) {
+    static const char __spaces[4] = { ' ', '\n', '\r', '\t' };
+    skip_mapped(oks::xml::find_first_not_of(m_ptr, m_end, __spaces, 4));
+  }
+
   while(true) {
     char c(get());
     if(c == ' ' || c == '\n' || c == '\r' || c == '\t') continue;
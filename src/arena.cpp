@@ -0,0 +1,168 @@
+#define _OksBuildDll_
+
+#include "oks/arena.hpp"
+
+#include <sys/mman.h>
+
+#include <mutex>
+#include <vector>
+
+namespace oks {
+
+    // the size of virtual memory region reserved for all arenas
+
+  static const size_t s_region_size = size_t(64) * 1024 * 1024 * 1024;
+
+    // the number of items counted for an arena using the chunk; prevents release of chunk
+    // until the arena retires it and adds real number of items allocated in the chunk
+
+  static const uint32_t s_arena_hold = 0x80000000;
+
+    // the state of region shared by all arenas
+
+  struct ArenaRegion {
+    std::once_flag m_init;
+    std::mutex m_mutex;                        // protects m_free_chunks and m_next_chunk
+    char * m_base = nullptr;
+    size_t m_num_of_chunks = 0;
+    std::atomic<uint32_t> * m_counters = nullptr;  // number of not freed items per chunk
+    std::vector<uint32_t> m_free_chunks;       // chunks returned to the system, which can be reused
+    uint32_t m_next_chunk = 0;                 // first chunk not used yet
+    std::atomic<size_t> m_chunks_in_use {0};
+
+    void init() noexcept;
+  };
+
+  void
+  ArenaRegion::init() noexcept
+  {
+    void * p = mmap(nullptr, s_region_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (p != MAP_FAILED)
+      {
+        m_base = static_cast<char *>(p);
+        m_num_of_chunks = s_region_size / Arena::chunk_size;
+        m_counters = new std::atomic<uint32_t>[m_num_of_chunks];
+        Arena::s_base.store(reinterpret_cast<uintptr_t>(p), std::memory_order_relaxed);
+        Arena::s_size.store(s_region_size, std::memory_order_relaxed);
+      }
+  }
+
+    // the region is never destroyed, since items may be freed by objects destroyed on exit
+
+  static ArenaRegion&
+  arena_region()
+  {
+    static ArenaRegion * region = new ArenaRegion();
+    return *region;
+  }
+
+  static char *
+  take_chunk(ArenaRegion& r, uint32_t& idx) noexcept
+  {
+    std::call_once(r.m_init, [&r]() { r.init(); });
+
+    if (r.m_base == nullptr)
+      return nullptr;
+
+    std::lock_guard lock(r.m_mutex);
+
+    if (!r.m_free_chunks.empty())
+      {
+        idx = r.m_free_chunks.back();
+        r.m_free_chunks.pop_back();
+      }
+    else
+      {
+        if (r.m_next_chunk == r.m_num_of_chunks)
+          return nullptr;
+
+        if (mprotect(r.m_base + r.m_next_chunk * Arena::chunk_size, Arena::chunk_size, PROT_READ | PROT_WRITE) != 0)
+          return nullptr;
+
+        idx = r.m_next_chunk++;
+      }
+
+    r.m_counters[idx].store(s_arena_hold, std::memory_order_relaxed);
+    r.m_chunks_in_use++;
+
+    return r.m_base + idx * Arena::chunk_size;
+  }
+
+  static void
+  free_chunk(ArenaRegion& r, uint32_t idx) noexcept
+  {
+      // return memory to the system; the pages remain mapped and are zero-filled on next use
+
+    madvise(r.m_base + idx * Arena::chunk_size, Arena::chunk_size, MADV_DONTNEED);
+
+    std::lock_guard lock(r.m_mutex);
+    r.m_free_chunks.push_back(idx);
+    r.m_chunks_in_use--;
+  }
+
+  void *
+  Arena::allocate(size_t size) noexcept
+  {
+    size = (size + 7) & ~size_t(7);
+
+    if (size > chunk_size / 8)
+      return nullptr;
+
+    if (static_cast<size_t>(m_end - m_ptr) < size)
+      {
+        retire();
+
+        if ((m_ptr = take_chunk(arena_region(), m_chunk)) == nullptr)
+          return nullptr;
+
+        m_end = m_ptr + chunk_size;
+      }
+
+    void * p = m_ptr;
+    m_ptr += size;
+    m_count++;
+
+    return p;
+  }
+
+  void
+  Arena::retire() noexcept
+  {
+    if (m_end)
+      {
+        ArenaRegion& r(arena_region());
+
+        const uint32_t n = s_arena_hold - m_count;
+
+        if (r.m_counters[m_chunk].fetch_sub(n, std::memory_order_acq_rel) == n)
+          free_chunk(r, m_chunk);
+
+        m_ptr = m_end = nullptr;
+        m_count = 0;
+      }
+  }
+
+  Arena::~Arena()
+  {
+    retire();
+  }
+
+  void
+  Arena::release(void * p) noexcept
+  {
+    ArenaRegion& r(arena_region());
+
+    const uint32_t idx = (static_cast<char *>(p) - r.m_base) / chunk_size;
+
+    if (r.m_counters[idx].fetch_sub(1, std::memory_order_acq_rel) == 1)
+      free_chunk(r, idx);
+  }
+
+  size_t
+  Arena::chunks_in_use() noexcept
+  {
+    return arena_region().m_chunks_in_use;
+  }
+
+}
@@ -14,6 +14,8 @@
 
 #include <string.h>
 
+#include "oks_utils.h"
+
 
 const char * OksAttribute::bool_type	= "bool";
 const char * OksAttribute::s8_int_type	= "s8";
@@ -463,6 +465,47 @@ OksAttribute::OksAttribute(OksXmlInputStream& s, OksClass *parent) :
 }
 
 
+OksAttribute::OksAttribute(oks::BinaryInputStream& s, OksClass *parent) :
+  p_name           (s.get_string()),
+  p_range          (s.get_string()),
+  p_data_type      (OksData::unknown_type),
+  p_multi_values   (s.get<uint8_t>()),
+  p_no_null	   (s.get<uint8_t>()),
+  p_init_value     (s.get_string()),
+  p_format         (static_cast<Format>(s.get<uint8_t>())),
+  p_description    (s.get_string()),
+  p_class          (parent),
+  p_enumerators    (nullptr),
+  p_range_obj      (nullptr),
+  p_ordered        (s.get<uint8_t>())
+{
+  const std::string& t(s.get_string());
+  __set_data_type(t.c_str(), t.size());
+
+  if (p_data_type == OksData::unknown_type)
+    s.throw_bad_data("bad attribute type");
+
+    // the values were validated when the image was created from xml file
+
+  init_enum();
+  init_range();
+}
+
+void
+OksAttribute::put(oks::BinaryOutputStream& s) const
+{
+  s.put(p_name);
+  s.put(p_range);
+  s.put(static_cast<uint8_t>(p_multi_values));
+  s.put(static_cast<uint8_t>(p_no_null));
+  s.put(p_init_value);
+  s.put(static_cast<uint8_t>(p_format));
+  s.put(p_description);
+  s.put(static_cast<uint8_t>(p_ordered));
+  s.put(get_type());
+}
+
+
 OksData::Type
 OksAttribute::get_data_type(const std::string& t) noexcept
 {
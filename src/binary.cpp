@@ -0,0 +1,287 @@
+#define _OksBuildDll_
+
+#include "oks/xml.hpp"
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/attribute.hpp"
+#include "oks/relationship.hpp"
+#include "oks/object.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#include "oks_utils.h"
+
+namespace oks {
+
+  const char BinaryFormat::magic[8] = { 'O', 'K', 'S', '-', 'B', 'I', 'N', '\0' };
+
+    // the version is incremented on any change of layout, so images written by older code are rejected
+
+  const uint32_t BinaryFormat::version = 1;
+  const uint32_t BinaryFormat::byte_order_mark = 0x01020304;
+
+
+  bool
+  BinaryFormat::test(const std::string& file_name) noexcept
+  {
+    char buf[sizeof(magic)];
+
+    std::ifstream f(file_name.c_str(), std::ios::binary);
+
+    if (!f.read(buf, sizeof(buf)))
+      return false;
+
+    return test(buf, sizeof(buf));
+  }
+
+  uint64_t
+  BinaryFormat::hash(const char * data, size_t len) noexcept
+  {
+      // FNV-1a like mixing of 8-byte words followed by tail bytes
+
+    const uint64_t prime(0x100000001b3ULL);
+    uint64_t h(0xcbf29ce484222325ULL ^ len);
+
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), data += sizeof(uint64_t))
+      {
+        uint64_t w;
+        memcpy(&w, data, sizeof(w));
+        h = (h ^ w) * prime;
+        h ^= (h >> 29);
+      }
+
+    for (; len; --len, ++data)
+      h = (h ^ static_cast<uint8_t>(*data)) * prime;
+
+    return (h ^ (h >> 32));
+  }
+
+
+  uint32_t
+  BinaryOutputStream::string_index(const std::string& s)
+  {
+    auto x = m_strings_idx.emplace(s, m_strings.size());
+
+    if (x.second)
+      m_strings.push_back(&x.first->first);
+
+    return x.first->second;
+  }
+
+  void
+  BinaryOutputStream::put(const OksClass * c)
+  {
+    auto x = m_classes_idx.emplace(c, m_classes.size());
+
+    if (x.second)
+      m_classes.push_back(c);
+
+    put(x.first->second);
+  }
+
+  void
+  BinaryOutputStream::flush(std::ostream& s)
+  {
+      // put table of classes first, since it adds names of attributes and relationships to the table of strings
+
+    std::string data;
+    data.swap(m_data);
+
+    put(static_cast<uint32_t>(m_classes.size()));
+
+    for (const auto& c : m_classes)
+      {
+        put(c->get_name());
+
+        if (const std::list<OksAttribute *> * alist = c->all_attributes())
+          {
+            put(static_cast<uint32_t>(alist->size()));
+
+            for (const auto& a : *alist)
+              {
+                put(a->get_name());
+                put(static_cast<uint8_t>(a->get_data_type()));
+                put(static_cast<uint8_t>(a->get_is_multi_values()));
+              }
+          }
+        else
+          {
+            put(static_cast<uint32_t>(0));
+          }
+
+        if (const std::list<OksRelationship *> * rlist = c->all_relationships())
+          {
+            put(static_cast<uint32_t>(rlist->size()));
+
+            for (const auto& r : *rlist)
+              {
+                put(r->get_name());
+                put(static_cast<uint8_t>(r->get_high_cardinality_constraint()));
+                put(static_cast<uint8_t>(r->get_high_cardinality_constraint() == OksRelationship::Many));
+              }
+          }
+        else
+          {
+            put(static_cast<uint32_t>(0));
+          }
+      }
+
+    m_data.swap(data);
+
+    s.write(BinaryFormat::magic, sizeof(BinaryFormat::magic));
+    s.write(reinterpret_cast<const char *>(&BinaryFormat::version), sizeof(BinaryFormat::version));
+    s.write(reinterpret_cast<const char *>(&BinaryFormat::byte_order_mark), sizeof(BinaryFormat::byte_order_mark));
+
+    const uint32_t source_len = m_source.size();
+    s.write(reinterpret_cast<const char *>(&source_len), sizeof(source_len));
+    s.write(m_source.data(), source_len);
+
+    const uint32_t num = m_strings.size();
+    s.write(reinterpret_cast<const char *>(&num), sizeof(num));
+
+    for (const auto& x : m_strings)
+      {
+        const uint32_t len = x->size();
+        s.write(reinterpret_cast<const char *>(&len), sizeof(len));
+        s.write(x->data(), len);
+      }
+
+    s.write(data.data(), data.size());
+    s.write(m_data.data(), m_data.size());
+  }
+
+
+  BinaryInputStream::BinaryInputStream(std::shared_ptr<MappedFile> file) :
+    m_file (file),
+    m_ptr  (file->data()),
+    m_end  (file->data() + file->size()),
+    m_shared_strings (false)
+  {
+    if (!BinaryFormat::test(m_ptr, file->size()))
+      throw std::runtime_error("the file is not an oks binary data file");
+
+    m_ptr += sizeof(BinaryFormat::magic);
+
+    if (uint32_t v = get<uint32_t>(); v != BinaryFormat::version)
+      {
+        std::ostringstream text;
+        text << "unsupported version " << v << " of oks binary data file (expected " << BinaryFormat::version << ')';
+        throw std::runtime_error(text.str().c_str());
+      }
+
+    if (get<uint32_t>() != BinaryFormat::byte_order_mark)
+      throw std::runtime_error("the oks binary data file was written on a platform with different byte order");
+
+    const uint32_t source_len = get<uint32_t>();
+
+    if (static_cast<size_t>(m_end - m_ptr) < source_len)
+      throw_bad_data("unexpected end of file");
+
+    m_source.assign(m_ptr, source_len);
+    m_ptr += source_len;
+
+      // read table of strings
+
+    uint32_t num = get<uint32_t>();
+
+    m_strings.reserve(num);
+
+    while (num--)
+      {
+        const uint32_t len = get<uint32_t>();
+
+        if (static_cast<size_t>(m_end - m_ptr) < len)
+          throw_bad_data("unexpected end of file");
+
+        m_strings.emplace_back(m_ptr, len);
+        m_ptr += len;
+      }
+
+      // read table of classes
+
+    m_classes.resize(get<uint32_t>());
+
+    for (auto& c : m_classes)
+      {
+        c.name = &get_string();
+        c.oks_class = nullptr;
+        c.same_layout = false;
+
+        for (auto * items : { &c.attributes, &c.relationships })
+          {
+            items->resize(get<uint32_t>());
+
+            for (auto& x : *items)
+              {
+                x.name = &get_string();
+                x.type = get<uint8_t>();
+                x.multi = get<uint8_t>();
+                x.info = nullptr;
+                x.convert = false;
+              }
+          }
+      }
+  }
+
+  size_t
+  BinaryInputStream::get_position() const
+  {
+    return (m_ptr - m_file->data());
+  }
+
+  size_t
+  BinaryInputStream::size() const
+  {
+    return m_file->size();
+  }
+
+  void
+  BinaryInputStream::resolve(OksKernel * kernel)
+  {
+    m_shared_strings = kernel->get_shared_strings_mode();
+
+    for (auto& c : m_classes)
+      {
+        if ((c.oks_class = kernel->find_class(*c.name)) == nullptr)
+          continue;
+
+        c.same_layout = (c.attributes.size() == c.oks_class->number_of_all_attributes() && c.relationships.size() == c.oks_class->number_of_all_relationships());
+
+        size_t offset(0);
+
+        for (auto& x : c.attributes)
+          {
+            if ((x.info = c.oks_class->get_data_info(*x.name)) != nullptr && x.info->attribute == nullptr)
+              x.info = nullptr;
+
+            if (x.info)
+              x.convert = (x.info->attribute->get_data_type() != x.type || x.info->attribute->get_is_multi_values() != x.multi);
+
+            if (x.info == nullptr || x.convert || x.info->offset != offset++)
+              c.same_layout = false;
+          }
+
+        for (auto& x : c.relationships)
+          {
+            if ((x.info = c.oks_class->get_data_info(*x.name)) != nullptr && x.info->relationship == nullptr)
+              x.info = nullptr;
+
+            if (x.info)
+              x.convert = ((x.info->relationship->get_high_cardinality_constraint() == OksRelationship::Many) != x.multi);
+
+            if (x.info == nullptr || x.convert || x.info->offset != offset++)
+              c.same_layout = false;
+          }
+      }
+  }
+
+  void
+  BinaryInputStream::throw_bad_data(const char * reason) const
+  {
+    std::ostringstream text;
+    text << "bad oks binary data: " << reason << " (offset " << get_position() << ')';
+    throw std::runtime_error(text.str().c_str());
+  }
+
+}
@@ -10,6 +10,8 @@
 #include "oks/profiler.hpp"
 #include "oks/cstring.hpp"
 
+#include "oks_utils.h"
+
 #include "ers/ers.hpp"
 #include "logging/Logging.hpp"
 
@@ -94,7 +96,10 @@ OksClass::OksClass(const std::string& nm, OksKernel * k, bool t) :
   p_instance_size	  (0),
   p_data_info		  (0),
   p_objects		  (0),
-  p_indices		  (0)
+  p_indices		  (0),
+  p_hash_indices	  (0),
+  p_composite_indices	  (0),
+  p_inverted_indices	  (0)
 {
   OSK_PROFILING(OksProfiler::ClassConstructor, p_kernel)
 
@@ -128,7 +133,10 @@ OksClass::OksClass(const std::string& nm, const std::string& d, bool a, OksKerne
   p_instance_size	  (0),
   p_data_info		  (0),
   p_objects		  (0),
-  p_indices		  (0)
+  p_indices		  (0),
+  p_hash_indices	  (0),
+  p_composite_indices	  (0),
+  p_inverted_indices	  (0)
 {
   OSK_PROFILING(OksProfiler::ClassConstructor, p_kernel)
 
@@ -163,7 +171,10 @@ OksClass::OksClass (OksKernel * kernel, const std::string& name, const std::stri
   p_instance_size	  (0),
   p_data_info		  (0),
   p_objects		  (0),
-  p_indices		  (0)
+  p_indices		  (0),
+  p_hash_indices	  (0),
+  p_composite_indices	  (0),
+  p_inverted_indices	  (0)
 {
   OSK_PROFILING(OksProfiler::ClassConstructor, p_kernel)
   p_kernel->p_classes[p_name.c_str()] = this;
@@ -232,6 +243,15 @@ OksClass::~OksClass()
   while (p_indices)
     delete (*(p_indices->begin())).second;
 
+  while (p_hash_indices)
+    delete (*(p_hash_indices->begin())).second;
+
+  while (p_composite_indices)
+    delete p_composite_indices->front();
+
+  while (p_inverted_indices)
+    delete (*(p_inverted_indices->begin())).second;
+
   destroy_map(p_objects);
   destroy_map(p_data_info);
 
@@ -531,7 +551,10 @@ OksClass::OksClass(OksXmlInputStream& s, OksKernel * k) :
   p_instance_size	  (0),
   p_data_info		  (0),
   p_objects		  (0),
-  p_indices		  (0)
+  p_indices		  (0),
+  p_hash_indices	  (0),
+  p_composite_indices	  (0),
+  p_inverted_indices	  (0)
 {
 
     // read 'relationship' tag header
@@ -737,6 +760,114 @@ end_of_stream:
 }
 
 
+OksClass::OksClass(oks::BinaryInputStream& s, OksKernel * k) :
+  p_name		  (s.get_string()),
+  p_description		  (s.get_string()),
+  p_super_classes	  (0),
+  p_attributes		  (0),
+  p_relationships	  (0),
+  p_methods		  (0),
+  p_abstract		  (s.get<uint8_t>()),
+  p_transient		  (false),
+  p_to_be_deleted         (false),
+  p_all_super_classes	  (0),
+  p_all_sub_classes	  (0),
+  p_all_attributes	  (0),
+  p_all_relationships	  (0),
+  p_all_methods		  (0),
+  p_inheritance_hierarchy (0),
+  p_kernel		  (k),
+  p_instance_size	  (0),
+  p_data_info		  (0),
+  p_objects		  (0),
+  p_indices		  (0),
+  p_hash_indices	  (0),
+  p_composite_indices	  (0),
+  p_inverted_indices	  (0)
+{
+  for(uint32_t num = s.get<uint32_t>(); num; --num) {
+    if(!p_super_classes) p_super_classes = new std::list<std::string *>();
+    p_super_classes->push_back(new std::string(s.get_string()));
+  }
+
+  for(uint32_t num = s.get<uint32_t>(); num; --num) {
+    if(!p_attributes) p_attributes = new std::list<OksAttribute *>();
+    p_attributes->push_back(new OksAttribute(s, this));
+  }
+
+  for(uint32_t num = s.get<uint32_t>(); num; --num) {
+    if(!p_relationships) p_relationships = new std::list<OksRelationship *>();
+    p_relationships->push_back(new OksRelationship(s, this));
+  }
+
+  for(uint32_t num = s.get<uint32_t>(); num; --num) {
+    if(!p_methods) p_methods = new std::list<OksMethod *>();
+    p_methods->push_back(new OksMethod(s, this));
+  }
+}
+
+
+void
+OksClass::put(oks::BinaryOutputStream& s) const
+{
+  s.put(p_name);
+  s.put(p_description);
+  s.put(static_cast<uint8_t>(p_abstract));
+
+  s.put(static_cast<uint32_t>(p_super_classes ? p_super_classes->size() : 0));
+
+  if(p_super_classes) {
+    for(const auto& x : *p_super_classes) {
+      s.put(*x);
+    }
+  }
+
+  auto put_list = [&s](const auto * list) {
+    s.put(static_cast<uint32_t>(list ? list->size() : 0));
+
+    if(list) {
+      for(const auto& x : *list) {
+        x->put(s);
+      }
+    }
+  };
+
+  put_list(p_attributes);
+  put_list(p_relationships);
+  put_list(p_methods);
+}
+
+
+void
+OksClass::put_registration(oks::BinaryOutputStream& s) const
+{
+  s.put(static_cast<uint32_t>(p_all_super_classes ? p_all_super_classes->size() : 0));
+
+  if(p_all_super_classes) {
+    for(const auto& x : *p_all_super_classes) {
+      s.put(x->get_name());
+    }
+  }
+
+    // put items of class with names of classes defining them
+
+  auto put_all_list = [&s](const auto * list) {
+    s.put(static_cast<uint32_t>(list ? list->size() : 0));
+
+    if(list) {
+      for(const auto& x : *list) {
+        s.put(x->p_class->get_name());
+        s.put(x->get_name());
+      }
+    }
+  };
+
+  put_all_list(p_all_attributes);
+  put_all_list(p_all_relationships);
+  put_all_list(p_all_methods);
+}
+
+
 /******************************************************************************/
 /****************************** OKS SUPERCLASSES ******************************/
 /******************************************************************************/
@@ -1842,6 +1973,9 @@ OksClass::registrate_attribute_change(OksAttribute *a)
     if(c->p_objects && !c->p_objects->empty()) {
       for(OksObject::Map::const_iterator i2 = c->p_objects->begin(); i2 != c->p_objects->end(); ++i2) {
         OksObject *o(i2->second);
+
+        if(!o->is_read()) continue;  // not parsed yet
+
         OksData newData;
         OksData *oldData = &o->data[((*(c->p_data_info))[a->p_name])->offset];
 
@@ -1879,6 +2013,9 @@ OksClass::registrate_relationship_change(OksRelationship *r)
     if(c->p_objects && !c->p_objects->empty()) {
       for(OksObject::Map::const_iterator i2 = c->p_objects->begin(); i2 != c->p_objects->end(); ++i2) {
         OksObject *o(i2->second);
+
+        if(!o->is_read()) continue;  // not parsed yet
+
         OksData newData;
         OksData *oldData = &o->data[((*(c->p_data_info))[r->p_name])->offset];
 
@@ -1931,12 +2068,22 @@ OksClass::registrate_instances()
   }
 
   if(thereAreChanges == true) {
+    if(p_kernel) p_kernel->k_invalidate_reverse_refs();
+
     if(p_objects && !p_objects->empty()) {
       for(OksObject::Map::const_iterator i = p_objects->begin(); i != p_objects->end(); ++i) {
         OksObject	*o = (*i).second;
         OksData * data = new OksData[dInfoLength];
         size_t count = 0;
 
+          // the body of object read in lazy mode is not parsed yet and will be read using new layout
+
+        if(!o->is_read()) {
+          delete [] o->data;
+          o->data = data;
+          continue;
+        }
+
         if(!p_all_attributes->empty()) {
       	  for(std::list<OksAttribute *>::iterator i2 = p_all_attributes->begin(); i2 != p_all_attributes->end(); ++i2) {
             OksAttribute * a = *i2;
@@ -2034,6 +2181,94 @@ OksClass::registrate_class(bool skip_registered)
 }
 
 
+  // read items of class registered in schema image
+
+template<class T>
+  static std::list<T *> *
+  read_all_list(oks::BinaryInputStream& s, OksKernel * kernel, T * (OksClass::*find)(const std::string&) const noexcept)
+  {
+    std::list<T *> * list = new std::list<T *>();
+
+    for (uint32_t num = s.get<uint32_t>(); num; --num)
+      {
+        const std::string& class_name(s.get_string());
+        const std::string& name(s.get_string());
+
+        OksClass * c = kernel->find_class(class_name);
+        T * x = (c ? (c->*find)(name) : nullptr);
+
+        if (x == nullptr)
+          {
+            delete list;
+            throw std::runtime_error(std::string("cannot find \"") + name + "\" of class \"" + class_name + '\"');
+          }
+
+        list->push_back(x);
+      }
+
+    return list;
+  }
+
+
+  // registrate class using inheritance closures from schema image
+  // there is no need to check conflicts of attributes and relationships since it was done when image was created
+
+void
+OksClass::registrate_class(oks::BinaryInputStream& s)
+{
+  OSK_PROFILING(OksProfiler::ClassRegistrateClass, p_kernel)
+
+  try {
+    p_all_super_classes = new FList();
+
+    for(uint32_t num = s.get<uint32_t>(); num; --num) {
+      const std::string& name(s.get_string());
+
+      if(OksClass * c = p_kernel->find_class(name)) {
+        p_all_super_classes->push_back(c);
+      }
+      else {
+        throw oks::CannotFindSuperClass(*this, name);
+      }
+    }
+
+    if(p_attributes)
+      for(const auto& x : *p_attributes)
+        x->set_init_data();
+
+    p_all_attributes = read_all_list(s, p_kernel, &OksClass::find_direct_attribute);
+    p_all_relationships = read_all_list(s, p_kernel, &OksClass::find_direct_relationship);
+    p_all_methods = read_all_list(s, p_kernel, &OksClass::find_direct_method);
+
+    for(const auto& r : *p_all_relationships) {
+      if(!r->p_class_type) {
+        r->p_class_type = p_kernel->find_class(r->p_rclass);
+      }
+    }
+
+      // the instance layout is defined by the order of attributes and relationships
+
+    p_data_info = new OksDataInfo::Map();
+
+    for(const auto& a : *p_all_attributes) {
+      (*p_data_info)[a->get_name()] = new OksDataInfo(p_instance_size++, a);
+    }
+
+    for(const auto& r : *p_all_relationships) {
+      (*p_data_info)[r->get_name()] = new OksDataInfo(p_instance_size++, r);
+    }
+
+    p_objects = new OksObject::Map( (p_abstract == false) ? 1024 : 1 );
+  }
+  catch(oks::exception& ex) {
+    throw oks::CannotRegisterClass(*this, "", ex);
+  }
+  catch(std::exception& ex) {
+    throw oks::CannotRegisterClass(*this, "", ex.what());
+  }
+}
+
+
 void
 OksClass::registrate_class_change(ChangeType changeType, const void *parameter, bool update_file)
 {
@@ -19,6 +19,9 @@
 #include <sstream>
 #include <stdexcept>
 #include <limits>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
 
 #include <boost/date_time/posix_time/time_formatters.hpp>
 #include <boost/date_time/posix_time/time_parsers.hpp>
@@ -113,7 +116,7 @@ OksData::operator==(const OksData& d) const {
   return (
     (d.type == type) &&
     (
-      ( (type == string_type) && (*d.data.STRING == *data.STRING) ) ||
+      ( (type == string_type) && (d.data.STRING == data.STRING || *d.data.STRING == *data.STRING) ) ||
       ( (type == u32_int_type) && (d.data.U32_INT == data.U32_INT) ) ||
       ( (type == s32_int_type) && (d.data.S32_INT == data.S32_INT) ) ||
       ( (type == u16_int_type) && (d.data.U16_INT == data.U16_INT) ) ||
@@ -143,6 +146,72 @@ OksData::operator!=(const OksData& d) const {
 }
 
 
+static inline size_t
+mix_hash(uint64_t x) noexcept
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static inline size_t
+str_hash(const std::string& s) noexcept
+{
+  return std::hash<std::string_view>()(s);
+}
+
+size_t
+OksData::hash() const noexcept
+{
+  switch(type) {
+    case string_type:   return str_hash(*data.STRING);
+    case enum_type:     return str_hash(*data.ENUMERATION);
+    case s8_int_type:   return mix_hash(data.S8_INT);
+    case u8_int_type:   return mix_hash(data.U8_INT);
+    case s16_int_type:  return mix_hash(data.S16_INT);
+    case u16_int_type:  return mix_hash(data.U16_INT);
+    case s32_int_type:  return mix_hash(data.S32_INT);
+    case u32_int_type:  return mix_hash(data.U32_INT);
+    case s64_int_type:  return mix_hash(data.S64_INT);
+    case u64_int_type:  return mix_hash(data.U64_INT);
+    case bool_type:     return data.BOOL;
+    case date_type:     return mix_hash(data.DATE);
+    case time_type:     return mix_hash(data.TIME);
+    case class_type:    return str_hash(data.CLASS->get_name());
+    case object_type:   return (data.OBJECT ? str_hash(data.OBJECT->uid.object_id) : 0);
+    case uid_type:      return str_hash(*data.UID.object_id);
+    case uid2_type:     return str_hash(*data.UID2.object_id);
+
+      // +0.0 and -0.0 are equal
+
+    case float_type: {
+      uint32_t x(0);
+      if(data.FLOAT != 0) memcpy(&x, &data.FLOAT, sizeof(x));
+      return mix_hash(x);
+    }
+
+    case double_type: {
+      uint64_t x(0);
+      if(data.DOUBLE != 0) memcpy(&x, &data.DOUBLE, sizeof(x));
+      return mix_hash(x);
+    }
+
+    case list_type: {
+      size_t h(data.LIST->size());
+      for(const auto& i : *data.LIST)
+        h = mix_hash(h ^ (i ? i->hash() : 0));
+      return h;
+    }
+
+    default:
+      return 0;
+  }
+}
+
+
 static bool
 test_comparable(OksData::Type type1, OksData::Type type2)
 {
@@ -264,6 +333,7 @@ void
 OksData::copy(const OksData & d)
 {
   type = d.type;
+  shared = false;
 
   if(type == list_type) {
     data.LIST = new List();
@@ -426,7 +496,10 @@ OksData::Clear()
         break;
 
       case string_type:
-        if(data.STRING) { delete data.STRING; }
+        if(data.STRING) {
+          if(shared) { oks::SharedStrings::release(data.STRING); }
+          else { delete data.STRING; }
+        }
         break;
 
       case uid2_type:
@@ -445,6 +518,96 @@ OksData::Clear()
   }
 
   type = unknown_type;
+  shared = false;
+}
+
+
+namespace oks {
+
+    // the string of shared strings pool with reference counter
+
+  struct SharedString : public OksString {
+    SharedString(const char * s, size_t len, uint32_t shard) : OksString(s, len), m_refs(1), m_shard(shard) { ; }
+
+    uint32_t m_refs;
+    uint32_t m_shard;
+
+    void * operator new(size_t) {return boost::fast_pool_allocator<SharedString>::allocate();}
+    void operator delete(void *ptr) {boost::fast_pool_allocator<SharedString>::deallocate(reinterpret_cast<SharedString*>(ptr));}
+  };
+
+
+    // the pool is split into shards protected by own mutexes to reduce contention, when files are loaded in parallel;
+    // the shards are never destroyed, since the strings may be released by objects destroyed on exit
+
+  struct SharedStringsShard {
+    std::mutex m_mutex;
+    std::unordered_map<std::string_view, SharedString *> m_strings;
+  };
+
+  static const uint32_t s_shared_strings_shards_num = 16;
+
+  static SharedStringsShard *
+  shared_strings_shards()
+  {
+    static SharedStringsShard * shards = new SharedStringsShard[s_shared_strings_shards_num];
+    return shards;
+  }
+
+  OksString *
+  SharedStrings::get(const char * s, size_t len)
+  {
+    const std::string_view key(s, len);
+    const size_t hash = std::hash<std::string_view>()(key);
+    const uint32_t idx = (hash ^ (hash >> 32)) % s_shared_strings_shards_num;
+
+    SharedStringsShard& shard(shared_strings_shards()[idx]);
+
+    std::lock_guard lock(shard.m_mutex);
+
+    auto i = shard.m_strings.find(key);
+
+    if (i != shard.m_strings.end())
+      {
+        i->second->m_refs++;
+        return i->second;
+      }
+
+    SharedString * x = new SharedString(s, len, idx);
+    shard.m_strings.emplace(std::string_view(x->data(), x->size()), x);
+    return x;
+  }
+
+  void
+  SharedStrings::release(OksString * s)
+  {
+    SharedString * x = static_cast<SharedString *>(s);
+    SharedStringsShard& shard(shared_strings_shards()[x->m_shard]);
+
+    std::lock_guard lock(shard.m_mutex);
+
+    if (--x->m_refs == 0)
+      {
+        shard.m_strings.erase(std::string_view(x->data(), x->size()));
+        delete x;
+      }
+  }
+
+  size_t
+  SharedStrings::size()
+  {
+    size_t num(0);
+
+    for (uint32_t i = 0; i < s_shared_strings_shards_num; ++i)
+      {
+        SharedStringsShard& shard(shared_strings_shards()[i]);
+        std::lock_guard lock(shard.m_mutex);
+        num += shard.m_strings.size();
+      }
+
+    return num;
+  }
+
 }
 
 
@@ -551,21 +714,21 @@ OksData::SetValue(const char * s, const OksAttribute * a)
   }
   else {
     switch(type) {
-      case s8_int_type:  data.S8_INT      = static_cast<int8_t>(strtol(s, 0, 0));     return;
-      case u8_int_type:  data.U8_INT      = static_cast<uint8_t>(strtoul(s, 0, 0));   return;
+      case s8_int_type:  oks::str2num(s, s + strlen(s), data.S8_INT = 0);         return;
+      case u8_int_type:  oks::str2num(s, s + strlen(s), data.U8_INT = 0);         return;
       case bool_type:    switch(strlen(s)) {
                            case 4: data.BOOL = (oks::cmp_str4n(s, "true") || oks::cmp_str4n(s, "TRUE") ||  oks::cmp_str4n(s, "True")); return;
                            case 1: data.BOOL = (*s == 't' || *s == 'T' || *s == '1'); return;
                            default: data.BOOL = false; return;
                          }
-      case u32_int_type: data.U32_INT     = static_cast<uint32_t>(strtoul(s, 0, 0));  return;
-      case s32_int_type: data.S32_INT     = static_cast<int32_t>(strtol(s, 0, 0));    return;
-      case s16_int_type: data.S16_INT     = static_cast<int16_t>(strtol(s, 0, 0));    return;
-      case u16_int_type: data.U16_INT     = static_cast<uint16_t>(strtoul(s, 0, 0));  return;
-      case s64_int_type: data.S64_INT     = static_cast<int64_t>(strtoll(s, 0, 0));   return;
-      case u64_int_type: data.U64_INT     = static_cast<uint64_t>(strtoull(s, 0, 0)); return;
-      case float_type:   data.FLOAT       = strtof(s, 0);                             return;
-      case double_type:  data.DOUBLE      = strtod(s, 0);                             return;
+      case u32_int_type: oks::str2num(s, s + strlen(s), data.U32_INT = 0);        return;
+      case s32_int_type: oks::str2num(s, s + strlen(s), data.S32_INT = 0);        return;
+      case s16_int_type: oks::str2num(s, s + strlen(s), data.S16_INT = 0);        return;
+      case u16_int_type: oks::str2num(s, s + strlen(s), data.U16_INT = 0);        return;
+      case s64_int_type: oks::str2num(s, s + strlen(s), data.S64_INT = 0);        return;
+      case u64_int_type: oks::str2num(s, s + strlen(s), data.U64_INT = 0);        return;
+      case float_type:   oks::str2num(s, s + strlen(s), data.FLOAT = 0);          return;
+      case double_type:  oks::str2num(s, s + strlen(s), data.DOUBLE = 0);         return;
 
       case string_type:  data.STRING      = new OksString(s);                         return;
       case enum_type:    try {
@@ -708,7 +871,7 @@ OksData::ReadFrom(const OksRelationship *r) noexcept
 }
 
 
-void
+size_t
 OksXmlInputStream::get_num_token(char __last)
 {
   size_t pos(1);
@@ -728,12 +891,12 @@ OksXmlInputStream::get_num_token(char __last)
 
       if(c == __last) {
         m_cvt_char->m_buf[pos] = '\0';
-        f->unget();
-        return;
+        unget();
+        return pos;
       }
       else if(c == ' ' || c == '\n' || c == '\r' || c == '\t') {
         m_cvt_char->m_buf[pos] = '\0';
-        return;
+        return pos;
       }
 
       m_cvt_char->realloc(pos);
@@ -766,7 +929,6 @@ void
 OksData::read(const oks::ReadFileParams& read_params, const OksAttribute *a)
 {
   const char * read_value="";  // is used for report in case of exception
-  char * __sanity;
   OksXmlInputStream& fxs(read_params.s);
 
   try {
@@ -775,7 +937,10 @@ OksData::read(const oks::ReadFileParams& read_params, const OksAttribute *a)
         read_value = "quoted string";
 	{
           size_t len = fxs.get_quoted();
-          if(type == string_type && data.STRING) {
+          if(read_params.shared_strings) {
+            SetShared(fxs.get_xml_token().m_buf, len);
+          }
+          else if(type == string_type && data.STRING && !shared) {
             data.STRING->assign(fxs.get_xml_token().m_buf, len);
           }
           else {
@@ -788,79 +953,90 @@ OksData::read(const oks::ReadFileParams& read_params, const OksAttribute *a)
 
       case s32_int_type:
         read_value = "signed 32 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<int32_t>(strtol(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<int32_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case u32_int_type:
         read_value = "unsigned 32 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<uint32_t>(strtoul(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<uint32_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case s16_int_type:
         read_value = "signed 16 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<int16_t>(strtol(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<int16_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case u16_int_type:
         read_value = "unsigned 16 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<uint16_t>(strtoul(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<uint16_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case s8_int_type:
         read_value = "signed 8 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<int8_t>(strtol(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<int8_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case u8_int_type:
         read_value = "unsigned 8 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<uint8_t>(strtoul(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<uint8_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case s64_int_type:
         read_value = "signed 64 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<int64_t>(strtoll(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoll", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<int64_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case u64_int_type:
         read_value = "unsigned 64 bits integer";
-        fxs.get_num_token('<');
-        Set(static_cast<uint64_t>(strtoull(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoull", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<uint64_t>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case float_type:
         read_value = "float";
-        fxs.get_num_token('<');
-        Set(strtof(fxs.m_cvt_char->m_buf, &__sanity));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtof", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<float>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case double_type:
         read_value = "double";
-        fxs.get_num_token('<');
-        Set(strtod(fxs.m_cvt_char->m_buf, &__sanity));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtod", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<double>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case bool_type:
         read_value = "boolean";
-        fxs.get_num_token('<');
-        Set(static_cast<bool>(strtol(fxs.m_cvt_char->m_buf, &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, fxs.m_cvt_char->m_buf, fxs.line_no, fxs.line_pos);
+        {
+          size_t len = fxs.get_num_token('<');
+          Set(oks::read_num<bool>(fxs.m_cvt_char->m_buf, len, fxs.line_no, fxs.line_pos));
+        }
         break;
 
       case date_type:
@@ -924,16 +1100,18 @@ OksData::read(const oks::ReadFileParams& read_params, const OksAttribute *a)
 
 
 void
-OksData::read(const OksAttribute *a, const OksXmlValue& value)
+OksData::read(const OksAttribute *a, const OksXmlValue& value, bool shared_strings)
 {
   const char * read_value="";  // is used for report in case of exception
-  char * __sanity;
 
   try {
     switch(a->get_data_type()) {
       case string_type:
         {
-          if(type == string_type && data.STRING) {
+          if(shared_strings) {
+            SetShared(value.buf(), value.len());
+          }
+          else if(type == string_type && data.STRING && !shared) {
             data.STRING->assign(value.buf(), value.len());
           }
           else {
@@ -946,68 +1124,57 @@ OksData::read(const OksAttribute *a, const OksXmlValue& value)
 
       case s32_int_type:
         read_value = "signed 32 bits integer";
-        Set(static_cast<int32_t>(strtol(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<int32_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case u32_int_type:
         read_value = "unsigned 32 bits integer";
-        Set(static_cast<uint32_t>(strtoul(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<uint32_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case s16_int_type:
         read_value = "signed 16 bits integer";
-        Set(static_cast<int16_t>(strtol(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<int16_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case u16_int_type:
         read_value = "unsigned 16 bits integer";
-        Set(static_cast<uint16_t>(strtoul(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<uint16_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case s8_int_type:
         read_value = "signed 8 bits integer";
-        Set(static_cast<int8_t>(strtol(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<int8_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case u8_int_type:
         read_value = "unsigned 8 bits integer";
-        Set(static_cast<uint8_t>(strtoul(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<uint8_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case s64_int_type:
         read_value = "signed 64 bits integer";
-        Set(static_cast<int64_t>(strtoll(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoll", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<int64_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case u64_int_type:
         read_value = "unsigned 64 bits integer";
-        Set(static_cast<uint64_t>(strtoull(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoull", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<uint64_t>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case float_type:
         read_value = "float";
-        Set(strtof(value.buf(), &__sanity));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtof", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<float>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case double_type:
         read_value = "double";
-        Set(strtod(value.buf(), &__sanity));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtod", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<double>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case bool_type:
         read_value = "boolean";
-        Set(static_cast<bool>(strtol(value.buf(), &__sanity, 0)));
-        if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtol", __sanity, value.buf(), value.line_no(), value.line_pos());
+        Set(oks::read_num<bool>(value.buf(), value.len(), value.line_no(), value.line_pos()));
         break;
 
       case date_type:
@@ -1082,7 +1249,7 @@ OksData::read(const OksAttribute *a, const oks::ReadFileParams& read_params)
                 if (oks::cmp_str3(attr.name(), OksObject::value_xml_attribute))
                   {
                     OksXmlValue value(read_params.s.get_value(attr.p_value_len));
-                    data.LIST->push_back(new OksData(a, value));
+                    data.LIST->push_back(new OksData(a, value, read_params.shared_strings));
                   }
                 else
                   {
@@ -1387,6 +1554,241 @@ OksData::read(const OksRelationship *r, const oks::ReadFileParams& read_params)
 }
 
 
+    //
+    // Read attribute value from binary snapshot
+    //
+
+void
+OksData::read(oks::BinaryInputStream& s, const OksAttribute * a)
+{
+  Clear();
+
+  const Type t = static_cast<Type>(s.get<uint8_t>());
+
+  switch (t)
+    {
+      case s8_int_type:  data.S8_INT  = s.get<int8_t>();   break;
+      case u8_int_type:  data.U8_INT  = s.get<uint8_t>();  break;
+      case s16_int_type: data.S16_INT = s.get<int16_t>();  break;
+      case u16_int_type: data.U16_INT = s.get<uint16_t>(); break;
+      case s32_int_type: data.S32_INT = s.get<int32_t>();  break;
+      case u32_int_type: data.U32_INT = s.get<uint32_t>(); break;
+      case s64_int_type: data.S64_INT = s.get<int64_t>();  break;
+      case u64_int_type: data.U64_INT = s.get<uint64_t>(); break;
+      case float_type:   data.FLOAT   = s.get<float>();    break;
+      case double_type:  data.DOUBLE  = s.get<double>();   break;
+      case bool_type:    data.BOOL    = (s.get<uint8_t>() != 0); break;
+      case date_type:    data.DATE    = s.get<uint32_t>(); break;
+      case time_type:    data.TIME    = s.get<uint64_t>(); break;
+      case string_type:
+        {
+          const std::string& value(s.get_string());
+
+          if (s.shared_strings())
+            {
+              data.STRING = oks::SharedStrings::get(value.data(), value.size());
+              shared = true;
+            }
+          else
+            {
+              data.STRING = new OksString(value);
+            }
+        }
+        break;
+
+      case enum_type:
+        {
+          const std::string& value(s.get_string());
+
+          if (a->get_data_type() != enum_type)
+            {
+              data.STRING = new OksString(value);
+              type = string_type;
+              return;
+            }
+
+          try
+            {
+              data.ENUMERATION = a->get_enum_value(value);
+            }
+          catch (std::exception& ex)
+            {
+              throw oks::AttributeReadError(value.c_str(), "enum", ex.what());
+            }
+        }
+        break;
+
+      case class_type:
+        {
+          const std::string& value(s.get_string());
+
+          if ((data.CLASS = a->p_class->get_kernel()->find_class(value)) == nullptr)
+            throw oks::AttributeReadError(value.c_str(), "class", "the value is not a name of valid OKS class");
+        }
+        break;
+
+      case list_type:
+        {
+          uint32_t num = s.get<uint32_t>();
+
+          data.LIST = new List();
+          type = list_type;
+
+          while (num--)
+            {
+              OksData * d = new OksData();
+              data.LIST->push_back(d);
+              d->read(s, a);
+            }
+        }
+        return;
+
+      default:
+        s.throw_bad_data("unexpected type of attribute value");
+    }
+
+  type = t;
+}
+
+
+    //
+    // Read relationship value from binary snapshot
+    //
+
+void
+OksData::read(oks::BinaryInputStream& s, const OksRelationship * r, OksObject * owner)
+{
+  Clear();
+
+  switch (s.get<uint8_t>())
+    {
+      case object_type:
+        data.OBJECT = nullptr;
+        type = object_type;
+        return;
+
+      case uid_type:
+        {
+          const oks::BinaryClassInfo& c(s.get_class());
+          const std::string& id(s.get_string());
+
+          if (__builtin_expect((c.oks_class == nullptr), 0))
+            {
+              Set(new OksString(*c.name), new OksString(id));
+            }
+          else if (OksObject * o = (r ? c.oks_class->get_object(id) : nullptr))
+            {
+              owner->check_class_type(r, c.oks_class);
+              Set(o);
+              o->add_RCR(owner, r);
+            }
+          else
+            {
+              Set(c.oks_class, new OksString(id));
+            }
+        }
+        return;
+
+      case uid2_type:
+        {
+          const std::string& class_id(s.get_string());
+          Set(new OksString(class_id), new OksString(s.get_string()));
+        }
+        return;
+
+      case list_type:
+        {
+          uint32_t num = s.get<uint32_t>();
+
+          Set(new List());
+
+          while (num--)
+            {
+              OksData * d = new OksData();
+              data.LIST->push_back(d);
+              d->read(s, r, owner);
+            }
+        }
+        return;
+
+      default:
+        s.throw_bad_data("unexpected type of relationship value");
+    }
+}
+
+
+    //
+    // Write value to binary snapshot; the references are stored as
+    // class index and object id, or as class name and object id (uid2)
+    //
+
+void
+OksData::write(oks::BinaryOutputStream& s) const
+{
+  switch (type)
+    {
+      case object_type:
+        if (data.OBJECT == nullptr)
+          {
+            s.put(static_cast<uint8_t>(object_type));
+          }
+        else
+          {
+            s.put(static_cast<uint8_t>(uid_type));
+            s.put(data.OBJECT->uid.class_id);
+            s.put(data.OBJECT->uid.object_id);
+          }
+        return;
+
+      case uid_type:
+        s.put(static_cast<uint8_t>(uid_type));
+        s.put(data.UID.class_id);
+        s.put(*data.UID.object_id);
+        return;
+
+      case uid2_type:
+        s.put(static_cast<uint8_t>(uid2_type));
+        s.put(*data.UID2.class_id);
+        s.put(*data.UID2.object_id);
+        return;
+
+      default:
+        break;
+    }
+
+  s.put(static_cast<uint8_t>(type));
+
+  switch (type)
+    {
+      case s8_int_type:  s.put(data.S8_INT);  return;
+      case u8_int_type:  s.put(data.U8_INT);  return;
+      case s16_int_type: s.put(data.S16_INT); return;
+      case u16_int_type: s.put(data.U16_INT); return;
+      case s32_int_type: s.put(data.S32_INT); return;
+      case u32_int_type: s.put(data.U32_INT); return;
+      case s64_int_type: s.put(data.S64_INT); return;
+      case u64_int_type: s.put(data.U64_INT); return;
+      case float_type:   s.put(data.FLOAT);   return;
+      case double_type:  s.put(data.DOUBLE);  return;
+      case bool_type:    s.put(static_cast<uint8_t>(data.BOOL)); return;
+      case date_type:    s.put(data.DATE);    return;
+      case time_type:    s.put(data.TIME);    return;
+      case string_type:  s.put(*data.STRING); return;
+      case enum_type:    s.put(*data.ENUMERATION); return;
+      case class_type:   s.put(data.CLASS->get_name()); return;
+
+      case list_type:
+        s.put(static_cast<uint32_t>(data.LIST->size()));
+        for (const auto& x : *data.LIST)
+          x->write(s);
+        return;
+
+      default:
+        throw std::runtime_error("unexpected type of data");
+    }
+}
+
+
     //
     // Writes to stream any OKS data except relationship types
     // (i.e. object, uid, uid2)
@@ -1442,21 +1844,13 @@ OksData::WriteTo(OksXmlOutputStream& xmls, bool put_number) const
       xmls.put_value(data.U16_INT);
       break;
 
-    case float_type: {
-      std::ostream& s = xmls.get_stream();
-      std::streamsize p = s.precision();
-      s.precision(std::numeric_limits< float >::digits10);
+    case float_type:
       xmls.put_value(data.FLOAT);
-      s.precision(p);
-      break; }
+      break;
 
-    case double_type: {
-      std::ostream& s = xmls.get_stream();
-      std::streamsize p = s.precision();
-      s.precision(std::numeric_limits< double >::digits10);
+    case double_type:
       xmls.put_value(data.DOUBLE);
-      s.precision(p);
-      break; }
+      break;
 
     case s8_int_type:
       xmls.put_value(static_cast<int16_t>(data.S8_INT));
@@ -1529,21 +1923,13 @@ OksData::WriteTo(OksXmlOutputStream& xmls) const
       xmls.put_value(data.U16_INT);
       break;
 
-    case float_type: {
-      std::ostream& s = xmls.get_stream();
-      std::streamsize p = s.precision();
-      s.precision(std::numeric_limits< float >::digits10);
+    case float_type:
       xmls.put_value(data.FLOAT);
-      s.precision(p);
-      break; }
+      break;
 
-    case double_type: {
-      std::ostream& s = xmls.get_stream();
-      std::streamsize p = s.precision();
-      s.precision(std::numeric_limits< double >::digits10);
+    case double_type:
       xmls.put_value(data.DOUBLE);
-      s.precision(p);
-      break; }
+      break;
 
     case s8_int_type:
       xmls.put_value(static_cast<int16_t>(data.S8_INT));
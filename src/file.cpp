@@ -21,6 +21,9 @@
 #include <boost/date_time/posix_time/time_formatters.hpp>
 #include <boost/date_time/posix_time/time_parsers.hpp>
 #include <boost/interprocess/sync/file_lock.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
 
 #include "ers/ers.hpp"
 #include "logging/Logging.hpp"
@@ -36,6 +39,13 @@ const char OksFile::xml_comments_tag[] = "comments";
 const char OksFile::xml_comment_tag[]  = "comment";
 
 const char OksFile::xml_file_header[]  = "<?xml version=\"1.0\" encoding=\"ASCII\"?>";
+const char OksFile::xml_checksum_start[]   = "\n<!-- oks-checksum: ";
+const char OksFile::xml_checksum_content[] = " content: ";
+const char OksFile::xml_checksum_end[]     = " -->\n";
+
+  // the checksums are written as 16 hexadecimal digits
+
+const size_t OksFile::checksum_header_len = sizeof(xml_file_header) - 1 + sizeof(xml_checksum_start) - 1 + 16 + sizeof(xml_checksum_content) - 1 + 16 + sizeof(xml_checksum_end) - 1;
 
 const char OksFile::xml_schema_file_dtd[] =
   "<!DOCTYPE oks-schema [\n"
@@ -247,6 +257,70 @@ namespace oks {
 }
 
 
+OksFile::Compression
+oks::get_compression(const std::string& file_name)
+{
+  unsigned char magic[4];
+
+  std::ifstream f(file_name.c_str(), std::ios::binary);
+
+  if(!f.read(reinterpret_cast<char *>(magic), sizeof(magic))) {
+    return OksFile::Uncompressed;
+  }
+
+  if(magic[0] == 0x1f && magic[1] == 0x8b) {
+    return OksFile::Gzip;
+  }
+
+  if(magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+    return OksFile::Zstd;
+  }
+
+  return OksFile::Uncompressed;
+}
+
+
+std::shared_ptr<oks::MappedFile>
+oks::decompress_file(const std::string& file_name, OksFile::Compression c)
+{
+  std::ifstream f(file_name.c_str(), std::ios::binary);
+
+  if(!f) {
+    throw std::runtime_error(std::string("cannot open file: ") + oks::strerror(errno));
+  }
+
+  std::string content;
+
+  try {
+    boost::iostreams::filtering_istream in;
+
+    if(c == OksFile::Gzip) {
+      in.push(boost::iostreams::gzip_decompressor());
+    }
+    else {
+      in.push(boost::iostreams::zstd_decompressor());
+    }
+
+    in.push(f);
+
+    char buf[64 * 1024];
+
+    while(in.read(buf, sizeof(buf)) || in.gcount() > 0) {
+      content.append(buf, in.gcount());
+    }
+
+    if(in.bad()) {
+      throw std::runtime_error("read error");
+    }
+  }
+  catch(std::exception& ex) {
+    throw std::runtime_error(std::string("cannot decompress ") + (c == OksFile::Gzip ? "gzip" : "zstd") + " file: " + ex.what());
+  }
+
+  return std::make_shared<oks::MappedFile>(std::move(content));
+}
+
+
 OksFile::OksFile(const std::string& s, const std::string& ln, const std::string& ft, const std::string& ff, OksKernel * k) :
  p_short_name               (s),
  p_full_name                (s),
@@ -255,6 +329,8 @@ OksFile::OksFile(const std::string& s, const std::string& ln, const std::string&
  p_oks_format               (ff),
  p_number_of_items          (0),
  p_size                     (0),
+ p_number_of_parts          (1),
+ p_compression              (Uncompressed),
  p_created_by               (OksKernel::get_user_name()),
  p_creation_time            (boost::posix_time::second_clock::universal_time()),
  p_created_on               (OksKernel::get_host_name()),
@@ -264,9 +340,12 @@ OksFile::OksFile(const std::string& s, const std::string& ln, const std::string&
  p_is_read_only             (true),
  p_last_modified            (0),
  p_repository_last_modified (0),
+ p_checksum                 (0),
+ p_content_checksum         (0),
  p_is_on_disk               (false),
  p_included_by              (0),
- p_kernel                   (k)
+ p_kernel                   (k),
+ p_journal_complete         (true)
 {
   p_last_modified_on = p_created_on;
   p_last_modified_by = p_created_by;
@@ -307,6 +386,9 @@ OksFile::operator=(const OksFile & f)
       p_oks_format = f.p_oks_format;
       p_number_of_items = f.p_number_of_items;
       p_size = f.p_size;
+      p_number_of_parts = f.p_number_of_parts;
+      p_cache_key = f.p_cache_key;
+      p_compression = f.p_compression;
       p_created_by = f.p_created_by;
       p_creation_time = f.p_creation_time;
       p_created_on = f.p_created_on;
@@ -321,9 +403,12 @@ OksFile::operator=(const OksFile & f)
       p_list_of_include_files = f.p_list_of_include_files;
       p_last_modified = f.p_last_modified;
       p_repository_last_modified = f.p_repository_last_modified;
+      p_checksum = f.p_checksum;
+      p_content_checksum = f.p_content_checksum;
       p_is_on_disk = f.p_is_on_disk;
       p_included_by = f.p_included_by;
       p_kernel = f.p_kernel;
+      p_journal_complete = f.p_journal_complete;
 
       for (const auto& i : f.p_comments)
         {
@@ -343,6 +428,8 @@ OksFile::OksFile(std::shared_ptr<OksXmlInputStream> xmls, const std::string& sp,
  p_short_name               (sp),
  p_full_name                (fp),
  p_oks_format               (_empty_str, sizeof(_empty_str)-1),
+ p_number_of_parts          (1),
+ p_compression              (Uncompressed),
  p_creation_time            (boost::posix_time::not_a_date_time),
  p_last_modification_time   (boost::posix_time::not_a_date_time),
  p_lock                     (),
@@ -350,9 +437,12 @@ OksFile::OksFile(std::shared_ptr<OksXmlInputStream> xmls, const std::string& sp,
  p_is_read_only             (true),
  p_last_modified            (0),
  p_repository_last_modified (0),
+ p_checksum                 (0),
+ p_content_checksum         (0),
  p_is_on_disk               (true),
  p_included_by              (0),
- p_kernel                   (k)
+ p_kernel                   (k),
+ p_journal_complete         (true)
 {
   const char * fname = "OksFile::OksFile()";
 
@@ -360,6 +450,15 @@ OksFile::OksFile(std::shared_ptr<OksXmlInputStream> xmls, const std::string& sp,
   check_repository();
 
 
+    // read checksums stored in the header comment, if any; the file checksum is verified against the file contents by get_status_of_file()
+
+  {
+    char buf[checksum_header_len];
+    const size_t len = xmls->peek(buf, checksum_header_len);
+    p_checksum = read_checksum(buf, len, &p_content_checksum);
+  }
+
+
     // check file header
 
   try {
@@ -697,6 +796,7 @@ OksFile::add_comment(const std::string& text, const std::string& author)
   }
 
   p_is_updated = true;
+  p_journal_complete = false;
 }
 
 oks::Comment *
@@ -733,6 +833,7 @@ OksFile::modify_comment(const std::string& creation_time, const std::string& tex
     }
 
     p_is_updated = true;
+    p_journal_complete = false;
   }
   else {
     throw oks::FailedChangeComment(*this, creation_time, "cannot find comment");
@@ -754,6 +855,7 @@ OksFile::remove_comment(const std::string& creation_time)
     delete comment;
     p_comments.erase(creation_time);
     p_is_updated = true;
+    p_journal_complete = false;
   }
   else {
     throw oks::FailedRemoveComment(*this, creation_time, "cannot find comment");
@@ -762,7 +864,7 @@ OksFile::remove_comment(const std::string& creation_time)
 
 
 void
-OksFile::write(OksXmlOutputStream& xmls)
+OksFile::write(OksXmlOutputStream& xmls, bool checksum)
 {
   const static std::string __data("data");
   const static std::string __schema("schema");
@@ -797,7 +899,27 @@ OksFile::write(OksXmlOutputStream& xmls)
           const char __hdr_end[] = " version 2.2 -->\n\n\n";
 
           std::string header(xml_file_header, sizeof(xml_file_header) - 1);
-          header.append(__hdr_start, sizeof(__hdr_start) - 1);
+
+            // the placeholders are replaced by write_checksums() after the rest of file is written
+
+          if (checksum)
+            {
+              header.append(xml_checksum_start, sizeof(xml_checksum_start) - 1);
+              header.append(16, '0');
+              header.append(xml_checksum_content, sizeof(xml_checksum_content) - 1);
+              header.append(16, '0');
+              header.append(xml_checksum_end, sizeof(xml_checksum_end) - 1);
+
+              xmls.put_raw(header.c_str(), header.size());
+
+              header.clear();
+            }
+
+          xmls.start_checksum(); // file checksum
+
+          const long skip_new_line(checksum ? 1 : 0); // the checksum comment ends by new line
+
+          header.append(__hdr_start + skip_new_line, sizeof(__hdr_start) - 1 - skip_new_line);
           header.append(id, id_len);
           header.append(__hdr_end, sizeof(__hdr_end) - 1);
           header.append(dtd, dtd_len);
@@ -832,6 +954,8 @@ OksFile::write(OksXmlOutputStream& xmls)
 
       std::string last_modified_c_str = boost::posix_time::to_iso_string(p_last_modification_time);
 
+      const size_t content_checksum(xmls.start_checksum());
+
       xmls.put_start_tag(xml_info_tag, sizeof(xml_info_tag) - 1);
       xmls.put_attribute("name", sizeof("name") - 1, p_logical_name.c_str());
       xmls.put_attribute("type", sizeof("type") - 1, p_type.c_str());
@@ -844,9 +968,11 @@ OksFile::write(OksXmlOutputStream& xmls)
         xmls.put_attribute("creation-time", sizeof("creation-time") - 1, created_c_str.c_str());
       if (p_repository_name.empty())
         {
+          xmls.suspend_checksum(content_checksum, true);
           xmls.put_attribute("last-modified-by", sizeof("last-modified-by") - 1, p_last_modified_by.c_str());
           xmls.put_attribute("last-modified-on", sizeof("last-modified-on") - 1, p_last_modified_on.c_str());
           xmls.put_attribute("last-modification-time", sizeof("last-modification-time") - 1, last_modified_c_str.c_str());
+          xmls.suspend_checksum(content_checksum, false);
         }
       xmls.put_end_tag();
 
@@ -903,6 +1029,127 @@ OksFile::write(OksXmlOutputStream& xmls)
   p_is_on_disk = true;
 }
 
+
+  // read info, include and comments sections of binary snapshot
+
+OksFile::OksFile(oks::BinaryInputStream& s, const std::string& sp, const std::string& fp, OksKernel * k) :
+ p_short_name               (sp),
+ p_full_name                (fp),
+ p_number_of_parts          (1),
+ p_compression              (Uncompressed),
+ p_creation_time            (boost::posix_time::not_a_date_time),
+ p_last_modification_time   (boost::posix_time::not_a_date_time),
+ p_lock                     (),
+ p_is_updated               (false),
+ p_is_read_only             (true),
+ p_last_modified            (0),
+ p_repository_last_modified (0),
+ p_checksum                 (0),
+ p_content_checksum         (0),
+ p_is_on_disk               (true),
+ p_included_by              (0),
+ p_kernel                   (k),
+ p_journal_complete         (true)
+{
+  check_repository();
+
+  try {
+    p_oks_format = s.get_string();
+    p_logical_name = s.get_string();
+    p_type = s.get_string();
+    p_number_of_items = s.get<int64_t>();
+    p_created_by = s.get_string();
+    p_created_on = s.get_string();
+
+    if(const std::string& t = s.get_string(); !t.empty())
+      p_creation_time = oks::str2time(t.c_str(), t.size(), p_full_name.c_str());
+
+    p_last_modified_by = s.get_string();
+    p_last_modified_on = s.get_string();
+
+    if(const std::string& t = s.get_string(); !t.empty())
+      p_last_modification_time = oks::str2time(t.c_str(), t.size(), p_full_name.c_str());
+
+    for(uint32_t num = s.get<uint32_t>(); num; --num) {
+      p_list_of_include_files.push_back(s.get_string());
+    }
+
+    for(uint32_t num = s.get<uint32_t>(); num; --num) {
+      std::unique_ptr<oks::Comment> comment( new oks::Comment() );
+      const std::string& creation_time(s.get_string());
+
+      comment->p_created_by = s.get_string();
+      comment->p_created_on = s.get_string();
+      comment->p_author = s.get_string();
+      comment->p_text = s.get_string();
+
+      comment->validate(creation_time);
+
+      if(p_comments.find(creation_time) != p_comments.end()) {
+        std::ostringstream text;
+        text << "The comment created at \'" << creation_time << "\' was already defined in this file";
+        throw std::runtime_error(text.str().c_str());
+      }
+
+      p_comments[creation_time] = comment.release();
+    }
+  }
+  catch (oks::exception & e) {
+    throw oks::FailedRead("binary file info", e);
+  }
+  catch (std::exception & e) {
+    throw oks::FailedRead("binary file info", e.what());
+  }
+}
+
+
+void
+OksFile::write(oks::BinaryOutputStream& s, bool update_last_modified)
+{
+  try
+    {
+      if (update_last_modified && p_repository_name.empty())
+        {
+          p_last_modification_time = boost::posix_time::second_clock::universal_time();
+          p_last_modified_by = OksKernel::get_user_name();
+          p_last_modified_on = OksKernel::get_host_name();
+        }
+
+      s.put(p_oks_format);
+      s.put(p_logical_name);
+      s.put(p_type);
+      s.put(static_cast<int64_t>(p_number_of_items));
+      s.put(p_created_by);
+      s.put(p_created_on);
+      s.put(p_creation_time.is_not_a_date_time() ? std::string() : boost::posix_time::to_iso_string(p_creation_time));
+      s.put(p_last_modified_by);
+      s.put(p_last_modified_on);
+      s.put(p_last_modification_time.is_not_a_date_time() ? std::string() : boost::posix_time::to_iso_string(p_last_modification_time));
+
+      s.put(static_cast<uint32_t>(p_list_of_include_files.size()));
+
+      for (const auto& i : p_list_of_include_files)
+        s.put(i);
+
+      s.put(static_cast<uint32_t>(p_comments.size()));
+
+      for (const auto& i : p_comments)
+        {
+          s.put(i.first);
+          s.put(i.second->p_created_by);
+          s.put(i.second->p_created_on);
+          s.put(i.second->p_author);
+          s.put(i.second->p_text);
+        }
+    }
+  catch (std::exception& ex)
+    {
+      throw oks::FailedSave("oks-file", p_full_name, ex.what());
+    }
+
+  p_is_on_disk = true;
+}
+
 bool
 OksFile::is_repository_file() const
 {
@@ -1208,6 +1455,7 @@ OksFile::add_include_file(const std::string& s)
     // add include and mark file as updated
   p_list_of_include_files.push_back(s);
   p_is_updated = true;
+  p_journal_complete = false;
 }
 
 
@@ -1233,6 +1481,7 @@ OksFile::remove_include_file(const std::string& s)
     // remove include and mark file as updated
   p_list_of_include_files.erase(i);
   p_is_updated = true;
+  p_journal_complete = false;
 
     // close file, if it is not referenced by others
   p_kernel->k_close_dangling_includes();
@@ -1264,6 +1513,7 @@ OksFile::rename_include_file(const std::string& old_s, const std::string& new_s)
 
   (*i1) = new_s;
   p_is_updated = true;
+  p_journal_complete = false;
 }
 
 
@@ -1281,6 +1531,7 @@ OksFile::set_logical_name(const std::string& s)
 
   p_logical_name = s;
   p_is_updated = true;
+  p_journal_complete = false;
 }
 
 
@@ -1298,6 +1549,7 @@ OksFile::set_type(const std::string& s)
 
   p_type = s;
   p_is_updated = true;
+  p_journal_complete = false;
 }
 
 std::ostream& operator<<(std::ostream& s, const oks::Comment& c)
@@ -1401,6 +1653,90 @@ OksFile::update_status_of_file(bool update_local, bool update_repository)
 }
 
 
+static void
+put_hex_checksum(std::ostream& f, std::streamoff pos, uint64_t value)
+{
+  char buf[16];
+  std::fill_n(buf, sizeof(buf), '0');
+
+  char * end = std::to_chars(buf, buf + sizeof(buf), value, 16).ptr;
+  std::rotate(buf, end, buf + sizeof(buf));
+
+  f.seekp(pos);
+  f.write(buf, sizeof(buf));
+}
+
+static uint64_t
+get_hex_checksum(const char * value) noexcept
+{
+  uint64_t checksum;
+  const std::from_chars_result r = std::from_chars(value, value + 16, checksum, 16);
+
+  return ((r.ec == std::errc() && r.ptr == value + 16) ? checksum : 0);
+}
+
+  // the file and content checksums are started by write(xmls, ...) in this order
+
+void
+OksFile::write_checksums(OksXmlOutputStream& xmls, std::ostream * f)
+{
+  p_checksum = xmls.get_checksum(0);
+  p_content_checksum = xmls.get_checksum(1);
+
+  if (f)
+    {
+      const std::streamoff pos(sizeof(xml_file_header) - 1 + sizeof(xml_checksum_start) - 1);
+
+      put_hex_checksum(*f, pos, p_checksum);
+      put_hex_checksum(*f, pos + 16 + sizeof(xml_checksum_content) - 1, p_content_checksum);
+
+      f->seekp(0, std::ios_base::end);
+    }
+  else
+    {
+      p_checksum = 0;
+    }
+}
+
+uint64_t
+OksFile::read_checksum(const char * data, size_t len, uint64_t * content) noexcept
+{
+  const size_t header_len(sizeof(xml_file_header) - 1);
+  const size_t start_len(sizeof(xml_checksum_start) - 1);
+  const size_t content_len(sizeof(xml_checksum_content) - 1);
+
+  if (len < checksum_header_len)
+    return 0;
+
+  const char * value = data + header_len + start_len;
+  const char * content_value = value + 16 + content_len;
+
+  if (
+    memcmp(data, xml_file_header, header_len) ||
+    memcmp(data + header_len, xml_checksum_start, start_len) ||
+    memcmp(value + 16, xml_checksum_content, content_len) ||
+    memcmp(content_value + 16, xml_checksum_end, sizeof(xml_checksum_end) - 1)
+  )
+    return 0;
+
+  if (content)
+    *content = get_hex_checksum(content_value);
+
+  return get_hex_checksum(value);
+}
+
+uint64_t
+OksFile::verify_checksum(const char * data, size_t len) noexcept
+{
+  const uint64_t checksum(read_checksum(data, len));
+
+  if (checksum && oks::Checksum::calculate(data + checksum_header_len, len - checksum_header_len) == checksum)
+    return checksum;
+
+  return 0;
+}
+
+
 OksFile::FileStatus
 OksFile::get_status_of_file() const
 {
@@ -1415,6 +1751,22 @@ OksFile::get_status_of_file() const
     }
 
     if(buf.st_mtime != p_last_modified) {
+
+        // the file was rewritten (e.g. by another process saving the same contents); compare checksums
+
+      if(p_checksum && S_ISREG(buf.st_mode)) {
+        try {
+          oks::MappedFile m(p_full_name);
+
+          if(verify_checksum(m.data(), m.size()) == p_checksum) {
+            return FileNotModified;
+          }
+        }
+        catch(std::exception& ex) {
+          TLOG_DEBUG(2) << "cannot verify checksum of file \"" << p_full_name << "\": " << ex.what();
+        }
+      }
+
       return FileModified;
     }
 
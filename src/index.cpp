@@ -5,6 +5,15 @@
 #include "oks/class.hpp"
 
 
+  // the object used to search in index shares the value with caller and must not destroy it
+
+struct TestValueGuard {
+  OksData& p_data;
+  TestValueGuard(OksData& d) : p_data(d) { ; }
+  ~TestValueGuard() { p_data.type = OksData::unknown_type; }
+};
+
+
 size_t
 OksIndex::get_offset(OksClass *cl, OksAttribute *a)
 {
@@ -58,8 +67,10 @@ OksIndex::OksIndex(OksClass *cl, OksAttribute *attr) :
   (*c->p_indices)[a] = this;
 
   if(c->p_objects && !c->p_objects->empty()) {
-    for(OksObject::Map::iterator i = c->p_objects->begin(); i != c->p_objects->end(); ++i)
+    for(OksObject::Map::iterator i = c->p_objects->begin(); i != c->p_objects->end(); ++i) {
+      (*i).second->materialize();
       insert((*i).second);
+    }
   }
   
   std::cout << "Build index for attribute \'" << a->p_name << "\' in class \'" << c->get_name()
@@ -110,6 +121,7 @@ OksObject *
 OksIndex::FindFirst(OksData *d) const
 {
   OksObject test_o(offset, d);
+  TestValueGuard test_guard(test_o.data[offset]);
 
   ConstPosition pos = lower_bound(&test_o);
 
@@ -127,6 +139,7 @@ OksIndex::find_interval(OksData *d, OksQuery::Comparator f, ConstPosition& i1, C
   if(empty()) return;
 
   OksObject test_o(offset, d);
+  TestValueGuard test_guard(test_o.data[offset]);
 
   if(f == OksQuery::equal_cmp) {
     i1 = lower_bound(&test_o);
@@ -282,3 +295,644 @@ OksIndex::find_all(bool andOperation, OksData *d1, OksQuery::Comparator f1, OksD
 
   return olist;
 }
+
+
+OksHashIndex::OksHashIndex(OksClass *cl, OksAttribute *attr, bool subclasses) :
+  c         (cl),
+  a         (attr),
+  offset    (0),
+  p_subclasses (subclasses),
+  p_size    (0),
+  p_used_slots (0)
+{
+  const char * fname = "OksHashIndex::OksHashIndex(OksClass *, OksAttribute *, bool)";
+
+  if(!c) {
+    Oks::error_msg(fname) << "Can't build index for NIL class\n";
+    return;
+  }
+
+  if(c->get_is_abstract() && !p_subclasses) {
+    Oks::error_msg(fname)
+      << "Can't build index for ABSTRACT class \"" << c->get_name() << "\"\n";
+    c = nullptr;
+    return;
+  }
+
+  if(!a) {
+    Oks::error_msg(fname) << "Can't build index for NIL attribute\n";
+    c = nullptr;
+    return;
+  }
+
+  if(c->find_attribute(a->get_name()) == 0) {
+    Oks::error_msg(fname)
+      << "Can't find attribute \"" << a->get_name() << "\" in class \""
+      << c->get_name() << "\" to build index.\n";
+    c = nullptr;
+    return;
+  }
+
+  if(c->p_hash_indices && c->p_hash_indices->find(a) != c->p_hash_indices->end()) {
+    Oks::error_msg(fname)
+      << "Class \"" << c->get_name() << "\" already has hash index for attribute \""
+      << a->get_name() << "\".\n";
+    c = nullptr;
+    return;
+  }
+
+  offset = ((*c->p_data_info)[a->get_name()])->offset;
+
+  if(!c->p_hash_indices)
+    c->p_hash_indices = new OksHashIndex::Map();
+
+  (*c->p_hash_indices)[a] = this;
+
+  std::vector<const OksClass *> classes(1, c);
+
+  if(p_subclasses && c->p_all_sub_classes) {
+    classes.insert(classes.end(), c->p_all_sub_classes->begin(), c->p_all_sub_classes->end());
+  }
+
+  size_t num = 0;
+
+  for(const auto& x : classes) {
+    if(x->p_objects) num += x->p_objects->size();
+  }
+
+  if(num) {
+    rehash(num);
+
+    for(const auto& x : classes) {
+      if(x->p_objects) {
+        for(OksObject::Map::iterator i = x->p_objects->begin(); i != x->p_objects->end(); ++i) {
+          (*i).second->materialize();
+          insert((*i).second);
+        }
+      }
+    }
+  }
+
+  std::cout << "Build hash index for attribute \'" << a->get_name() << "\' in class \'" << c->get_name()
+  	    << (p_subclasses ? "\' and subclasses" : "\'") << " for " << size() << " instances\n";
+}
+
+OksHashIndex::~OksHashIndex()
+{
+  if(c && a) {
+    c->p_hash_indices->erase(a);
+
+    if(c->p_hash_indices->empty()) {
+      delete c->p_hash_indices;
+      c->p_hash_indices = 0;
+    }
+  }
+}
+
+
+  // resize the table to keep at least given number of values with load factor below 3/4
+
+void
+OksHashIndex::rehash(size_t num)
+{
+  size_t capacity = 16;
+  while(capacity * 3 <= num * 4) capacity *= 2;
+
+  std::vector<Slot> slots(capacity);
+  slots.swap(p_slots);
+
+  p_used_slots = 0;
+  const size_t mask = capacity - 1;
+
+  for(auto& x : slots) {
+    if(x.state == Slot::used) {
+      size_t pos = x.hash & mask;
+      while(p_slots[pos].state != Slot::empty) pos = (pos + 1) & mask;
+
+      p_slots[pos].hash = x.hash;
+      p_slots[pos].state = Slot::used;
+      p_slots[pos].objects.swap(x.objects);
+      p_used_slots++;
+    }
+  }
+}
+
+
+const OksHashIndex::Slot *
+OksHashIndex::find(const OksData& d, size_t hash) const
+{
+  if(p_slots.empty()) return nullptr;
+
+  const size_t mask = p_slots.size() - 1;
+
+  for(size_t pos = hash & mask; p_slots[pos].state != Slot::empty; pos = (pos + 1) & mask) {
+    const Slot& x(p_slots[pos]);
+    if(x.state == Slot::used && x.hash == hash && value(x.objects.front()) == d) {
+      return &x;
+    }
+  }
+
+  return nullptr;
+}
+
+
+  // the offset of attribute depends on class of object, if the index contains objects of subclasses
+
+inline const OksData&
+OksHashIndex::value(const OksObject * o) const
+{
+  const OksClass * cl(o->uid.class_id);
+  return o->data[(cl == c) ? offset : p_class_offsets.find(cl)->second];
+}
+
+
+void
+OksHashIndex::add_class(const OksClass * cl)
+{
+  if(cl != c && p_class_offsets.find(cl) == p_class_offsets.end()) {
+    p_class_offsets[cl] = cl->data_info(a->get_name())->offset;
+  }
+}
+
+
+void
+OksHashIndex::insert(OksObject *o)
+{
+  add_class(o->uid.class_id);
+
+  const OksData& d(value(o));
+  const size_t hash(d.hash());
+
+  if(Slot * x = const_cast<Slot *>(find(d, hash))) {
+    x->objects.push_back(o);
+    p_size++;
+    return;
+  }
+
+  if((p_used_slots + 1) * 4 >= p_slots.size() * 3) {
+    rehash(p_used_slots + 1);
+  }
+
+  const size_t mask = p_slots.size() - 1;
+
+  size_t pos = hash & mask;
+  while(p_slots[pos].state == Slot::used) pos = (pos + 1) & mask;
+
+  Slot& x(p_slots[pos]);
+
+  if(x.state == Slot::empty) p_used_slots++;
+
+  x.hash = hash;
+  x.state = Slot::used;
+  x.objects.push_back(o);
+
+  p_size++;
+}
+
+
+OksObject*
+OksHashIndex::remove_obj(OksObject *o)
+{
+  add_class(o->uid.class_id);
+
+  const OksData& d(value(o));
+  Slot * x = const_cast<Slot *>(find(d, d.hash()));
+
+  auto remove_from = [this,o](Slot& s) -> bool {
+    for(auto i = s.objects.begin(); i != s.objects.end(); ++i) {
+      if(*i == o) {
+        s.objects.erase(i);
+        if(s.objects.empty()) s.state = Slot::removed;
+        p_size--;
+        return true;
+      }
+    }
+    return false;
+  };
+
+  if(x && remove_from(*x)) return o;
+
+    // the value was changed without index update; find the object in all slots
+
+  for(auto& s : p_slots) {
+    if(s.state == Slot::used && remove_from(s)) return o;
+  }
+
+  return 0;
+}
+
+
+OksObject::List *
+OksHashIndex::FindEqual(const OksData *d) const
+{
+  p_number_of_lookups.fetch_add(1, std::memory_order_relaxed);
+
+  if(const Slot * x = find(*d, d->hash())) {
+    return new OksObject::List(x->objects.begin(), x->objects.end());
+  }
+
+  return 0;
+}
+
+
+OksCompositeIndex::OksCompositeIndex(OksClass *cl, const std::vector<OksAttribute *>& attrs, bool subclasses) :
+  c            (cl),
+  p_attributes (attrs),
+  p_subclasses (subclasses),
+  p_objects    (SortBy{this})
+{
+  const char * fname = "OksCompositeIndex::OksCompositeIndex(OksClass *, const std::vector<OksAttribute *>&, bool)";
+
+  if(!c) {
+    Oks::error_msg(fname) << "Can't build index for NIL class\n";
+    return;
+  }
+
+  if(c->get_is_abstract() && !p_subclasses) {
+    Oks::error_msg(fname)
+      << "Can't build index for ABSTRACT class \"" << c->get_name() << "\"\n";
+    c = nullptr;
+    return;
+  }
+
+  if(p_attributes.empty()) {
+    Oks::error_msg(fname) << "Can't build index without attributes\n";
+    c = nullptr;
+    return;
+  }
+
+  for(const auto& a : p_attributes) {
+    if(!a) {
+      Oks::error_msg(fname) << "Can't build index for NIL attribute\n";
+      c = nullptr;
+      return;
+    }
+
+    if(c->find_attribute(a->get_name()) == 0) {
+      Oks::error_msg(fname)
+        << "Can't find attribute \"" << a->get_name() << "\" in class \""
+        << c->get_name() << "\" to build index.\n";
+      c = nullptr;
+      return;
+    }
+
+    if(a->get_is_multi_values()) {
+      Oks::error_msg(fname)
+        << "Can't build index for multi-value attribute \"" << a->get_name() << "\" in class \""
+        << c->get_name() << "\".\n";
+      c = nullptr;
+      return;
+    }
+
+    p_offsets.push_back(((*c->p_data_info)[a->get_name()])->offset);
+  }
+
+  if(!c->p_composite_indices)
+    c->p_composite_indices = new OksCompositeIndex::List();
+
+  c->p_composite_indices->push_back(this);
+
+  std::vector<const OksClass *> classes(1, c);
+
+  if(p_subclasses && c->p_all_sub_classes) {
+    classes.insert(classes.end(), c->p_all_sub_classes->begin(), c->p_all_sub_classes->end());
+  }
+
+  for(const auto& x : classes) {
+    if(x->p_objects) {
+      for(OksObject::Map::iterator i = x->p_objects->begin(); i != x->p_objects->end(); ++i) {
+        (*i).second->materialize();
+        insert((*i).second);
+      }
+    }
+  }
+
+  std::cout << "Build composite index for attributes";
+  for(const auto& a : p_attributes) std::cout << " \'" << a->get_name() << '\'';
+  std::cout << " in class \'" << c->get_name() << (p_subclasses ? "\' and subclasses" : "\'") << " for " << size() << " instances\n";
+}
+
+OksCompositeIndex::~OksCompositeIndex()
+{
+  if(c) {
+    c->p_composite_indices->remove(this);
+
+    if(c->p_composite_indices->empty()) {
+      delete c->p_composite_indices;
+      c->p_composite_indices = 0;
+    }
+  }
+}
+
+
+  // the offsets of attributes depend on class of object, if the index contains objects of subclasses
+
+inline const size_t *
+OksCompositeIndex::offsets(const OksObject * o) const
+{
+  const OksClass * cl(o->uid.class_id);
+  return (cl == c) ? p_offsets.data() : p_class_offsets.find(cl)->second.data();
+}
+
+
+void
+OksCompositeIndex::add_class(const OksClass * cl)
+{
+  if(cl != c && p_class_offsets.find(cl) == p_class_offsets.end()) {
+    std::vector<size_t>& v(p_class_offsets[cl]);
+
+    for(const auto& a : p_attributes) {
+      v.push_back(cl->data_info(a->get_name())->offset);
+    }
+  }
+}
+
+
+void
+OksCompositeIndex::insert(OksObject * o)
+{
+  add_class(o->uid.class_id);
+  p_objects.insert(o);
+}
+
+
+int
+OksCompositeIndex::SortBy::compare(const OksObject * o1, const OksObject * o2) const
+{
+  const size_t * x1(index->offsets(o1));
+  const size_t * x2(index->offsets(o2));
+
+  for(size_t i = 0; i < index->p_offsets.size(); ++i) {
+    const OksData& d1(o1->data[x1[i]]);
+    const OksData& d2(o2->data[x2[i]]);
+
+    if(d1 < d2) return -1;
+    if(d2 < d1) return 1;
+  }
+
+  return 0;
+}
+
+
+int
+OksCompositeIndex::SortBy::compare(const OksObject * o, const Key& k) const
+{
+  const size_t * x(index->offsets(o));
+
+  for(size_t i = 0; i < k.num; ++i) {
+    const OksData& d1(o->data[x[i]]);
+    const OksData& d2(*k.values[i]);
+
+    if(d1 < d2) return -1;
+    if(d2 < d1) return 1;
+  }
+
+  return 0;
+}
+
+
+bool
+OksCompositeIndex::contains(const OksAttribute * a) const
+{
+  for(const auto& x : p_attributes) {
+    if(x->get_name() == a->get_name()) return true;
+  }
+
+  return false;
+}
+
+
+OksObject*
+OksCompositeIndex::remove_obj(OksObject *o)
+{
+  add_class(o->uid.class_id);
+
+  auto positions = p_objects.equal_range(o);
+
+  for(auto i = positions.first; i != positions.second; ++i) {
+    if(o == *i) {
+      p_objects.erase(i);
+      return o;
+    }
+  }
+
+    // the value was changed without index update
+
+  for(auto i = p_objects.begin(); i != p_objects.end(); ++i) {
+    if(o == *i) {
+      p_objects.erase(i);
+      return o;
+    }
+  }
+
+  return 0;
+}
+
+
+OksObject::List *
+OksCompositeIndex::find_all(const std::vector<const OksData *>& eq, const OksData * low, bool low_eq, const OksData * high, bool high_eq) const
+{
+  p_number_of_lookups.fetch_add(1, std::memory_order_relaxed);
+
+  std::vector<const OksData *> from(eq);
+  std::vector<const OksData *> to(eq);
+
+  if(low) from.push_back(low);
+  if(high) to.push_back(high);
+
+  const Key k1 {from.data(), from.size(), (low && !low_eq)};
+  const Key k2 {to.data(), to.size(), (high ? high_eq : true)};
+
+  auto i1 = p_objects.lower_bound(k1);
+
+  if(i1 == p_objects.end() || !p_objects.key_comp()(*i1, k2)) return 0;
+
+  auto i2 = p_objects.lower_bound(k2);
+
+  OksObject::List * olist = new OksObject::List();
+  for(; i1 != i2; ++i1) olist->push_back(*i1);
+
+  return olist;
+}
+
+
+OksInvertedIndex::OksInvertedIndex(OksClass *cl, OksAttribute *attr, bool subclasses) :
+  c         (cl),
+  a         (attr),
+  offset    (0),
+  p_subclasses (subclasses),
+  p_size    (0)
+{
+  const char * fname = "OksInvertedIndex::OksInvertedIndex(OksClass *, OksAttribute *, bool)";
+
+  if(!c) {
+    Oks::error_msg(fname) << "Can't build index for NIL class\n";
+    return;
+  }
+
+  if(c->get_is_abstract() && !p_subclasses) {
+    Oks::error_msg(fname)
+      << "Can't build index for ABSTRACT class \"" << c->get_name() << "\"\n";
+    c = nullptr;
+    return;
+  }
+
+  if(!a) {
+    Oks::error_msg(fname) << "Can't build index for NIL attribute\n";
+    c = nullptr;
+    return;
+  }
+
+  if(c->find_attribute(a->get_name()) == 0) {
+    Oks::error_msg(fname)
+      << "Can't find attribute \"" << a->get_name() << "\" in class \""
+      << c->get_name() << "\" to build index.\n";
+    c = nullptr;
+    return;
+  }
+
+  if(a->get_is_multi_values() == false) {
+    Oks::error_msg(fname)
+      << "Can't build inverted index for single-value attribute \"" << a->get_name() << "\" in class \""
+      << c->get_name() << "\".\n";
+    c = nullptr;
+    return;
+  }
+
+  if(c->p_inverted_indices && c->p_inverted_indices->find(a) != c->p_inverted_indices->end()) {
+    Oks::error_msg(fname)
+      << "Class \"" << c->get_name() << "\" already has inverted index for attribute \""
+      << a->get_name() << "\".\n";
+    c = nullptr;
+    return;
+  }
+
+  offset = ((*c->p_data_info)[a->get_name()])->offset;
+
+  if(!c->p_inverted_indices)
+    c->p_inverted_indices = new OksInvertedIndex::Map();
+
+  (*c->p_inverted_indices)[a] = this;
+
+  std::vector<const OksClass *> classes(1, c);
+
+  if(p_subclasses && c->p_all_sub_classes) {
+    classes.insert(classes.end(), c->p_all_sub_classes->begin(), c->p_all_sub_classes->end());
+  }
+
+  for(const auto& x : classes) {
+    if(x->p_objects) {
+      for(OksObject::Map::iterator i = x->p_objects->begin(); i != x->p_objects->end(); ++i) {
+        (*i).second->materialize();
+        insert((*i).second);
+      }
+    }
+  }
+
+  std::cout << "Build inverted index for attribute \'" << a->get_name() << "\' in class \'" << c->get_name()
+  	    << (p_subclasses ? "\' and subclasses" : "\'") << " for " << size() << " instances and "
+            << number_of_items() << " items\n";
+}
+
+OksInvertedIndex::~OksInvertedIndex()
+{
+  if(c && a) {
+    c->p_inverted_indices->erase(a);
+
+    if(c->p_inverted_indices->empty()) {
+      delete c->p_inverted_indices;
+      c->p_inverted_indices = 0;
+    }
+  }
+}
+
+
+  // the offset of attribute depends on class of object, if the index contains objects of subclasses
+
+inline const OksData&
+OksInvertedIndex::value(const OksObject * o) const
+{
+  const OksClass * cl(o->uid.class_id);
+  return o->data[(cl == c) ? offset : p_class_offsets.find(cl)->second];
+}
+
+
+void
+OksInvertedIndex::add_class(const OksClass * cl)
+{
+  if(cl != c && p_class_offsets.find(cl) == p_class_offsets.end()) {
+    p_class_offsets[cl] = cl->data_info(a->get_name())->offset;
+  }
+}
+
+
+void
+OksInvertedIndex::insert(OksObject *o)
+{
+  add_class(o->uid.class_id);
+
+  const OksData& d(value(o));
+
+  if(d.type == OksData::list_type && d.data.LIST && !d.data.LIST->empty()) {
+    for(const auto& x : *d.data.LIST) {
+      p_items[*x].insert(o);
+    }
+
+    p_size++;
+  }
+}
+
+
+OksObject*
+OksInvertedIndex::remove_obj(OksObject *o)
+{
+  add_class(o->uid.class_id);
+
+  const OksData& d(value(o));
+
+  if(d.type != OksData::list_type || !d.data.LIST || d.data.LIST->empty()) return 0;
+
+  bool found = false;
+
+  for(const auto& x : *d.data.LIST) {
+    auto i = p_items.find(*x);
+
+    if(i != p_items.end() && i->second.erase(o)) {
+      found = true;
+      if(i->second.empty()) p_items.erase(i);
+    }
+  }
+
+    // the value was changed without index update; remove the object from all items
+
+  if(!found) {
+    for(auto i = p_items.begin(); i != p_items.end();) {
+      if(i->second.erase(o)) found = true;
+
+      if(i->second.empty()) i = p_items.erase(i);
+      else ++i;
+    }
+  }
+
+  if(found) {
+    p_size--;
+    return o;
+  }
+
+  return 0;
+}
+
+
+OksObject::List *
+OksInvertedIndex::FindContaining(const OksData *d) const
+{
+  p_number_of_lookups.fetch_add(1, std::memory_order_relaxed);
+
+  auto i = p_items.find(*d);
+
+  if(i != p_items.end()) {
+    return new OksObject::List(i->second.begin(), i->second.end());
+  }
+
+  return 0;
+}
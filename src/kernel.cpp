@@ -1,6 +1,7 @@
 #define _OksBuildDll_
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,6 +12,7 @@
 #include <sys/wait.h>
 
 #include <algorithm>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -21,6 +23,10 @@
 #include <cstring>
 #include <ctime>
 
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
+
 #include "ers/ers.hpp"
 #include "logging/Logging.hpp"
 
@@ -43,6 +49,7 @@
 #include "oks/profiler.hpp"
 #include "oks/pipeline.hpp"
 #include "oks/cstring.hpp"
+#include "oks/visitor.hpp"
 
 #include "oks_utils.h"
 
@@ -511,6 +518,87 @@ get_file_length(std::ifstream& f)
   return file_length;
 }
 
+  // opens xml stream reading the file mapped into memory or via file stream,
+  // returns the stream and length of file; the compressed file is decompressed into memory
+
+static std::shared_ptr<OksXmlInputStream>
+open_xml_stream(const char * fname, const std::string& file_name, bool use_mapped_file, long& file_length, OksFile::Compression * compression = nullptr)
+{
+  const OksFile::Compression c(oks::get_compression(file_name));
+
+  if(compression) {
+    *compression = c;
+  }
+
+  if(c != OksFile::Uncompressed) {
+    std::shared_ptr<oks::MappedFile> m;
+
+    try {
+      m = oks::decompress_file(file_name, c);
+    }
+    catch(std::exception& ex) {
+      throw std::runtime_error(std::string(fname) + "(): " + ex.what());
+    }
+
+    file_length = m->size();
+
+    return std::shared_ptr<OksXmlInputStream>(new OksXmlInputStream(m));
+  }
+
+  if(use_mapped_file) {
+    std::shared_ptr<oks::MappedFile> m;
+
+    try {
+      m.reset(new oks::MappedFile(file_name));
+    }
+    catch(std::exception& ex) {
+      throw std::runtime_error(std::string(fname) + "(): " + ex.what());
+    }
+
+    file_length = m->size();
+
+    return std::shared_ptr<OksXmlInputStream>(new OksXmlInputStream(m));
+  }
+  else {
+    std::shared_ptr<std::ifstream> f(new std::ifstream(file_name.c_str()));
+
+    if(!f->good()) {
+      throw std::runtime_error(std::string(fname) + "(): cannot open file");
+    }
+
+    file_length = get_file_length(*f);
+
+    return std::shared_ptr<OksXmlInputStream>(new OksXmlInputStream(f));
+  }
+}
+
+  // opens binary stream on file mapped into memory
+
+static std::shared_ptr<oks::BinaryInputStream>
+open_binary_stream(const char * fname, const std::string& file_name)
+{
+  std::shared_ptr<oks::MappedFile> m;
+
+  try {
+    m.reset(new oks::MappedFile(file_name));
+  }
+  catch(std::exception& ex) {
+    throw std::runtime_error(std::string(fname) + "(): " + ex.what());
+  }
+
+  return std::shared_ptr<oks::BinaryInputStream>(new oks::BinaryInputStream(m));
+}
+
+  // returns name of parse cache image of given file
+
+static std::string
+make_cache_image_name(const std::string& cache_dir, const std::string& file_name)
+{
+  std::ostringstream s;
+  s << cache_dir << '/' << std::hex << oks::BinaryFormat::hash(file_name.data(), file_name.size()) << ".oks-cache";
+  return s.str();
+}
+
   // makes name of function with parameters for methods working with files
 
 std::string
@@ -690,6 +778,56 @@ OksKernel::get_tmp_file(const std::string& file)
   return s3;
 }
 
+
+  // flush contents of written file to storage device according to durability level
+
+static void
+sync_file(const std::string& file_name, OksKernel::DurabilityLevel level)
+{
+  if(level == OksKernel::NoSync) {
+    return;
+  }
+
+  const int fd = open(file_name.c_str(), O_RDONLY);
+
+  if(fd < 0) {
+    throw std::runtime_error("cannot open file \'" + file_name + "\' to flush it: " + oks::strerror(errno));
+  }
+
+  const int code = (level == OksKernel::FullSync ? fsync(fd) : fdatasync(fd));
+  const int error(errno);
+
+  close(fd);
+
+  if(code != 0) {
+    throw std::runtime_error("cannot flush file \'" + file_name + "\': " + oks::strerror(error));
+  }
+}
+
+
+  // flush directory of renamed file, if full durability is required
+
+static void
+sync_directory(const std::string& file_name, OksKernel::DurabilityLevel level)
+{
+  if(level != OksKernel::FullSync) {
+    return;
+  }
+
+  const std::string::size_type idx = file_name.rfind('/');
+  const std::string dir_name(idx == std::string::npos ? std::string(".") : idx == 0 ? std::string("/") : file_name.substr(0, idx));
+
+  const int fd = open(dir_name.c_str(), O_RDONLY | O_DIRECTORY);
+
+  if(fd < 0 || fsync(fd) != 0) {
+    const int error(errno);
+    if(fd >= 0) close(fd);
+    throw std::runtime_error("cannot flush directory \'" + dir_name + "\': " + oks::strerror(error));
+  }
+
+  close(fd);
+}
+
 const char *
 OksKernel::get_cwd()
 {
@@ -743,6 +881,14 @@ OksKernel::OksKernel(bool sm, bool vm, bool tm, bool allow_repository, const cha
   p_allow_duplicated_classes                  (true),
   p_allow_duplicated_objects                  (false),
   p_test_duplicated_objects_via_inheritance   (false),
+  p_use_mapped_files                          (false),
+  p_split_data_files                          (false),
+  p_lazy_objects                              (false),
+  p_parallel_save                             (false),
+  p_journal                                   (false),
+  p_shared_strings                            (false),
+  p_file_arenas                               (false),
+  p_durability_level                          (NoSync),
   p_user_repository_root_inited               (false),
   p_user_repository_root_created              (false),
   p_active_schema                             (nullptr),
@@ -769,7 +915,14 @@ OksKernel::OksKernel(bool sm, bool vm, bool tm, bool allow_repository, const cha
     {"OKS_KERNEL_ALLOW_DUPLICATED_CLASSES",                p_allow_duplicated_classes                },
     {"OKS_KERNEL_ALLOW_DUPLICATED_OBJECTS",                p_allow_duplicated_objects                },
     {"OKS_KERNEL_TEST_DUPLICATED_OBJECTS_VIA_INHERITANCE", p_test_duplicated_objects_via_inheritance },
-    {"OKS_KERNEL_SKIP_STRING_RANGE",                       p_skip_string_range                       }
+    {"OKS_KERNEL_SKIP_STRING_RANGE",                       p_skip_string_range                       },
+    {"OKS_KERNEL_USE_MAPPED_FILES",                        p_use_mapped_files                        },
+    {"OKS_KERNEL_SPLIT_DATA_FILES",                        p_split_data_files                        },
+    {"OKS_KERNEL_LAZY_OBJECTS",                            p_lazy_objects                            },
+    {"OKS_KERNEL_PARALLEL_SAVE",                           p_parallel_save                           },
+    {"OKS_KERNEL_JOURNAL",                                 p_journal                                 },
+    {"OKS_KERNEL_SHARED_STRINGS",                          p_shared_strings                          },
+    {"OKS_KERNEL_FILE_ARENAS",                             p_file_arenas                             }
   };
 
   for(unsigned int i = 0; i < sizeof(vars) / sizeof(__InitFromEnv__); ++i) {
@@ -778,6 +931,19 @@ OksKernel::OksKernel(bool sm, bool vm, bool tm, bool allow_repository, const cha
     }
   }
 
+  if(const char * s = getenv("OKS_KERNEL_CACHE_DIR")) {
+    p_cache_dir = s;
+  }
+
+  if(const char * s = getenv("OKS_KERNEL_DURABILITY")) {
+    if(!strcmp(s, "fsync")) {
+      p_durability_level = FullSync;
+    }
+    else if(!strcmp(s, "fdatasync")) {
+      p_durability_level = DataSync;
+    }
+  }
+
   {
     const char * oks_db_root = getenv("OKS_DB_ROOT");
 
@@ -929,6 +1095,15 @@ OksKernel::OksKernel(const OksKernel& src, bool copy_repository) :
   p_allow_duplicated_classes                  (src.p_allow_duplicated_classes),
   p_allow_duplicated_objects                  (src.p_allow_duplicated_objects),
   p_test_duplicated_objects_via_inheritance   (src.p_test_duplicated_objects_via_inheritance),
+  p_use_mapped_files                          (src.p_use_mapped_files),
+  p_split_data_files                          (src.p_split_data_files),
+  p_lazy_objects                              (src.p_lazy_objects),
+  p_parallel_save                             (src.p_parallel_save),
+  p_journal                                   (src.p_journal),
+  p_shared_strings                            (src.p_shared_strings),
+  p_file_arenas                               (src.p_file_arenas),
+  p_durability_level                          (src.p_durability_level),
+  p_cache_dir                                 (src.p_cache_dir),
   p_user_repository_root                      (src.p_user_repository_root),
   p_user_repository_root_inited               (src.p_user_repository_root_inited),
   p_user_repository_root_created              (false),
@@ -1194,6 +1369,7 @@ OksKernel::OksKernel(const OksKernel& src, bool copy_repository) :
 
     for(OksObject::Set::const_iterator i = src.p_objects.begin(); i != src.p_objects.end(); ++i, ++idx) {
       OksObject * src_o(*i);
+      src_o->materialize();
       src_o->p_user_data = reinterpret_cast<void *>(idx);
 
       OksClass * c = c_table[src_o->uid.class_id->p_id];
@@ -1209,7 +1385,7 @@ OksKernel::OksKernel(const OksKernel& src, bool copy_repository) :
 
       o_table[idx] = o;
       (*c->p_objects)[&o->uid.object_id] = o;
-      p_objects.insert(o);
+      define(o);
 
       if(size_t num_of_attrs = c->number_of_all_attributes()) {
         const OksData * src_data = src_o->data;
@@ -1826,48 +2002,79 @@ OksKernel::k_load_file(const std::string& short_file_name, bool bind, const OksF
     i = p_data_files.find(&full_file_name);
     if(i != p_data_files.end()) return i->second->check_parent(parent_h);
 
-    std::shared_ptr<std::ifstream> f(new std::ifstream(full_file_name.c_str()));
+      // binary snapshot of data file
 
-    if(f->good()) {
-      long file_length(get_file_length(*f));
-      
-      if(!file_length) {
-        throw std::runtime_error("k_load_file(): file is empty");
+    if(oks::BinaryFormat::test(full_file_name)) {
+      std::shared_ptr<oks::BinaryInputStream> bins(open_binary_stream("k_load_file", full_file_name));
+      OksFile * file_h = new OksFile(*bins, short_file_name, full_file_name, this);
+
+      if(file_h->p_oks_format == "schema") {
+        delete file_h;
+        throw std::runtime_error("k_load_file(): schema image can only be loaded from parse cache");
       }
 
-        // read file header and decide what to load
+      k_load_binary_data(file_h, bins, bins->size(), bind, parent_h, pipeline);
+      OSK_VERBOSE_REPORT("LEAVE " << fname)
+      return file_h;
+    }
 
-      std::shared_ptr<OksXmlInputStream> xmls(new OksXmlInputStream(f));
+      // image of schema or data file in parse cache
 
-      OksFile * file_h = new OksFile(xmls, short_file_name, full_file_name, this);
+    std::string cache_key;
 
-      if(file_h->p_oks_format.size() == 6 && oks::cmp_str6n(file_h->p_oks_format.c_str(), "schema")) {
-        k_load_schema(file_h, xmls, parent_h);
+    if(!p_cache_dir.empty()) {
+      if(OksFile * file_h = k_load_cached_file(short_file_name, full_file_name, bind, parent_h, pipeline, cache_key, 0)) {
+        OSK_VERBOSE_REPORT("LEAVE " << fname)
+        return file_h;
       }
-      else {
-        char format;
-
-        if(file_h->p_oks_format.size() == 4 && oks::cmp_str4n(file_h->p_oks_format.c_str(), "data"))
-          format = 'n';
-        else if(file_h->p_oks_format.size() == 8 && oks::cmp_str8n(file_h->p_oks_format.c_str(), "extended"))
-          format = 'X';
-        else if(file_h->p_oks_format.size() == 7 && oks::cmp_str7n(file_h->p_oks_format.c_str(), "compact"))
-          format = 'c';
-        else {
-          delete file_h;
-          throw std::runtime_error("k_load_file(): failed to parse header");
-        }
+    }
 
-        k_load_data(file_h, format, xmls, file_length, bind, parent_h, pipeline);
-      }
+    long file_length;
+    OksFile::Compression compression;
+    std::shared_ptr<OksXmlInputStream> xmls(open_xml_stream("k_load_file", full_file_name, p_use_mapped_files, file_length, &compression));
 
-      OSK_VERBOSE_REPORT("LEAVE " << fname)
+    if(!file_length) {
+      throw std::runtime_error("k_load_file(): file is empty");
+    }
 
-      return file_h;
+      // read file header and decide what to load
+
+    OksFile * file_h = new OksFile(xmls, short_file_name, full_file_name, this);
+
+    file_h->p_cache_key = cache_key;
+    file_h->p_compression = compression;
+
+    if(file_h->p_oks_format.size() == 6 && oks::cmp_str6n(file_h->p_oks_format.c_str(), "schema")) {
+      k_load_schema(file_h, xmls, parent_h);
+
+      if(!cache_key.empty()) {
+        k_write_cache_image(file_h, false);
+      }
     }
     else {
-      throw std::runtime_error("k_load_file(): cannot open file");
+      char format;
+
+      if(file_h->p_oks_format.size() == 4 && oks::cmp_str4n(file_h->p_oks_format.c_str(), "data"))
+        format = 'n';
+      else if(file_h->p_oks_format.size() == 8 && oks::cmp_str8n(file_h->p_oks_format.c_str(), "extended"))
+        format = 'X';
+      else if(file_h->p_oks_format.size() == 7 && oks::cmp_str7n(file_h->p_oks_format.c_str(), "compact"))
+        format = 'c';
+      else {
+        delete file_h;
+        throw std::runtime_error("k_load_file(): failed to parse header");
+      }
+
+      if(!cache_key.empty()) {
+        p_cache_images.push_back(file_h);
+      }
+
+      k_load_data(file_h, format, xmls, file_length, bind, parent_h, pipeline);
     }
+
+    OSK_VERBOSE_REPORT("LEAVE " << fname)
+
+    return file_h;
   }
   catch (oks::exception & e) {
     throw oks::FailedLoadFile("file", full_file_name, e);
@@ -2084,12 +2291,6 @@ OksKernel::k_preload_includes(OksFile * fp, std::set<OksFile *>& new_files_h, bo
   bool found_include_changes(false);
 
   try {
-    std::shared_ptr<std::ifstream> file(new std::ifstream(fp->get_full_file_name().c_str()));
-
-    if(!file->good()) {
-      throw std::runtime_error(std::string("k_preload_includes(): cannot open file \"") + fp->get_full_file_name() + '\"');
-    }
-
       // keep included files
 
     std::set<std::string> included;
@@ -2100,23 +2301,20 @@ OksKernel::k_preload_includes(OksFile * fp, std::set<OksFile *>& new_files_h, bo
       }
     }
 
-      // get size of file and check that it is not empty
-
-    file->seekg(0, std::ios::end);
+      // open file and check that it is not empty
 
-    long file_length = static_cast<std::streamoff>(file->tellg());
+    long file_length;
+    OksFile::Compression compression;
+    std::shared_ptr<OksXmlInputStream> xmls(open_xml_stream("k_preload_includes", fp->get_full_file_name(), false, file_length, &compression));
 
     if(file_length == 0) {
       throw std::runtime_error(std::string("k_preload_includes(): file \"") + fp->get_full_file_name() + "\" is empty");
     }
 
-    file->seekg(0, std::ios::beg);
-
-    std::shared_ptr<OksXmlInputStream> xmls(new OksXmlInputStream(file));
-
     {
       OksFile fp2(xmls, fp->get_short_file_name(), fp->get_full_file_name(), this);
       fp2.p_included_by = fp->p_included_by;
+      fp2.p_compression = compression;
       p_preload_file_info[fp] = new OksFile(*fp);
       *fp = fp2;
 
@@ -2335,17 +2533,23 @@ OksKernel::k_load_schema(const std::string& short_file_name, const OksFile * par
       return fp->check_parent(parent_h);
     }
 
-    {
-      std::shared_ptr<std::ifstream> f(new std::ifstream(full_file_name.c_str()));
+    std::string cache_key;
 
-      if(!f->good()) {
-        throw std::runtime_error("k_load_schema(): cannot open file");
+    if(!p_cache_dir.empty()) {
+      if((fp = k_load_cached_file(short_file_name, full_file_name, false, parent_h, nullptr, cache_key, 's')) != nullptr) {
+        OSK_VERBOSE_REPORT("LEAVE " << fname)
+        return fp;
       }
+    }
 
-      std::shared_ptr<OksXmlInputStream> xmls(new OksXmlInputStream(f));
+    {
+      long file_length;
+      std::shared_ptr<OksXmlInputStream> xmls(open_xml_stream("k_load_schema", full_file_name, p_use_mapped_files, file_length));
 
       fp = new OksFile(xmls, short_file_name, full_file_name, this);
 
+      fp->p_cache_key = cache_key;
+
       if(fp->p_oks_format.empty()) {
         throw std::runtime_error("k_load_schema(): failed to read header of file");
       }
@@ -2355,6 +2559,10 @@ OksKernel::k_load_schema(const std::string& short_file_name, const OksFile * par
 
       k_load_schema(fp, xmls, parent_h);
 
+      if(!cache_key.empty()) {
+        k_write_cache_image(fp, false);
+      }
+
       OSK_VERBOSE_REPORT("LEAVE " << fname)
 
       return fp;
@@ -2450,27 +2658,131 @@ OksKernel::k_load_schema(OksFile * fp, std::shared_ptr<OksXmlInputStream> xmls,
 
     fp->p_size = xmls->get_position();
 
-    registrate_all_classes(true);
+    k_registrate_loaded_classes(set);
+
+    fp->update_status_of_file();
+  }
+  catch (oks::exception & e) {
+    throw oks::FailedLoadFile("schema file", fp->get_full_file_name(), e);
+  }
+  catch (std::exception & e) {
+    throw oks::FailedLoadFile("schema file", fp->get_full_file_name(), e.what());
+  }
+  catch (...) {
+    throw oks::FailedLoadFile("schema file", fp->get_full_file_name(), "caught unknown exception");
+  }
+}
 
-    if(OksClass::create_notify_fn)
-      for(std::list<OksClass *>::iterator i2 = set.begin(); i2 != set.end(); ++i2)
-        (*OksClass::create_notify_fn)(*i2);
 
-    if(OksClass::change_notify_fn) {
-      std::set<OksClass *> set2;
+  // registrate classes of loaded schema file and notify about them
 
-      for(std::list<OksClass *>::iterator i2 = set.begin(); i2 != set.end(); ++i2) {
-        OksClass * c = *i2;
-        if(c->p_all_sub_classes && !c->p_all_sub_classes->empty()) {
-          for(OksClass::FList::iterator i3 = c->p_all_sub_classes->begin(); i3 != c->p_all_sub_classes->end(); ++i3) {
-            if(set2.find(*i3) == set2.end()) {
-              (*OksClass::change_notify_fn)(*i3, OksClass::ChangeSuperClassesList, (const void *)(&(c->p_name)));
-              set2.insert(*i3);
-            }
+void
+OksKernel::k_registrate_loaded_classes(const std::list<OksClass *>& set)
+{
+  registrate_all_classes(true);
+
+  if(OksClass::create_notify_fn)
+    for(std::list<OksClass *>::const_iterator i2 = set.begin(); i2 != set.end(); ++i2)
+      (*OksClass::create_notify_fn)(*i2);
+
+  if(OksClass::change_notify_fn) {
+    std::set<OksClass *> set2;
+
+    for(std::list<OksClass *>::const_iterator i2 = set.begin(); i2 != set.end(); ++i2) {
+      OksClass * c = *i2;
+      if(c->p_all_sub_classes && !c->p_all_sub_classes->empty()) {
+        for(OksClass::FList::iterator i3 = c->p_all_sub_classes->begin(); i3 != c->p_all_sub_classes->end(); ++i3) {
+          if(set2.find(*i3) == set2.end()) {
+            (*OksClass::change_notify_fn)(*i3, OksClass::ChangeSuperClassesList, (const void *)(&(c->p_name)));
+            set2.insert(*i3);
           }
         }
       }
     }
+  }
+}
+
+
+  // kernel method; returns false, if the image does not match loaded schema files
+
+bool
+OksKernel::k_load_schema_image(OksFile * fp, oks::BinaryInputStream& bins, long file_length, const OksFile * parent_h)
+{
+  OSK_PROFILING(OksProfiler::KernelLoadSchema, this)
+
+  fp->p_included_by = parent_h;
+  check_read_only(fp);
+
+  std::list<OksClass *> set;
+
+  try {
+    k_load_includes(*fp, 0);
+
+      // the inheritance closures are only valid, if the files defining superclasses were not changed
+
+    for(uint32_t num = bins.get<uint32_t>(); num; --num) {
+      const std::string& name(bins.get_string());
+      const std::string& key(bins.get_string());
+
+      const OksFile * f = find_schema_file(name);
+
+      if(f == nullptr || f->p_cache_key != key) {
+        TLOG_DEBUG(2) << "superclasses file \"" << name << "\" of schema image of file \"" << fp->get_full_file_name() << "\" was changed";
+        return false;
+      }
+    }
+
+    std::vector<OksClass *> classes(bins.get<uint32_t>(), nullptr);
+
+    try {
+      for(auto& c : classes) {
+        c = new OksClass(bins, this);
+
+        if(p_classes.find(c->get_name().c_str()) != p_classes.end()) {
+          throw std::runtime_error(std::string("class \"") + c->get_name() + "\" was already loaded");
+        }
+      }
+    }
+    catch(std::exception& ex) {
+      TLOG_DEBUG(2) << "cannot use schema image of file \"" << fp->get_full_file_name() << "\": " << ex.what();
+
+      for(auto& c : classes) {
+        if(c) {
+          c->p_transient = true;
+          delete c;
+        }
+      }
+
+      return false;
+    }
+
+    if(!p_silence) {
+      std::lock_guard lock(p_parallel_out_mutex);
+      std::cout << (parent_h ? " * loading " : "Loading ") << classes.size() << " classes from file \"" << fp->get_full_file_name() << "\" (parse cache)...\n";
+      if(parent_h == 0 && fp->get_full_file_name() != fp->get_short_file_name()) {
+        std::cout << "(non-fully-qualified filename was \"" << fp->get_short_file_name() << "\")\n";
+      }
+    }
+
+    add_schema_file(fp);
+
+    {
+      std::unique_lock lock(p_schema_mutex);  // protect schema and all objects from changes
+
+      for(auto& c : classes) {
+        p_classes[c->get_name().c_str()] = c;
+        c->p_file = fp;
+        if(OksClass::create_notify_fn) set.push_back(c);
+      }
+
+      for(auto& c : classes) {
+        c->registrate_class(bins);
+      }
+    }
+
+    fp->p_size = file_length;
+
+    k_registrate_loaded_classes(set);
 
     fp->update_status_of_file();
   }
@@ -2480,9 +2792,8 @@ OksKernel::k_load_schema(OksFile * fp, std::shared_ptr<OksXmlInputStream> xmls,
   catch (std::exception & e) {
     throw oks::FailedLoadFile("schema file", fp->get_full_file_name(), e.what());
   }
-  catch (...) {
-    throw oks::FailedLoadFile("schema file", fp->get_full_file_name(), "caught unknown exception");
-  }
+
+  return true;
 }
 
 
@@ -2657,7 +2968,7 @@ OksKernel::k_save_schema(OksFile * pf, bool force, OksFile * fh, const OksClass:
       pf->p_number_of_items = numberOfClasses;
       pf->p_oks_format = "schema";
 
-      pf->write(xmls);
+      pf->write(xmls, true);
 
 
         // write oks classes
@@ -2704,11 +3015,15 @@ OksKernel::k_save_schema(OksFile * pf, bool force, OksFile * fh, const OksClass:
       xmls.put_last_tag("oks-schema", sizeof("oks-schema")-1);
 
 
-        // flush the buffers
+        // flush the buffers and store checksums of written contents
+
+      pf->write_checksums(xmls, &f);
 
       f.close();
     }
 
+    sync_file(tmp_file_name, p_durability_level);
+
     if(rename(tmp_file_name.c_str(), pf->p_full_name.c_str())) {
       std::ostringstream text;
       text << "cannot rename \'" << tmp_file_name << "\' to \'" << pf->p_full_name << '\'';
@@ -2717,6 +3032,8 @@ OksKernel::k_save_schema(OksFile * pf, bool force, OksFile * fh, const OksClass:
 
     tmp_file_name.erase(0);
 
+    sync_directory(pf->p_full_name, p_durability_level);
+
     if(pf != p_active_schema) {
       try {
         pf->unlock();
@@ -3119,19 +3436,50 @@ struct OksLoadObjectsJob : public OksJob
 {
   public:
 
-    OksLoadObjectsJob( OksKernel * kernel, OksFile * fp, std::shared_ptr<OksXmlInputStream> xmls, char format)
+      // shared by jobs reading parts of the same file
+
+    struct Parts {
+      Parts(size_t num) : m_number_of_items(0), m_not_finished(num) { ; }
+      std::atomic<long> m_number_of_items;
+      std::atomic<size_t> m_not_finished;
+    };
+
+    OksLoadObjectsJob( OksKernel * kernel, OksFile * fp, std::shared_ptr<OksXmlInputStream> xmls, char format, std::shared_ptr<Parts> parts = nullptr, bool lazy = false)
       : m_kernel (kernel),
         m_fp     (fp),
         m_xmls   (xmls),
-        m_format (format)
+        m_format (format),
+        m_parts  (parts),
+        m_lazy   (lazy)
     { ; }       
 
+    OksLoadObjectsJob( OksKernel * kernel, OksFile * fp, std::shared_ptr<oks::BinaryInputStream> bins)
+      : m_kernel (kernel),
+        m_fp     (fp),
+        m_format ('b'),
+        m_bins   (bins),
+        m_lazy   (false)
+    { ; }
+
 
     void run()
     {
+      if(m_parts) {
+        run_part();
+        return;
+      }
+
+      if(m_bins) {
+        run_binary();
+        return;
+      }
+
+      oks::Arena arena;
+      oks::Arena::Scope arena_scope(m_kernel->get_file_arenas_mode() ? &arena : nullptr);
+
       try {
         OksAliasTable alias_table;
-        oks::ReadFileParams read_params( m_fp, *m_xmls, ((m_format == 'X') ? 0 : &alias_table), m_kernel, m_format, 0 );
+        oks::ReadFileParams read_params( m_fp, *m_xmls, ((m_format == 'X') ? 0 : &alias_table), m_kernel, m_format, 0, m_lazy );
 
         m_fp->p_number_of_items = 0;
 
@@ -3159,44 +3507,209 @@ struct OksLoadObjectsJob : public OksJob
     OksFile * m_fp;
     std::shared_ptr<OksXmlInputStream> m_xmls;
     char m_format;
+    std::shared_ptr<Parts> m_parts;
+    std::shared_ptr<oks::BinaryInputStream> m_bins;
+    bool m_lazy;
 
 
-      // protect usage of copy constructor and assignment operator
+      // read objects from a part of file; the last finished job sets file's statistics
 
-  private:
+    void run_part()
+    {
+      oks::Arena arena;
+      oks::Arena::Scope arena_scope(m_kernel->get_file_arenas_mode() ? &arena : nullptr);
 
-    OksLoadObjectsJob(const OksLoadObjectsJob&);
-    OksLoadObjectsJob& operator=(const OksLoadObjectsJob &);
+      try {
+        OksAliasTable alias_table;
+        oks::ReadFileParams read_params( m_fp, *m_xmls, ((m_format == 'X') ? 0 : &alias_table), m_kernel, m_format, 0, m_lazy );
 
-};
+        while(!m_xmls->at_end() && OksObject::read(read_params)) {
+          m_parts->m_number_of_items++;
+        }
+      }
+      catch (std::exception& ex) {
+	m_kernel->p_load_errors.add_error(*m_fp, ex);
+      }
 
-/******************************************************************************/
+      if(--m_parts->m_not_finished == 0) {
+        m_fp->p_number_of_items = m_parts->m_number_of_items;
+        m_fp->p_size = m_xmls->get_mapped_file()->size();
+      }
+    }
 
-static bool _find_file(const OksFile::Map & files, const OksFile * f)
-{
-  for(OksFile::Map::const_iterator i = files.begin(); i != files.end(); ++i) {
-    if(i->second == f) return true;
-  }
-  return false;
-}
 
-void
-oks::ReloadObjects::put(OksObject * o)
-{
-  config::map<OksObject *> *& c = data[o->uid.class_id];
-  if(!c) c = new config::map<OksObject *>();
-  (*c)[o->GetId()] = o;
-}
+      // read objects from binary snapshot
 
-OksObject *
-oks::ReloadObjects::pop(const OksClass* c, const std::string& id)
-{
-  std::map< const OksClass *, config::map<OksObject *> * >::iterator i = data.find(c);
-  if(i != data.end()) {
-    config::map<OksObject *>::iterator j = i->second->find(id);
-    if(j != i->second->end()) {
-      OksObject * o = j->second;
-      i->second->erase(j);
+    void run_binary()
+    {
+      oks::Arena arena;
+      oks::Arena::Scope arena_scope(m_kernel->get_file_arenas_mode() ? &arena : nullptr);
+
+      try {
+        {
+          std::shared_lock lock(m_kernel->p_schema_mutex);
+          m_bins->resolve(m_kernel);
+        }
+
+        m_fp->p_number_of_items = 0;
+
+        try {
+          while(OksObject::read(*m_bins, m_fp)) {
+            m_fp->p_number_of_items++;
+          }
+        }
+        catch(oks::FailedCreateObject & ex) {
+	  m_kernel->p_load_errors.add_error(*m_fp, ex);
+	  return;
+        }
+
+      }
+      catch (std::exception& ex) {
+	m_kernel->p_load_errors.add_error(*m_fp, ex);
+      }
+    }
+
+
+      // protect usage of copy constructor and assignment operator
+
+  private:
+
+    OksLoadObjectsJob(const OksLoadObjectsJob&);
+    OksLoadObjectsJob& operator=(const OksLoadObjectsJob &);
+
+};
+
+/******************************************************************************/
+
+  // the minimal size of data file part parsed by separate thread in split data files mode
+
+static const long s_min_data_file_part_size = 1024 * 1024;
+
+
+  // Check if rest of mapped data file contains given sequence of symbols.
+
+static bool
+mapped_rest_contains(const OksXmlInputStream& xmls, const char * str, size_t len)
+{
+  const std::shared_ptr<oks::MappedFile>& m(xmls.get_mapped_file());
+  const char * const begin(m->data() + xmls.get_position());
+
+  return (memmem(begin, m->data() + m->size() - begin, str, len) != nullptr);
+}
+
+
+  // Check if rest of mapped data file contains xml comments.
+  // The comments may contain unescaped object tags, so such files cannot be split or read lazily.
+
+static bool
+has_xml_comments(const OksXmlInputStream& xmls)
+{
+  static const char __comment[] = "<!--";
+  return mapped_rest_contains(xmls, __comment, sizeof(__comment) - 1);
+}
+
+
+  // Check if rest of mapped data file may contain definitions of class aliases (see OksAliasTable).
+  // The aliases depend on order of objects in file, so objects of such files cannot be read lazily or in parts.
+
+static bool
+has_class_aliases(const OksXmlInputStream& xmls)
+{
+  static const char __alias[] = "\"@";
+  return mapped_rest_contains(xmls, __alias, sizeof(__alias) - 1);
+}
+
+
+  // Split rest of mapped data file at object start tags into num parts to be parsed concurrently.
+  // Each part gets own stream with correct line numbers. Return empty vector, if the file cannot be split.
+
+static std::vector<std::shared_ptr<OksXmlInputStream>>
+split_xml_stream(OksXmlInputStream& xmls, long num, bool has_comments)
+{
+  std::vector<std::shared_ptr<OksXmlInputStream>> parts;
+
+  if(num < 2 || has_comments) return parts;
+
+  const std::shared_ptr<oks::MappedFile>& m(xmls.get_mapped_file());
+  const char * const data(m->data());
+  const char * const begin(data + xmls.get_position());
+  const char * const end(data + m->size());
+
+  static const char __obj_tag[] = "<obj";
+  const size_t obj_tag_len(sizeof(__obj_tag) - 1);
+
+  std::vector<const char *> bounds;
+  bounds.push_back(begin);
+
+  for(long i = 1; i < num; ++i) {
+    const char * p = begin + (end - begin) * i / num;
+
+    if(p <= bounds.back()) continue;
+
+    while((p = static_cast<const char *>(memmem(p, end - p, __obj_tag, obj_tag_len))) != nullptr) {
+      if(p + obj_tag_len < end && (p[obj_tag_len] == ' ' || p[obj_tag_len] == '\n' || p[obj_tag_len] == '\r' || p[obj_tag_len] == '\t')) break;
+      p += obj_tag_len;
+    }
+
+    if(p == nullptr) break;
+
+    bounds.push_back(p);
+  }
+
+  if(bounds.size() < 2) return parts;
+
+  bounds.push_back(end);
+
+  unsigned long line_no(xmls.get_line_no());
+  unsigned long line_pos(xmls.get_line_pos());
+
+  for(size_t i = 0; i < bounds.size() - 1; ++i) {
+    if(i) {
+      const char * from(bounds[i-1]);
+      const char * to(bounds[i]);
+
+      if(const char * nl = static_cast<const char *>(memrchr(from, '\n', to - from))) {
+        line_no += std::count(from, nl + 1, '\n');
+        line_pos = to - nl - 1;
+      }
+      else {
+        line_pos += to - from;
+      }
+    }
+
+    parts.emplace_back(new OksXmlInputStream(m, bounds[i] - data, bounds[i+1] - data, line_no, line_pos));
+  }
+
+  return parts;
+}
+
+/******************************************************************************/
+
+static bool _find_file(const OksFile::Map & files, const OksFile * f)
+{
+  for(OksFile::Map::const_iterator i = files.begin(); i != files.end(); ++i) {
+    if(i->second == f) return true;
+  }
+  return false;
+}
+
+void
+oks::ReloadObjects::put(OksObject * o)
+{
+  config::map<OksObject *> *& c = data[o->uid.class_id];
+  if(!c) c = new config::map<OksObject *>();
+  (*c)[o->GetId()] = o;
+}
+
+OksObject *
+oks::ReloadObjects::pop(const OksClass* c, const std::string& id)
+{
+  std::map< const OksClass *, config::map<OksObject *> * >::iterator i = data.find(c);
+  if(i != data.end()) {
+    config::map<OksObject *>::iterator j = i->second->find(id);
+    if(j != i->second->end()) {
+      OksObject * o = j->second;
+      i->second->erase(j);
       if(i->second->empty()) {
         delete i->second;
 	data.erase(i);
@@ -3224,6 +3737,7 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
 
   bool check_includes(false);
   bool found_schema_files(false);
+  bool found_binary_files(false);
   std::string file_names;
 
   std::unique_lock lock(p_kernel_mutex);
@@ -3237,6 +3751,9 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
       files_h.erase(fi++);
       continue;
     }
+    else if((*fi)->p_oks_format == "binary") {
+      found_binary_files = true;
+    }
 
     if(fi != files_h.begin()) file_names.append(", ");
     file_names.push_back('\"');
@@ -3253,6 +3770,12 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
       throw std::runtime_error("Reload of modified schema files is not supported");
     }
 
+      // throw exception on binary snapshots of data files
+
+    if(found_binary_files) {
+      throw std::runtime_error("Reload of binary data files is not supported");
+    }
+
       // exit, if there are no files to reload (e.g. dangling refs.)
 
     if(files_h.empty()) return;
@@ -3269,8 +3792,8 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
         (*i)->unlock();
       }
 
-      for(OksObject::Set::const_iterator oi = p_objects.begin(); oi != p_objects.end(); ++oi) {
-        if((*oi)->file == *i) reload_objects.put(*oi);
+      for(const auto& o : (*i)->p_objects) {
+        reload_objects.put(o);
       }
     }
 
@@ -3348,10 +3871,8 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
             else {
               files_to_be_closed.insert(f2);
 
-              for(OksObject::Set::const_iterator oi = p_objects.begin(); oi != p_objects.end(); ++oi) {
-                if((*oi)->file == f2) {
-		  reload_objects.put(*oi); 
-	        }
+              for(const auto& o : f2->p_objects) {
+                reload_objects.put(o);
               }
 
               if (files_h.erase(f2)) {
@@ -3423,9 +3944,8 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
       // read objects
 
     for(i = files_h.begin(); i != files_h.end(); ++i) {
-      std::shared_ptr<std::ifstream> f(new std::ifstream((*i)->get_full_file_name().c_str()));
-
-      std::shared_ptr<OksXmlInputStream> xmls(new OksXmlInputStream(f));
+      long file_length;
+      std::shared_ptr<OksXmlInputStream> xmls(open_xml_stream("reload_data", (*i)->get_full_file_name(), p_use_mapped_files, file_length));
 
       OksFile fp(xmls, (*i)->get_short_file_name(), (*i)->get_full_file_name(), this);
       char format = (fp.p_oks_format == "data" ? 'n' : ((fp.p_oks_format == "extended") ? 'X': 'c'));
@@ -3436,11 +3956,18 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
       }
 
       {
+        oks::Arena arena;
+        oks::Arena::Scope arena_scope(p_file_arenas ? &arena : nullptr);
+
         OksAliasTable alias_table;
         oks::ReadFileParams read_params( *i, *xmls, ((format == 'X') ? 0 : &alias_table), this, format, &reload_objects );
 
         try {
           while(OksObject::read(read_params)) { ; }
+
+          if(access((*i)->get_journal_file_name().c_str(), F_OK) == 0) {
+            k_replay_journal(*i, &reload_objects);
+          }
         }
         catch(oks::FailedCreateObject & ex) {
           set_test_duplicated_objects_via_inheritance_mode(duplicated_objs_mode);
@@ -3481,6 +4008,7 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
       {
         OksObject::FSet refs;
         unbind_all_rels(oset, refs);
+        k_invalidate_reverse_refs();  // the values of reloaded objects are replaced without index update
         if(p_change_object_notify_fn) {
           for(OksObject::FSet::const_iterator x2 = refs.begin(); x2 != refs.end(); ++x2) {
             TLOG_DEBUG(3) << "*** add object " << *x2 << " to the list of updated *** ";
@@ -3508,6 +4036,15 @@ OksKernel::reload_data(std::set<OksFile *>& files_h, bool allow_schema_extension
       k_close_data(*x, true);
     }
 
+
+      // the changes made by reload are not recorded for journal
+
+    for(const auto& x : files_h) {
+      x->p_journal_objects.clear();
+      x->p_journal_removed.clear();
+      x->p_journal_complete = true;
+    }
+
     k_bind_objects();
 
 
@@ -3602,23 +4139,37 @@ OksKernel::k_load_data(const std::string& short_file_name, bool bind, const OksF
       return fp->check_parent(parent_h);
     }
 
-    {
-      std::shared_ptr<std::ifstream> f(new std::ifstream(full_file_name.c_str()));
+    if(oks::BinaryFormat::test(full_file_name)) {
+      std::shared_ptr<oks::BinaryInputStream> bins(open_binary_stream("k_load_data", full_file_name));
+      fp = new OksFile(*bins, short_file_name, full_file_name, this);
+      k_load_binary_data(fp, bins, bins->size(), bind, parent_h, pipeline);
+      OSK_VERBOSE_REPORT("LEAVE " << fname)
+      return fp;
+    }
+
+    std::string cache_key;
 
-      if(!f->good()) {
-        throw std::runtime_error("k_load_data(): cannot open file");
+    if(!p_cache_dir.empty()) {
+      if((fp = k_load_cached_file(short_file_name, full_file_name, bind, parent_h, pipeline, cache_key, 'd')) != nullptr) {
+        OSK_VERBOSE_REPORT("LEAVE " << fname)
+        return fp;
       }
+    }
+
+    {
+      long file_length;
+      OksFile::Compression compression;
+      std::shared_ptr<OksXmlInputStream> xmls(open_xml_stream("k_load_data", full_file_name, p_use_mapped_files, file_length, &compression));
 
-      long file_length(get_file_length(*f));
-      
       if(!file_length) {
         throw std::runtime_error("k_load_data(): file is empty");
       }
 
-      std::shared_ptr<OksXmlInputStream> xmls(new OksXmlInputStream(f));
-
       fp = new OksFile(xmls, short_file_name, full_file_name, this);
 
+      fp->p_cache_key = cache_key;
+      fp->p_compression = compression;
+
       if(fp->p_oks_format.empty()) {
         throw std::runtime_error("k_load_data(): failed to read header of file");
       }
@@ -3635,6 +4186,10 @@ OksKernel::k_load_data(const std::string& short_file_name, bool bind, const OksF
         throw std::runtime_error("k_load_data(): file is not an oks data file");
       }
 
+      if(!cache_key.empty()) {
+        p_cache_images.push_back(fp);
+      }
+
       k_load_data(fp, format, xmls, file_length, bind, parent_h, pipeline);
 
       OSK_VERBOSE_REPORT("LEAVE " << fname)
@@ -3654,6 +4209,57 @@ OksKernel::k_load_data(const std::string& short_file_name, bool bind, const OksF
 }
 
 
+  // user-allowed method
+
+void
+OksKernel::visit_data(const std::string& short_file_name, oks::DataVisitor& visitor)
+{
+  std::string full_file_name;
+  std::shared_ptr<OksXmlInputStream> xmls;
+  std::unique_ptr<OksFile> fp;
+
+  try {
+    std::shared_lock lock(p_kernel_mutex);
+    full_file_name = get_file_path(short_file_name, nullptr);
+  }
+  catch (std::exception & e) {
+    throw oks::CanNotOpenFile("visit_data", short_file_name, e.what());
+  }
+
+  try {
+    long file_length;
+    xmls = open_xml_stream("visit_data", full_file_name, p_use_mapped_files, file_length);
+
+    if(!file_length) {
+      throw std::runtime_error("visit_data(): file is empty");
+    }
+
+    {
+      std::shared_lock lock(p_kernel_mutex);
+      fp.reset(new OksFile(xmls, short_file_name, full_file_name, this));
+    }
+
+    if(fp->p_oks_format.size() != 4 || !oks::cmp_str4n(fp->p_oks_format.c_str(), "data")) {
+      throw std::runtime_error("visit_data(): file is not an oks data file in normal format");
+    }
+
+    visitor.begin_file(*fp);
+
+    oks::ReadFileParams read_params( fp.get(), *xmls, nullptr, this, 'n', nullptr );
+
+    while(OksObject::visit(read_params, visitor)) { ; }
+
+    visitor.end_file();
+  }
+  catch (oks::exception & e) {
+    throw (oks::FailedLoadFile("data file", full_file_name, e));
+  }
+  catch (std::exception & e) {
+    throw (oks::FailedLoadFile("data file", full_file_name, e.what()));
+  }
+}
+
+
 void
 OksKernel::k_load_data(OksFile * fp, char format, std::shared_ptr<OksXmlInputStream> xmls, long file_length, bool bind, const OksFile * parent_h, OksPipeline * pipeline)
 {
@@ -3662,6 +4268,8 @@ OksKernel::k_load_data(OksFile * fp, char format, std::shared_ptr<OksXmlInputStr
   fp->p_included_by = parent_h;
   check_read_only(fp);
 
+  k_invalidate_reverse_refs();
+
   try {
     if(!p_silence) {
       std::lock_guard lock(p_parallel_out_mutex);
@@ -3675,6 +4283,10 @@ OksKernel::k_load_data(OksFile * fp, char format, std::shared_ptr<OksXmlInputStr
     fp->update_status_of_file();
     add_data_file(fp);
 
+    if(access(fp->get_journal_file_name().c_str(), F_OK) == 0) {
+      p_journals.push_back(fp);
+    }
+
     {
       std::unique_ptr<OksPipeline> pipeline_guard(pipeline ? 0 : new OksPipeline(p_threads_pool_size));
 
@@ -3691,11 +4303,40 @@ OksKernel::k_load_data(OksFile * fp, char format, std::shared_ptr<OksXmlInputStr
       k_load_includes(*fp, m_pipeline);
 
 
+        // read bodies of objects on first access; the parse cache image needs all bodies
+
+      const bool use_mapped_xml(format != 'c' && xmls->is_mapped());
+      const bool has_comments(use_mapped_xml && (p_split_data_files || p_lazy_objects) && has_xml_comments(*xmls));
+      const bool lazy(p_lazy_objects && use_mapped_xml && !has_comments && fp->p_cache_key.empty() && (format == 'X' || !has_class_aliases(*xmls)));
+
+      if(lazy) {
+        TLOG_DEBUG(2) << "read objects of data file \"" << fp->get_full_file_name() << "\" in lazy mode";
+      }
+
       if(p_threads_pool_size > 1) {
-        m_pipeline->addJob( new OksLoadObjectsJob( this, fp, xmls, format) );
+        std::vector<std::shared_ptr<OksXmlInputStream>> parts;
+
+        if(p_split_data_files && use_mapped_xml && (format == 'X' || !has_class_aliases(*xmls))) {
+          parts = split_xml_stream(*xmls, std::min<long>(p_threads_pool_size, file_length / s_min_data_file_part_size), has_comments);
+        }
+
+        if(parts.empty()) {
+          m_pipeline->addJob( new OksLoadObjectsJob( this, fp, xmls, format, nullptr, lazy) );
+        }
+        else {
+          TLOG_DEBUG(2) << "split data file \"" << fp->get_full_file_name() << "\" into " << parts.size() << " parts";
+
+          fp->p_number_of_parts = parts.size();
+
+          std::shared_ptr<OksLoadObjectsJob::Parts> info(new OksLoadObjectsJob::Parts(parts.size()));
+
+          for(auto& x : parts) {
+            m_pipeline->addJob( new OksLoadObjectsJob( this, fp, x, format, info, lazy) );
+          }
+        }
       }
       else {
-        OksLoadObjectsJob job(this, fp, xmls, format);
+        OksLoadObjectsJob job(this, fp, xmls, format, nullptr, lazy);
         job.run();
       }
     }
@@ -3705,63 +4346,364 @@ OksKernel::k_load_data(OksFile * fp, char format, std::shared_ptr<OksXmlInputStr
         throw (oks::FailedLoadFile("data file", fp->get_full_file_name(), p_load_errors.get_text()));
       }
 
+      k_write_cache_images();
+      k_replay_journals();
+
       if(bind) {
         k_bind_objects();
       }
     }
   }
   catch (oks::FailedLoadFile&) {
+    if(!pipeline) { p_cache_images.clear(); p_journals.clear(); }
     throw;
   }
   catch (oks::exception& e) {
+    if(!pipeline) { p_cache_images.clear(); p_journals.clear(); }
     throw (oks::FailedLoadFile("data file", fp->get_full_file_name(), e));
   }
   catch (std::exception& e) {
+    if(!pipeline) { p_cache_images.clear(); p_journals.clear(); }
     throw (oks::FailedLoadFile("data file", fp->get_full_file_name(), e.what()));
   }
 }
 
 
-OksFile *
-OksKernel::new_data(const std::string& s, const std::string& logical_name, const std::string& type)
+  // kernel method
+
+void
+OksKernel::k_load_binary_data(OksFile * fp, std::shared_ptr<oks::BinaryInputStream> bins, long file_length, bool bind, const OksFile * parent_h, OksPipeline * pipeline)
 {
-  const char _fname[] = "new_data";
-  std::string fname = make_fname(_fname, sizeof(_fname)-1, s, nullptr, nullptr);
-  OSK_VERBOSE_REPORT("ENTER " << fname)
+  OSK_PROFILING(OksProfiler::KernelLoadData, this)
 
-  if(!s.length()) {
-    throw oks::CanNotOpenFile("new_data", s, "file name is empty");
-  }
+  fp->p_included_by = parent_h;
+  check_read_only(fp);
 
-  std::string file_name(s);
+  k_invalidate_reverse_refs();
 
   try {
+    if(!p_silence) {
+      std::lock_guard lock(p_parallel_out_mutex);
+      std::cout << (parent_h ? " * r" : "R") << "eading data file \"" << fp->get_full_file_name()
+                << "\" " << (fp->p_oks_format == "binary" ? "in binary format" : "from parse cache") << " (" << file_length << " bytes)...\n";
+      if(parent_h == 0 && fp->get_full_file_name() != fp->get_short_file_name()) {
+        std::cout << "(non-fully-qualified filename was \"" << fp->get_short_file_name() << "\")\n";
+      }
+    }
 
-    Oks::substitute_variables(file_name);
+    fp->update_status_of_file();
+    fp->p_size = file_length;
+    add_data_file(fp);
 
-    test_file_existence(file_name, p_silence, fname, "data");
+    if(access(fp->get_journal_file_name().c_str(), F_OK) == 0) {
+      p_journals.push_back(fp);
+    }
 
-    file_name = get_file_path(s, nullptr, false);
+    {
+      std::unique_ptr<OksPipeline> pipeline_guard(pipeline ? 0 : new OksPipeline(p_threads_pool_size));
 
-    std::unique_lock lock(p_kernel_mutex);
+      OksPipeline * m_pipeline;
 
-    if(find_data_file(file_name) != 0) {
-      throw std::runtime_error("the file is already loaded");
-    }
+      if(pipeline) {
+        m_pipeline = pipeline;
+      }
+      else {
+        m_pipeline = pipeline_guard.get();
+        p_load_errors.clear();
+      }
 
-    OksFile * file_h = new OksFile(file_name, logical_name, type, "data", this);
+      k_load_includes(*fp, m_pipeline);
 
-    file_h->p_short_name = s;
+      if(p_threads_pool_size > 1) {
+        m_pipeline->addJob( new OksLoadObjectsJob( this, fp, bins) );
+      }
+      else {
+        OksLoadObjectsJob job(this, fp, bins);
+        job.run();
+      }
+    }
 
-    k_set_active_data(file_h);
+    if(!pipeline) {
+      if(!p_load_errors.is_empty()) {
+        throw (oks::FailedLoadFile("data file", fp->get_full_file_name(), p_load_errors.get_text()));
+      }
 
-    add_data_file(p_active_data);
+      k_write_cache_images();
+      k_replay_journals();
 
+      if(bind) {
+        k_bind_objects();
+      }
+    }
   }
-  catch (oks::exception & e) {
-    throw oks::CanNotCreateFile("new_data", "data file", file_name, e);
+  catch (oks::FailedLoadFile&) {
+    if(!pipeline) { p_cache_images.clear(); p_journals.clear(); }
+    throw;
   }
-  catch (std::exception & e) {
+  catch (oks::exception& e) {
+    if(!pipeline) { p_cache_images.clear(); p_journals.clear(); }
+    throw (oks::FailedLoadFile("data file", fp->get_full_file_name(), e));
+  }
+  catch (std::exception& e) {
+    if(!pipeline) { p_cache_images.clear(); p_journals.clear(); }
+    throw (oks::FailedLoadFile("data file", fp->get_full_file_name(), e.what()));
+  }
+}
+
+
+  // kernel method; if there is no valid image of the file in parse cache, returns null and the key to store new image
+  // the type of file can be restricted to data ('d') or schema ('s')
+
+OksFile *
+OksKernel::k_load_cached_file(const std::string& short_file_name, const std::string& full_file_name, bool bind, const OksFile * parent_h, OksPipeline * pipeline, std::string& key, char type)
+{
+  struct stat buf;
+
+  if(stat(full_file_name.c_str(), &buf) != 0 || !S_ISREG(buf.st_mode) || buf.st_size == 0) {
+    return nullptr;
+  }
+
+  long file_length;
+  uint64_t checksum, content_checksum(0);
+
+  try {
+    oks::MappedFile m(full_file_name);
+
+    std::ostringstream s;
+    s << full_file_name << '\n' << buf.st_size << '\n' << buf.st_mtim.tv_sec << '.' << buf.st_mtim.tv_nsec << '\n' << std::hex << oks::BinaryFormat::hash(m.data(), m.size());
+    key = s.str();
+
+    file_length = m.size();
+    checksum = OksFile::read_checksum(m.data(), m.size(), &content_checksum);
+  }
+  catch(std::exception&) {
+    return nullptr; // the error is reported by xml parser
+  }
+
+  const std::string image_name(make_cache_image_name(p_cache_dir, full_file_name));
+
+  if(access(image_name.c_str(), R_OK) != 0) {
+    return nullptr;
+  }
+
+  std::shared_ptr<oks::BinaryInputStream> bins;
+  OksFile * fp(nullptr);
+
+  try {
+    bins = open_binary_stream("k_load_cached_file", image_name);
+
+    if(bins->get_source() != key) {
+      TLOG_DEBUG(2) << "parse cache image \"" << image_name << "\" of file \"" << full_file_name << "\" is out of date";
+      return nullptr;
+    }
+
+    fp = new OksFile(*bins, short_file_name, full_file_name, this);
+    fp->p_compression = oks::get_compression(full_file_name);
+  }
+  catch(std::exception& ex) {
+    TLOG_DEBUG(2) << "cannot use parse cache image \"" << image_name << "\" of file \"" << full_file_name << "\": " << ex.what();
+    return nullptr;
+  }
+
+  fp->p_cache_key = key;
+  fp->p_checksum = checksum;
+  fp->p_content_checksum = content_checksum;
+
+  if(fp->p_oks_format == "schema") {
+    if(type == 'd') {
+      delete fp;
+      return nullptr;
+    }
+
+    if(!k_load_schema_image(fp, *bins, file_length, parent_h)) {
+
+        // the includes were already loaded by this file, so re-read its header and classes from xml using the same file handle
+
+      std::shared_ptr<OksXmlInputStream> xmls(open_xml_stream("k_load_cached_file", full_file_name, p_use_mapped_files, file_length));
+
+      {
+        OksFile f(xmls, short_file_name, full_file_name, this);
+        *fp = f;
+      }
+
+      fp->p_cache_key = key;
+
+      if(fp->p_oks_format != "schema") {
+        throw std::runtime_error("k_load_cached_file(): file is not oks schema file");
+      }
+
+      k_load_schema(fp, xmls, parent_h);
+      k_write_cache_image(fp, false);
+    }
+  }
+  else {
+    if(type == 's') {
+      delete fp;
+      return nullptr;
+    }
+
+    k_load_binary_data(fp, bins, file_length, bind, parent_h, pipeline);
+  }
+
+  return fp;
+}
+
+
+  // kernel method; writes binary images of data files loaded from xml into parse cache
+
+void
+OksKernel::k_write_cache_images()
+{
+  if(p_cache_images.empty()) {
+    return;
+  }
+
+  for(const auto& x : p_cache_images) {
+    k_write_cache_image(x, true);
+  }
+
+  p_cache_images.clear();
+}
+
+
+  // kernel method; writes binary image of data file (objects of the file are stored) or schema file into parse cache
+
+void
+OksKernel::k_write_cache_image(OksFile * fp, bool is_data)
+{
+  const std::string image_name(make_cache_image_name(p_cache_dir, fp->get_full_file_name()));
+  std::string tmp_file_name;
+
+  try {
+    oks::BinaryOutputStream bins(fp->p_cache_key);
+
+    fp->write(bins, false);
+
+    if(is_data) {
+      for(const auto& o : fp->p_objects) {
+        o->put(bins);
+      }
+    }
+    else {
+      std::vector<const OksClass *> classes;
+      std::set<const OksFile *> files;
+
+      for(const auto& c : p_classes) {
+        if(c.second->p_file == fp) {
+          classes.push_back(c.second);
+
+          if(const OksClass::FList * scl = c.second->p_all_super_classes) {
+            for(const auto& x : *scl) {
+              if(x->p_file != fp) {
+                files.insert(x->p_file);
+              }
+            }
+          }
+        }
+      }
+
+        // store keys of files defining superclasses to validate inheritance closures
+
+      bins.put(static_cast<uint32_t>(files.size()));
+
+      for(const auto& x : files) {
+        if(x->p_cache_key.empty()) {
+          TLOG_DEBUG(2) << "skip schema image of file \"" << fp->get_full_file_name() << "\" since superclasses file \"" << x->get_full_file_name() << "\" was not loaded via parse cache";
+          return;
+        }
+
+        bins.put(x->get_full_file_name());
+        bins.put(x->p_cache_key);
+      }
+
+      bins.put(static_cast<uint32_t>(classes.size()));
+
+      for(const auto& c : classes) {
+        c->put(bins);
+      }
+
+      for(const auto& c : classes) {
+        c->put_registration(bins);
+      }
+    }
+
+    mkdir(p_cache_dir.c_str(), 0777);
+
+      // write temporal file and rename it, so concurrent readers never see partially written image
+
+    tmp_file_name = get_tmp_file(image_name);
+
+    {
+      std::ofstream f(tmp_file_name.c_str(), std::ios::binary);
+
+      if(!f) {
+        throw std::runtime_error("cannot create temporal file \'" + tmp_file_name + '\'');
+      }
+
+      f.exceptions(std::ostream::failbit | std::ostream::badbit);
+      bins.flush(f);
+      f.close();
+    }
+
+    if(rename(tmp_file_name.c_str(), image_name.c_str())) {
+      throw std::runtime_error("cannot rename \'" + tmp_file_name + "\' to \'" + image_name + "\': " + strerror(errno));
+    }
+
+    TLOG_DEBUG(2) << "wrote parse cache image \"" << image_name << "\" of file \"" << fp->get_full_file_name() << '\"';
+  }
+  catch(std::exception& ex) {
+    if(!tmp_file_name.empty()) {
+      unlink(tmp_file_name.c_str());
+    }
+
+    if(!p_silence) {
+      std::lock_guard lock(p_parallel_out_mutex);
+      Oks::warning_msg("OksKernel::k_write_cache_image()") << "  cannot write parse cache image of file \"" << fp->get_full_file_name() << "\":\n" << ex.what() << std::endl;
+    }
+  }
+}
+
+
+OksFile *
+OksKernel::new_data(const std::string& s, const std::string& logical_name, const std::string& type)
+{
+  const char _fname[] = "new_data";
+  std::string fname = make_fname(_fname, sizeof(_fname)-1, s, nullptr, nullptr);
+  OSK_VERBOSE_REPORT("ENTER " << fname)
+
+  if(!s.length()) {
+    throw oks::CanNotOpenFile("new_data", s, "file name is empty");
+  }
+
+  std::string file_name(s);
+
+  try {
+
+    Oks::substitute_variables(file_name);
+
+    test_file_existence(file_name, p_silence, fname, "data");
+
+    file_name = get_file_path(s, nullptr, false);
+
+    std::unique_lock lock(p_kernel_mutex);
+
+    if(find_data_file(file_name) != 0) {
+      throw std::runtime_error("the file is already loaded");
+    }
+
+    OksFile * file_h = new OksFile(file_name, logical_name, type, "data", this);
+
+    file_h->p_short_name = s;
+
+    k_set_active_data(file_h);
+
+    add_data_file(p_active_data);
+
+  }
+  catch (oks::exception & e) {
+    throw oks::CanNotCreateFile("new_data", "data file", file_name, e);
+  }
+  catch (std::exception & e) {
     throw oks::CanNotCreateFile("new_data", "data file", file_name, e.what());
   }
 
@@ -3850,6 +4792,41 @@ OksKernel::backup_data(OksFile * pf, const char * suffix)
   p_silence = silence;
 }
 
+void
+OksKernel::save_binary_data(OksFile * pf, const std::string& file_name)
+{
+  std::shared_lock lock(p_kernel_mutex);
+
+    // copy info, includes and comments of the source file
+
+  OksFile f(*pf);
+
+  f.p_lock.reset();
+  f.p_oks_format = "binary";
+  f.rename(file_name, file_name);
+
+  if(!p_silence) {
+    std::lock_guard lock(p_parallel_out_mutex);
+    std::cout << "Saving binary snapshot of data file \"" << pf->p_full_name << "\" to \"" << file_name << "\"...\n";
+  }
+
+    // the source file was already checked, skip consistency tests of objects
+
+  bool silence = p_silence;
+
+  p_silence = true;
+
+  try {
+    k_save_data(&f, true, pf);
+  }
+  catch(...) {
+    p_silence = silence;
+    throw;
+  }
+
+  p_silence = silence;
+}
+
 
   // kernel method
 
@@ -3866,6 +4843,17 @@ OksKernel::k_save_data(OksFile * pf, bool ignoreBadObjects, OksFile * fh, const
   
   if(!fh) fh = pf;
 
+  const bool binary_format(pf->p_oks_format == "binary");
+
+    // in journal mode append recorded changes to the journal of existing file
+
+  if(p_journal && fh == pf && !objects && !force_defaults && !binary_format && pf->p_journal_complete) {
+    if(k_append_journal(pf, ignoreBadObjects)) {
+      OSK_VERBOSE_REPORT("LEAVE " << fname)
+      return;
+    }
+  }
+
   try {
 
       // calculate number of objects in file and check objects
@@ -3899,19 +4887,18 @@ OksKernel::k_save_data(OksFile * pf, bool ignoreBadObjects, OksFile * fh, const
 
       bool found_bad_object = false;
 
-      for(OksObject::Set::iterator i = p_objects.begin(); i != p_objects.end(); ++i) {
-        if((*i)->file == fh) {
-          numberOfObjects++;
-	  if(!ignoreBadObjects || !p_silence) {
-            if((*i)->is_consistent(includes, "WARNING") == false) {
-              found_bad_object = true;
-            }
-            if((*i)->is_duplicated() == true) {
-              if(!p_silence) {
-                Oks::error_msg(fname) << "  The file contains duplicated object " << *i << std::endl;
-              }
-              found_bad_object = true;
+      numberOfObjects = fh->p_objects.size();
+
+      if(!ignoreBadObjects || !p_silence) {
+        for(const auto& o : fh->p_objects) {
+          if(o->is_consistent(includes, "WARNING") == false) {
+            found_bad_object = true;
+          }
+          if(o->is_duplicated() == true) {
+            if(!p_silence) {
+              Oks::error_msg(fname) << "  The file contains duplicated object " << o << std::endl;
             }
+            found_bad_object = true;
           }
         }
       }
@@ -3951,163 +4938,646 @@ OksKernel::k_save_data(OksFile * pf, bool ignoreBadObjects, OksFile * fh, const
     }
 
 
+      // remember checksums and last-modification information of the file on disk, if it was not modified by external process
+
+    const uint64_t keep_checksum((fh == pf && !binary_format && pf->get_status_of_file() == OksFile::FileNotModified) ? pf->p_content_checksum : 0);
+    const uint64_t keep_file_checksum(pf->p_checksum);
+    const boost::posix_time::ptime keep_last_modification_time(pf->p_last_modification_time);
+    const std::string keep_last_modified_by(pf->p_last_modified_by);
+    const std::string keep_last_modified_on(pf->p_last_modified_on);
+
+
     tmp_file_name = get_tmp_file(pf->p_full_name);
 
-    long file_len = 0;
+    {
+      std::ofstream f(tmp_file_name.c_str());
+
+      f.exceptions ( std::ostream::failbit | std::ostream::badbit );
+
+      if(!f) {
+        std::ostringstream text;
+        text << "cannot create temporal file \'" << tmp_file_name << "\' to save data";
+        throw std::runtime_error(text.str().c_str());
+      }
+      else {
+        if(!p_silence) {
+	  std::lock_guard lock(p_parallel_out_mutex);
+          std::cout << "Saving " << numberOfObjects << " objects " << (force_defaults ? "with enforced default values " : "") << "to data file \"" << pf->p_full_name << "\"...\n";
+        }
+      }
+
+
+        // compress xml output, if required by the file
+
+      const bool compressed(!binary_format && pf->p_compression != OksFile::Uncompressed);
+      boost::iostreams::filtering_ostream zf;
+
+      if(compressed) {
+        if(pf->p_compression == OksFile::Gzip) {
+          zf.push(boost::iostreams::gzip_compressor());
+        }
+        else {
+          zf.push(boost::iostreams::zstd_compressor());
+        }
+
+        zf.push(f);
+        zf.exceptions ( std::ostream::failbit | std::ostream::badbit );
+      }
+
+      std::ostream& out(compressed ? static_cast<std::ostream&>(zf) : f);
+
+
+        // set header parameters
+
+      OksXmlOutputStream xmls(out);
+      std::unique_ptr<oks::BinaryOutputStream> bins(binary_format ? new oks::BinaryOutputStream() : nullptr);
+
+      pf->p_number_of_items = numberOfObjects;
+
+      if(bins) {
+        pf->write(*bins);
+      }
+      else {
+        pf->p_oks_format = "data";
+        pf->write(xmls, !compressed);
+      }
+
+        // save objects of the file sorted by class name and object id
+
+      std::vector<OksObject *> sorted(fh->p_objects.begin(), fh->p_objects.end());
+
+      if(objects) {
+        for(const auto& o : *objects) {
+          if(o->file != fh) {
+            sorted.push_back(o);
+          }
+        }
+      }
+
+      std::sort(sorted.begin(), sorted.end(), [](const OksObject * o1, const OksObject * o2) {
+        if(o1->uid.class_id != o2->uid.class_id) {
+          return (strcmp(o1->uid.class_id->get_name().c_str(), o2->uid.class_id->get_name().c_str()) < 0);
+        }
+        return (o1->uid.object_id < o2->uid.object_id);
+      });
+
+      for(std::vector<OksObject *>::const_iterator j = sorted.begin(); j != sorted.end() && out.good(); ++j) {
+        if(bins) {
+          (*j)->put(*bins);
+        }
+        else {
+          (*j)->put(xmls, force_defaults);
+          xmls.put_raw('\n');
+        }
+      }
+
+      if(bins) {
+        bins->flush(f);
+      }
+      else {
+        xmls.put_last_tag("oks-data", sizeof("oks-data")-1);
+      }
+
+
+        // flush the buffers and store checksums of written contents; the header of compressed file has no checksums
+
+      if(bins) {
+        pf->p_checksum = pf->p_content_checksum = 0;
+      }
+      else {
+        pf->write_checksums(xmls, compressed ? nullptr : &f);
+      }
+
+      if(compressed) {
+        zf.reset(); // flush and close the compressor
+      }
+
+      f.close();
+    }
+
+
+      // keep the file on disk untouched, if its contents are the same (e.g. the changes were reverted)
+
+    const bool unchanged(keep_checksum != 0 && pf->p_content_checksum == keep_checksum);
+
+    if(unchanged) {
+      unlink(tmp_file_name.c_str());
+      tmp_file_name.erase(0);
+
+      pf->p_checksum = keep_file_checksum;
+      pf->p_last_modification_time = keep_last_modification_time;
+      pf->p_last_modified_by = keep_last_modified_by;
+      pf->p_last_modified_on = keep_last_modified_on;
+
+      if(!p_silence) {
+        std::lock_guard lock(p_parallel_out_mutex);
+        std::cout << "The contents of data file \"" << pf->p_full_name << "\" are not changed, the file is kept untouched\n";
+      }
+    }
+
+    struct stat buf;
+
+    if(!unchanged) {
+      sync_file(tmp_file_name, p_durability_level);
+
+
+        // remember file's mode
+
+      if(int code = stat(pf->p_full_name.c_str(), &buf)) {
+        std::ostringstream text;
+        text << "cannot get information about file \'" << pf->p_full_name << "\': stat() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
+        throw std::runtime_error(text.str().c_str());
+      }
+
+
+        // rename temporal file
+
+      if(int code = rename(tmp_file_name.c_str(), pf->p_full_name.c_str())) {
+        std::ostringstream text;
+        text << "cannot rename file \'" << tmp_file_name << "\' to \'" << pf->p_full_name << "\': rename() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
+        throw std::runtime_error(text.str().c_str());
+      }
+
+      tmp_file_name.erase(0);
+
+      sync_directory(pf->p_full_name, p_durability_level);
+    }
+
+
+      // the file contains all changes stored in its journal
+
+    if(fh == pf) {
+      unlink(pf->get_journal_file_name().c_str());
+
+      pf->p_journal_objects.clear();
+      pf->p_journal_removed.clear();
+      pf->p_journal_complete = true;
+    }
+
+
+    if(pf != p_active_data) {
+      try {
+        pf->unlock();
+      }
+      catch(oks::exception& ex) {
+        throw std::runtime_error(ex.what());
+      }
+    }
+    pf->p_is_updated = false;
+
+    if(unchanged) {
+      OSK_VERBOSE_REPORT("LEAVE " << fname)
+      return;
+    }
+
+    pf->update_status_of_file();
+
+
+      // get mode for new file
+
+    struct stat buf2;
+    if(int code = stat(pf->p_full_name.c_str(), &buf2)) {
+      std::ostringstream text;
+      text << "cannot get information about file \'" << pf->p_full_name << "\': stat() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
+      throw std::runtime_error(text.str().c_str());
+    }
+
+
+      // set file's mode if needed
+
+    if(buf.st_mode != buf2.st_mode) {
+      if(int code = chmod(pf->p_full_name.c_str(), buf.st_mode) != 0) {
+        std::ostringstream text;
+        text << "cannot set protection mode for file \'" << pf->p_full_name << "\': chmod() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
+        throw std::runtime_error(text.str().c_str());
+      }
+    }
+
+      // set file's group if needed (in case of problems report error, but do not throw exception)
+
+    if(buf.st_gid != buf2.st_gid) {
+      if(int code = chown(pf->p_full_name.c_str(), (gid_t)(-1), buf.st_gid) != 0) {
+        ers::warning(oks::kernel::SetGroupIdFailed(ERS_HERE, buf.st_gid, pf->p_full_name.c_str(), code, oks::strerror(errno)));
+      }
+    }
+
+  }
+
+  catch (oks::exception & e) {
+    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
+    if(!tmp_file_name.empty()) { unlink(tmp_file_name.c_str()); }
+    throw oks::CanNotWriteToFile("k_save_data", "data file", pf->p_full_name, e);
+  }
+  catch (std::exception & e) {
+    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
+    if(!tmp_file_name.empty()) { unlink(tmp_file_name.c_str()); }
+    throw oks::CanNotWriteToFile("k_save_data", "data file", pf->p_full_name, e.what());
+  }
+  catch (...) {
+    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
+    if(!tmp_file_name.empty()) { unlink(tmp_file_name.c_str()); }
+    throw oks::CanNotWriteToFile("k_save_data", "data file", pf->p_full_name, "unknown");
+  }
+
+  OSK_VERBOSE_REPORT("LEAVE " << fname)
+}
+
+void
+OksKernel::set_journal_mode(const bool b)
+{
+    // the changes made before are not recorded, so such files have to be rewritten
+
+  if(b && !p_journal) {
+    for(const auto& f : p_data_files) {
+      if(f.second->p_is_updated) {
+        f.second->p_journal_complete = false;
+      }
+    }
+  }
+
+  p_journal = b;
+}
+
+
+  // user-allowed method
+
+void
+OksKernel::compact_data(OksFile * pf, bool ignoreBadObjects)
+{
+  std::shared_lock lock(p_kernel_mutex);
+
+  pf->p_journal_complete = false; // enforce rewrite of file
+  k_save_data(pf, ignoreBadObjects);
+}
+
+
+  // journal of data file starts from size and modification time of the file it was created for;
+  // a commit is written by single write() call and ends by the commit tag
+
+static const char s_journal_tag[] = "journal";
+static const char s_journal_del_tag[] = "del";
+static const char s_journal_commit_tag[] = "<commit/>\n";
+
+static std::string
+journal_mtime(const struct stat& buf)
+{
+  return std::to_string(buf.st_mtim.tv_sec) + '.' + std::to_string(buf.st_mtim.tv_nsec);
+}
+
+
+  // kernel method; appends objects created, modified or removed since last save to the journal of data file;
+  // returns false, if the file was not saved yet
+
+bool
+OksKernel::k_append_journal(OksFile * pf, bool ignoreBadObjects)
+{
+  struct stat buf;
+
+  if(stat(pf->p_full_name.c_str(), &buf) != 0) {
+    return false;
+  }
+
+  const std::string journal_name(pf->get_journal_file_name());
+  int fd = -1;
+
+  try {
+
+      // check created and modified objects
+
+    if(!ignoreBadObjects || !p_silence) {
+      std::set<OksFile *> includes;
+      pf->get_all_include_files(this, includes);
+
+      bool found_bad_object = false;
+
+      for(const auto& o : pf->p_journal_objects) {
+        if(o->is_consistent(includes, "WARNING") == false) {
+          found_bad_object = true;
+        }
+        if(o->is_duplicated() == true) {
+          if(!p_silence) {
+            Oks::error_msg("OksKernel::k_append_journal") << "  The file contains duplicated object " << o << std::endl;
+          }
+          found_bad_object = true;
+        }
+      }
+
+      if(found_bad_object && ignoreBadObjects == false) {
+        throw std::runtime_error("the file contains inconsistent/duplicated objects or misses includes");
+      }
+    }
+
+
+      // lock the file, if it is not locked already
+
+    if(pf->is_locked() == false) {
+      pf->lock();
+    }
+
+    if((fd = open(journal_name.c_str(), O_WRONLY | O_CREAT | O_APPEND, buf.st_mode & 0666)) < 0) {
+      throw std::runtime_error("cannot open journal \'" + journal_name + "\': " + oks::strerror(errno));
+    }
+
+    struct stat jbuf;
+
+    if(fstat(fd, &jbuf) != 0) {
+      throw std::runtime_error("cannot get size of journal \'" + journal_name + "\': " + oks::strerror(errno));
+    }
+
+
+      // remove partially written commit left by crashed process
+
+    if(jbuf.st_size > 0) {
+      const size_t tag_len(sizeof(s_journal_commit_tag) - 1);
+      char tail[sizeof(s_journal_commit_tag)];
+
+      if(jbuf.st_size < static_cast<off_t>(tag_len) || pread(fd, tail, tag_len, jbuf.st_size - tag_len) != static_cast<ssize_t>(tag_len) || memcmp(tail, s_journal_commit_tag, tag_len)) {
+        oks::MappedFile m(journal_name);
+        const size_t pos = std::string_view(m.data(), m.size()).rfind(s_journal_commit_tag);
+        const off_t len = (pos == std::string_view::npos ? 0 : pos + tag_len);
+
+        TLOG_DEBUG(1) << "truncate journal \"" << journal_name << "\" from " << jbuf.st_size << " to " << len << " bytes";
+
+        if(ftruncate(fd, len) != 0) {
+          throw std::runtime_error("cannot truncate journal \'" + journal_name + "\': " + oks::strerror(errno));
+        }
+
+        jbuf.st_size = len;
+      }
+    }
+
+    if(!p_silence) {
+      std::lock_guard lock(p_parallel_out_mutex);
+      std::cout << "Appending " << pf->p_journal_objects.size() << " updated and " << pf->p_journal_removed.size() << " removed objects to journal of data file \"" << pf->p_full_name << "\"...\n";
+    }
+
+
+      // write commit to memory
+
+    std::ostringstream s;
+
+    {
+      OksXmlOutputStream xmls(s);
+
+      if(jbuf.st_size == 0) {
+        xmls.put_start_tag(s_journal_tag, sizeof(s_journal_tag) - 1);
+        xmls.put_attribute("size", sizeof("size") - 1, std::to_string(buf.st_size).c_str());
+        xmls.put_attribute("mtime", sizeof("mtime") - 1, journal_mtime(buf).c_str());
+        xmls.put_end_tag();
+      }
+
+      for(const auto& x : pf->p_journal_removed) {
+        xmls.put_start_tag(s_journal_del_tag, sizeof(s_journal_del_tag) - 1);
+        xmls.put_attribute("class", sizeof("class") - 1, x.first.c_str());
+        xmls.put_attribute("id", sizeof("id") - 1, x.second.c_str());
+        xmls.put_end_tag();
+      }
+
+      for(const auto& o : pf->p_journal_objects) {
+        o->put(xmls, false);
+        xmls.put_raw('\n');
+      }
+
+      xmls.put_raw(s_journal_commit_tag, sizeof(s_journal_commit_tag) - 1);
+    }
+
+    const std::string commit(s.str());
+
+
+      // append commit; remove partially written commit in case of problems
+
+    for(const char * p = commit.data(), * end = p + commit.size(); p != end; ) {
+      const ssize_t len = write(fd, p, end - p);
+
+      if(len < 0) {
+        const int error(errno);
+
+        if(error == EINTR) {
+          continue;
+        }
+
+        if(ftruncate(fd, jbuf.st_size) != 0) {
+          TLOG_DEBUG(1) << "cannot truncate journal \"" << journal_name << "\": " << oks::strerror(errno);
+        }
+
+        throw std::runtime_error("cannot write journal \'" + journal_name + "\': " + oks::strerror(error));
+      }
+
+      p += len;
+    }
+
+    if(p_durability_level != NoSync && (p_durability_level == FullSync ? fsync(fd) : fdatasync(fd)) != 0) {
+      throw std::runtime_error("cannot flush journal \'" + journal_name + "\': " + oks::strerror(errno));
+    }
+
+    if(close(fd) != 0) {
+      fd = -1;
+      throw std::runtime_error("cannot close journal \'" + journal_name + "\': " + oks::strerror(errno));
+    }
+
+    fd = -1;
+
+    pf->p_journal_objects.clear();
+    pf->p_journal_removed.clear();
+
+    if(pf != p_active_data) {
+      try {
+        pf->unlock();
+      }
+      catch(oks::exception& ex) {
+        throw std::runtime_error(ex.what());
+      }
+    }
+
+    pf->p_is_updated = false;
+  }
+  catch (oks::exception & e) {
+    if(fd >= 0) { close(fd); }
+    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
+    throw oks::CanNotWriteToFile("k_append_journal", "data file", pf->p_full_name, e);
+  }
+  catch (std::exception & e) {
+    if(fd >= 0) { close(fd); }
+    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
+    throw oks::CanNotWriteToFile("k_append_journal", "data file", pf->p_full_name, e.what());
+  }
+
+  return true;
+}
 
-    {
-      std::ofstream f(tmp_file_name.c_str());
 
-      f.exceptions ( std::ostream::failbit | std::ostream::badbit );
+  // kernel method; replays journals of data files loaded by top-level load call
 
-      if(!f) {
-        std::ostringstream text;
-        text << "cannot create temporal file \'" << tmp_file_name << "\' to save data";
-        throw std::runtime_error(text.str().c_str());
-      }
-      else {
-        if(!p_silence) {
-	  std::lock_guard lock(p_parallel_out_mutex);
-          std::cout << "Saving " << numberOfObjects << " objects " << (force_defaults ? "with enforced default values " : "") << "to data file \"" << pf->p_full_name << "\"...\n";
-        }
-      }
+void
+OksKernel::k_replay_journals()
+{
+  std::vector<OksFile *> files;
+  files.swap(p_journals);
 
+  for(const auto& x : files) {
+    k_replay_journal(x, nullptr);
+  }
+}
 
-        // set header parameters
 
-      OksXmlOutputStream xmls(f);
+  // read class and id of journal record
 
-      pf->p_number_of_items = numberOfObjects;
-      pf->p_oks_format = "data";
+static OksClass *
+read_journal_record(OksKernel& kernel, OksXmlInputStream& s, std::string& id)
+{
+  OksClass * c(nullptr);
 
-      pf->write(xmls);
+  while(true) {
+    OksXmlAttribute attr(s);
 
-      if(!p_objects.empty()) {
-        for(OksClass::Map::const_iterator i = p_classes.begin(); i != p_classes.end() && f.good(); ++i) {
-          OksObject::SMap sorted;
+    if(oks::cmp_str1(attr.name(), ">") || oks::cmp_str1(attr.name(), "/")) {
+      break;
+    }
+    else if(oks::cmp_str5(attr.name(), "class")) {
+      if((c = kernel.find_class(attr.value())) == nullptr) {
+        std::ostringstream text;
+        text << "cannot find class \"" << attr.value() << "\" (line " << s.get_line_no() << ", char " << s.get_line_pos() << ')';
+        throw std::runtime_error(text.str());
+      }
+    }
+    else if(oks::cmp_str2(attr.name(), "id")) {
+      id.assign(attr.value(), attr.value_len());
+    }
+    else {
+      s.throw_unexpected_attribute(attr.name());
+    }
+  }
 
-          for(OksObject::Map::const_iterator j = i->second->p_objects->begin(); j != i->second->p_objects->end(); ++j) {
-            if(j->second->file == fh || (objects && (objects->find(j->second) != objects->end()))) {
-	      sorted[j->first] = j->second;
-	    }
-	  }
+  if(c == nullptr || id.empty()) {
+    throw oks::BadFileData("journal record without class or id", s.get_line_no(), s.get_line_pos());
+  }
 
-          for(OksObject::SMap::iterator j = sorted.begin(); j != sorted.end(); ++j) {
-	    j->second->put(xmls, force_defaults);
-	    xmls.put_raw('\n');
-          }
-        }
-      }
+  return c;
+}
 
-      xmls.put_last_tag("oks-data", sizeof("oks-data")-1);
-      file_len = f.tellp();
 
-      f.close();
-    }
+  // kernel method; applies commits of journal to objects of data file;
+  // on reload the re-read objects are taken from and the removed objects are returned to reload_objects
 
+void
+OksKernel::k_replay_journal(OksFile * fp, oks::ReloadObjects * reload_objects)
+{
+  const std::string journal_name(fp->get_journal_file_name());
 
-        // check that the written file is OK
-	// FIXME: can be removed later, if exceptions work well enough
+  try {
+    std::shared_ptr<oks::MappedFile> m(new oks::MappedFile(journal_name));
 
-    {
-      long written_len = 0;
+      // skip partially written commit
 
-      std::shared_ptr<std::ifstream> f(new std::ifstream(tmp_file_name.c_str()));
+    const std::string_view text(m->data(), m->size());
+    const size_t end = text.rfind(s_journal_commit_tag);
 
-      if(*f) {
-        f->seekg(0, std::ios::end);
-        written_len = static_cast<std::streamoff>(f->tellg());
-      }
+    if(end == std::string_view::npos) {
+      TLOG_DEBUG(2) << "journal \"" << journal_name << "\" has no commits";
+      return;
+    }
 
-      if(written_len != file_len) {
-        unlink(tmp_file_name.c_str());
-        std::ostringstream text;
-        text << "write error in file \'" << tmp_file_name << "\': " << written_len << " bytes been written instead of " << file_len;
-        throw std::runtime_error(text.str().c_str());
-      }
+    if(!p_silence) {
+      std::lock_guard lock(p_parallel_out_mutex);
+      std::cout << " * replay journal \"" << journal_name << "\"...\n";
     }
 
+    OksXmlInputStream xmls(m, 0, end + sizeof(s_journal_commit_tag) - 1, 1, 0);
+    oks::ReadFileParams read_params(fp, xmls, nullptr, this, 'n', reload_objects);
 
-      // remember file's mode
+    std::string id;
 
-    struct stat buf;
-    if(int code = stat(pf->p_full_name.c_str(), &buf)) {
-      std::ostringstream text;
-      text << "cannot get information about file \'" << pf->p_full_name << "\': stat() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
-      throw std::runtime_error(text.str().c_str());
-    }
+    while(!xmls.at_end()) {
+      const char * tag = xmls.get_tag_start();
 
+      if(oks::cmp_str3(tag, "obj")) {
+        OksClass * c = read_journal_record(*this, xmls, id);
+        OksObject * o(reload_objects ? reload_objects->pop(c, id) : nullptr);
 
-      // rename temporal file
+        if(o == nullptr) {
+          o = c->get_object(id);
+        }
 
-    if(int code = rename(tmp_file_name.c_str(), pf->p_full_name.c_str())) {
-      std::ostringstream text;
-      text << "cannot rename file \'" << tmp_file_name << "\' to \'" << pf->p_full_name << "\': rename() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
-      throw std::runtime_error(text.str().c_str());
-    }
+        if(o) {
+          o->materialize();
+          o->read_body(read_params, true);
+        }
+        else {
+          o = new OksObject(read_params, c, id);
 
-    tmp_file_name.erase(0);
+          if(reload_objects) {
+            reload_objects->created.push_back(o);
+            o->create_notify();
+          }
+        }
+      }
+      else if(oks::cmp_str3(tag, s_journal_del_tag)) {
+        OksClass * c = read_journal_record(*this, xmls, id);
 
+          // the object can be moved to another file
 
-    if(pf != p_active_data) {
-      try {
-        pf->unlock();
+        if(OksObject * o = c->get_object(id)) {
+          if(o->file == fp) {
+            if(reload_objects) {
+              reload_objects->put(o);
+            }
+            else {
+              delete o;
+            }
+          }
+        }
       }
-      catch(oks::exception& ex) {
-        throw std::runtime_error(ex.what());
+      else if(oks::cmp_str7(tag, "commit/")) {
+        ;
       }
-    }
-    pf->p_is_updated = false;
-    pf->update_status_of_file();
+      else if(oks::cmp_str7(tag, s_journal_tag)) {
+        std::string size, mtime;
 
+        while(true) {
+          OksXmlAttribute attr(xmls);
 
-      // get mode for new file
+          if(oks::cmp_str1(attr.name(), ">") || oks::cmp_str1(attr.name(), "/")) {
+            break;
+          }
+          else if(oks::cmp_str4(attr.name(), "size")) {
+            size.assign(attr.value(), attr.value_len());
+          }
+          else if(oks::cmp_str5(attr.name(), "mtime")) {
+            mtime.assign(attr.value(), attr.value_len());
+          }
+          else {
+            xmls.throw_unexpected_attribute(attr.name());
+          }
+        }
 
-    struct stat buf2;
-    if(int code = stat(pf->p_full_name.c_str(), &buf2)) {
-      std::ostringstream text;
-      text << "cannot get information about file \'" << pf->p_full_name << "\': stat() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
-      throw std::runtime_error(text.str().c_str());
-    }
+          // the file was rewritten without removal of journal, e.g. by another tool
 
+        struct stat buf;
 
-      // set file's mode if needed
+        if(stat(fp->p_full_name.c_str(), &buf) != 0 || size != std::to_string(buf.st_size) || mtime != journal_mtime(buf)) {
+          if(!p_silence) {
+            std::lock_guard lock(p_parallel_out_mutex);
+            Oks::warning_msg("OksKernel::k_replay_journal()") << "  ignore journal \"" << journal_name << "\" since data file \"" << fp->p_full_name << "\" was modified after the journal was created\n";
+          }
 
-    if(buf.st_mode != buf2.st_mode) {
-      if(int code = chmod(pf->p_full_name.c_str(), buf.st_mode) != 0) {
-        std::ostringstream text;
-        text << "cannot set protection mode for file \'" << pf->p_full_name << "\': chmod() failed with code " << code << ", reason = \'" << oks::strerror(errno) << '\'';
-        throw std::runtime_error(text.str().c_str());
+          fp->p_journal_complete = false; // next save rewrites the file and removes the journal
+          return;
+        }
       }
-    }
-
-      // set file's group if needed (in case of problems report error, but do not throw exception)
-
-    if(buf.st_gid != buf2.st_gid) {
-      if(int code = chown(pf->p_full_name.c_str(), (gid_t)(-1), buf.st_gid) != 0) {
-        ers::warning(oks::kernel::SetGroupIdFailed(ERS_HERE, buf.st_gid, pf->p_full_name.c_str(), code, oks::strerror(errno)));
+      else {
+        xmls.throw_unexpected_tag(tag, "obj");
       }
     }
 
+    fp->p_journal_objects.clear();
+    fp->p_journal_removed.clear();
   }
-
   catch (oks::exception & e) {
-    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
-    if(!tmp_file_name.empty()) { unlink(tmp_file_name.c_str()); }
-    throw oks::CanNotWriteToFile("k_save_data", "data file", pf->p_full_name, e);
+    throw oks::FailedLoadFile("journal", journal_name, e);
   }
   catch (std::exception & e) {
-    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
-    if(!tmp_file_name.empty()) { unlink(tmp_file_name.c_str()); }
-    throw oks::CanNotWriteToFile("k_save_data", "data file", pf->p_full_name, e.what());
+    throw oks::FailedLoadFile("journal", journal_name, e.what());
   }
-  catch (...) {
-    if(pf != p_active_data) { try { pf->unlock();} catch(...) {} }
-    if(!tmp_file_name.empty()) { unlink(tmp_file_name.c_str()); }
-    throw oks::CanNotWriteToFile("k_save_data", "data file", pf->p_full_name, "unknown");
-  }
-
-  OSK_VERBOSE_REPORT("LEAVE " << fname)
 }
 
 
@@ -4164,6 +5634,44 @@ OksKernel::save_as_data(const std::string& new_name, OksFile * pf)
 }
 
 
+struct OksSaveDataJob : public OksJob
+{
+  public:
+
+    OksSaveDataJob( OksKernel * kernel, OksFile * fp, std::exception_ptr& error )
+      : m_kernel (kernel),
+        m_fp     (fp),
+        m_error  (error)
+    { ; }
+
+    void run()
+    {
+      try {
+        m_kernel->k_save_data(m_fp);
+      }
+      catch (...) {
+        m_error = std::current_exception();
+      }
+    }
+
+
+  private:
+
+    OksKernel * m_kernel;
+    OksFile * m_fp;
+    std::exception_ptr& m_error;
+
+
+      // protect usage of copy constructor and assignment operator
+
+  private:
+
+    OksSaveDataJob(const OksSaveDataJob&);
+    OksSaveDataJob& operator=(const OksSaveDataJob &);
+
+};
+
+
 void
 OksKernel::save_all_data()
 {
@@ -4172,14 +5680,77 @@ OksKernel::save_all_data()
   {
     std::shared_lock lock(p_kernel_mutex);
 
+    std::vector<OksFile *> files;
+
     for(OksFile::Map::iterator i = p_data_files.begin(); i != p_data_files.end(); ++i) {
       if(check_read_only(i->second) == false) {
-        k_save_data(i->second);
+        files.push_back(i->second);
       }
       else {
         TLOG_DEBUG(2) << "skip read-only data file \'" << *(i->first) << '\'';
       }
     }
+
+    if(p_parallel_save && p_threads_pool_size > 1 && files.size() > 1) {
+      std::vector<std::exception_ptr> errors(files.size());
+
+      {
+        OksPipeline pipeline(std::min<size_t>(p_threads_pool_size, files.size()));
+
+        for(size_t i = 0; i < files.size(); ++i) {
+          pipeline.addJob(new OksSaveDataJob(this, files[i], errors[i]));
+        }
+
+        pipeline.waitForCompletion();
+      }
+
+        // report all errors by single exception
+
+      std::exception_ptr first_error;
+      std::string names, text;
+      size_t count(0);
+
+      for(size_t i = 0; i < files.size(); ++i) {
+        if(errors[i]) {
+          if(count++) {
+            names += "\', \'";
+            text += '\n';
+          }
+          else {
+            first_error = errors[i];
+          }
+
+          names += files[i]->get_full_file_name();
+
+            // the names of files are already reported, so only nested reasons are added
+
+          try {
+            std::rethrow_exception(errors[i]);
+          }
+          catch(oks::CanNotWriteToFile& ex) {
+            text += ex.reason();
+          }
+          catch(std::exception& ex) {
+            text += ex.what();
+          }
+          catch(...) {
+            text += "unknown exception";
+          }
+        }
+      }
+
+      if(count == 1) {
+        std::rethrow_exception(first_error);
+      }
+      else if(count > 1) {
+        throw oks::CanNotWriteToFile("save_all_data", "data files", names, text);
+      }
+    }
+    else {
+      for(const auto& f : files) {
+        k_save_data(f);
+      }
+    }
   }
 
   TLOG_DEBUG(4) << "exit";
@@ -4217,6 +5788,8 @@ OksKernel::k_close_data(OksFile * fp, bool unbind)
     std::cout << (fp->p_included_by ? " * c" : "C") << "lose OKS data \"" << fp->p_full_name << "\"..." << std::endl;
   }
 
+  k_invalidate_reverse_refs();
+
   if(unbind) {
     for(OksObject::Set::const_iterator i = p_objects.begin(); i != p_objects.end(); ++i) {
       OksObject *o = *i;
@@ -4225,6 +5798,8 @@ OksKernel::k_close_data(OksFile * fp, bool unbind)
   }
 
   if(p_close_all == false) {
+    fp->p_journal_complete = false; // do not record removal of objects of closed file
+
     std::list<OksObject *> * olist = create_list_of_data_objects(fp);
 
     if(olist) {
@@ -4341,17 +5916,10 @@ OksKernel::create_list_of_data_objects(OksFile * fp) const
   OSK_VERBOSE_REPORT("ENTER " << fname)
 
 
-  std::list<OksObject *> * olist = new std::list<OksObject *>();
-
-  if(!p_objects.empty()) {
-    for(OksObject::Set::const_iterator i = p_objects.begin(); i != p_objects.end(); ++i) {
-      if((*i)->file == fp) olist->push_back(*i);
-    }
-  }
+  std::list<OksObject *> * olist = nullptr;
 
-  if(olist->empty()) {
-    delete olist;
-    olist = 0;
+  if(!fp->p_objects.empty()) {
+    olist = new std::list<OksObject *>(fp->p_objects.begin(), fp->p_objects.end());
   }
 
 
@@ -4377,6 +5945,8 @@ OksKernel::k_bind_objects()
 {
   TLOG_DEBUG(4) << "enter";
 
+  k_invalidate_reverse_refs();
+
   p_bind_objects_status.clear();
 
   if(!p_objects.empty()) {
@@ -4410,47 +5980,142 @@ OksKernel::k_bind_objects()
 void
 OksKernel::unbind_all_rels(const OksObject::FSet& rm_objs, OksObject::FSet& updated) const
 {
-  const OksClass::Map& all_classes(classes());
+  std::lock_guard lock(p_reverse_refs_mutex);
 
-  for(OksClass::Map::const_iterator i = all_classes.begin(); i != all_classes.end(); ++i) {
-    OksClass * c(i->second);
-    if(const OksObject::Map * objs = i->second->objects()) {
-      for(OksObject::Map::const_iterator j = objs->begin(); j != objs->end(); ++j) {
-        OksObject *o(j->second);
-        unsigned short l1 = c->number_of_all_attributes();
-        unsigned short l2 = l1 + c->number_of_all_relationships();
+  for(const auto& x : rm_objs) {
+    if(const ReverseRefs * refs = k_get_reverse_refs(x)) {
+      for(const auto& i : *refs) {
+        OksObject *o(i.first);
+        OksData * d(o->data + o->uid.class_id->data_info(i.second->get_name())->offset);
 
-        while(l1 < l2) {
-          OksDataInfo odi(l1, (OksRelationship *)0);
-          OksData * d(o->GetRelationshipValue(&odi));
-
-          if(d->type == OksData::object_type) {
-            if(rm_objs.find(d->data.OBJECT) != rm_objs.end()) {
+        if(d->type == OksData::object_type) {
+          if(d->data.OBJECT == x) {
+            updated.insert(o);
+            d->Set(x->GetClass(), x->GetId());
+            TLOG_DEBUG(5) << "set relationship of " << o << ": " << *d;
+          }
+        }
+        else if(d->type == OksData::list_type) {
+          for(const auto& lid : *d->data.LIST) {
+            if(lid->type == OksData::object_type && lid->data.OBJECT == x) {
               updated.insert(o);
-              const OksClass * __c(d->data.OBJECT->GetClass());
-              const OksString& __id(d->data.OBJECT->GetId());
-              d->Set(__c,__id);
+              lid->Set(x->GetClass(), x->GetId());
               TLOG_DEBUG(5) << "set relationship of " << o << ": " << *d;
             }
           }
-          else if(d->type == OksData::list_type) {
-            for(OksData::List::const_iterator li = d->data.LIST->begin(); li != d->data.LIST->end(); ++li) {
-              OksData * lid(*li);
-              if(lid->type == OksData::object_type) {
-                if(rm_objs.find(lid->data.OBJECT) != rm_objs.end()) {
-		  updated.insert(o);
-                  const OksClass * __c(lid->data.OBJECT->GetClass());
-                  const OksString& __id(lid->data.OBJECT->GetId());
-		  lid->Set(__c,__id);
-                  TLOG_DEBUG(5) << "set relationship of " << o << ": " << *d;
-                }
-              }
-            }
+        }
+      }
+
+      p_reverse_refs.erase(x);
+    }
+  }
+}
+
+
+const OksKernel::ReverseRefs *
+OksKernel::k_get_reverse_refs(const OksObject * o) const
+{
+  if(!p_reverse_refs_valid) {
+    p_reverse_refs.clear();
+    p_reverse_refs.reserve(p_objects.size());
+
+    for(const auto& i : p_classes) {
+      const OksClass * c(i.second);
+
+      if(c->p_all_relationships == nullptr || c->p_all_relationships->empty()) continue;
+
+      if(const OksObject::Map * objs = c->objects()) {
+        for(const auto& j : *objs) {
+          OksObject * o2(j.second);
+          o2->materialize();
+
+          const OksData * d(o2->data + c->number_of_all_attributes());
+
+          for(const auto& r : *c->p_all_relationships) {
+            k_set_reverse_refs(o2, r, *d++, true);
           }
-          ++l1;
         }
       }
     }
+
+    p_reverse_refs_valid = true;
+  }
+
+  auto i = p_reverse_refs.find(o);
+  return (i != p_reverse_refs.end() ? &i->second : nullptr);
+}
+
+
+void
+OksKernel::k_set_reverse_refs(OksObject * o, const OksRelationship * r, const OksData& d, bool add) const
+{
+  auto set_ref = [&](const OksObject * x) {
+    if(add) {
+      p_reverse_refs[x].emplace_back(o, r);
+    }
+    else {
+      auto i = p_reverse_refs.find(x);
+      if(i != p_reverse_refs.end()) {
+        ReverseRefs& refs(i->second);
+        auto j = std::find(refs.begin(), refs.end(), std::make_pair(o, r));
+        if(j != refs.end()) {
+          *j = refs.back();
+          refs.pop_back();
+          if(refs.empty()) p_reverse_refs.erase(i);
+        }
+      }
+    }
+  };
+
+  if(d.type == OksData::object_type) {
+    if(d.data.OBJECT) set_ref(d.data.OBJECT);
+  }
+  else if(d.type == OksData::list_type && d.data.LIST) {
+    for(const auto& i : *d.data.LIST) {
+      if(i->type == OksData::object_type && i->data.OBJECT) set_ref(i->data.OBJECT);
+    }
+  }
+}
+
+
+void
+OksKernel::k_invalidate_reverse_refs()
+{
+  std::lock_guard lock(p_reverse_refs_mutex);
+  p_reverse_refs_valid = false;
+  p_reverse_refs.clear();
+}
+
+
+void
+OksKernel::k_update_reverse_refs(OksObject * o, const OksRelationship * r, const OksData& d, bool add)
+{
+  if(p_reverse_refs_valid) {
+    std::lock_guard lock(p_reverse_refs_mutex);
+    if(p_reverse_refs_valid) k_set_reverse_refs(o, r, d, add);
+  }
+}
+
+
+void
+OksKernel::k_remove_reverse_refs(OksObject * o)
+{
+  if(p_reverse_refs_valid) {
+    std::lock_guard lock(p_reverse_refs_mutex);
+
+    if(p_reverse_refs_valid) {
+      const OksClass * c(o->uid.class_id);
+
+      if(o->data && o->is_read() && c->p_all_relationships) {
+        const OksData * d(o->data + c->number_of_all_attributes());
+
+        for(const auto& r : *c->p_all_relationships) {
+          k_set_reverse_refs(o, r, *d++, false);
+        }
+      }
+
+      p_reverse_refs.erase(o);
+    }
   }
 }
 
@@ -4499,6 +6164,8 @@ OksKernel::k_remove(OksClass *c)
 
   if(OksClass::delete_notify_fn) (*OksClass::delete_notify_fn)(c);
 
+  k_invalidate_reverse_refs();
+
   p_classes.erase(c->get_name().c_str());
 }
 
@@ -8,6 +8,8 @@
 #include <stdexcept>
 #include <sstream>
 
+#include "oks_utils.h"
+
 
 const char OksMethodImplementation::method_impl_xml_tag[] = "method-implementation";
 const char OksMethodImplementation::language_xml_attr[]   = "language";
@@ -292,6 +294,39 @@ OksMethod::OksMethod(OksXmlInputStream& s, OksClass * parent) :
 }
 
 
+OksMethod::OksMethod(oks::BinaryInputStream& s, OksClass * parent) :
+ p_class           (parent),
+ p_name            (s.get_string()),
+ p_description     (s.get_string()),
+ p_implementations (0)
+{
+  for(uint32_t num = s.get<uint32_t>(); num; --num) {
+    const std::string& language(s.get_string());
+    const std::string& prototype(s.get_string());
+    const std::string& body(s.get_string());
+
+    if(!p_implementations) p_implementations = new std::list<OksMethodImplementation *>();
+    p_implementations->push_back(new OksMethodImplementation(language, prototype, body, this));
+  }
+}
+
+void
+OksMethod::put(oks::BinaryOutputStream& s) const
+{
+  s.put(p_name);
+  s.put(p_description);
+  s.put(static_cast<uint32_t>(p_implementations ? p_implementations->size() : 0));
+
+  if(p_implementations) {
+    for(const auto& x : *p_implementations) {
+      s.put(x->p_language);
+      s.put(x->p_prototype);
+      s.put(x->p_body);
+    }
+  }
+}
+
+
 void
 OksMethod::set_name(const std::string& new_name)
 {
@@ -9,6 +9,7 @@
 #include "oks/index.hpp"
 #include "oks/profiler.hpp"
 #include "oks/cstring.hpp"
+#include "oks/visitor.hpp"
 
 #include "oks_utils.h"
 
@@ -313,6 +314,10 @@ OksObject::init3(OksClass * c)
     for(auto& i : *c->p_indices) i.second->insert(this);
   }
 
+  c->for_each_hash_index([this](OksHashIndex * i) { i->insert(this); });
+  c->for_each_composite_index([this](OksCompositeIndex * i) { i->insert(this); });
+  c->for_each_inverted_index([this](OksInvertedIndex * i) { i->insert(this); });
+
   c->add(this);
   c->p_kernel->define(this);
 }
@@ -349,6 +354,8 @@ OksObject::init3()
 void
 oks::ReadFileParams::init()
 {
+  shared_strings = (oks_kernel && oks_kernel->get_shared_strings_mode());
+
   if(format != 'c') {
     object_tag = OksObject::obj_xml_tag;
     object_tag_len = sizeof(OksObject::obj_xml_tag);
@@ -416,6 +423,7 @@ OksObject::read(const oks::ReadFileParams& read_params)
 
   if(c && read_params.reload_objects) {
     if(OksObject * o = read_params.reload_objects->pop(c, id)) {
+      o->materialize();
       o->read_body(read_params, true);
       return o;
     }
@@ -501,11 +509,8 @@ __throw_unknown_type(const oks::ReadFileParams& params, const char * atype)
 int32_t
 OksObject::__get_num(const oks::ReadFileParams& params)
 {
-  char * __sanity;
-  params.s.get_num_token('\"');
-  int32_t num = static_cast<int32_t>(strtol(params.s.m_cvt_char->m_buf, &__sanity, 0));
-  if(*__sanity != 0 || errno == ERANGE) OksXmlInputStream::__throw_strto("strtol", __sanity, params.s.m_cvt_char->m_buf, params.s.get_line_no(), params.s.get_line_pos());
-  return num;
+  size_t len = params.s.get_num_token('\"');
+  return oks::read_num<int32_t>(params.s.m_cvt_char->m_buf, len, params.s.get_line_no(), params.s.get_line_pos());
 }
 
 
@@ -521,12 +526,15 @@ OksObject::read_body(const oks::ReadFileParams& read_params, bool re_read)
   bool was_updated = false;                           // is used when object is re-read from file
   bool check_re_read = (re_read && read_params.oks_kernel->p_change_object_notify_fn);
 
-  char * __sanity;                                    // used to check mu, token
-
 
-    // set file from which this object was read
+    // set file from which this object was read (on reload the object can be moved from another file)
 
-  file = read_params.f;
+  if(re_read && file != read_params.f) {
+    read_params.oks_kernel->redefine(this, read_params.f);
+  }
+  else {
+    file = read_params.f;
+  }
 
 
     // is used by ReadFrom(relationship)
@@ -648,8 +656,7 @@ OksObject::read_body(const oks::ReadFileParams& read_params, bool re_read)
               }
             }
             else if(read_params.format != 'n' && oks::cmp_str3(attr.name(), num_xml_attribute)) {
-              num = static_cast<int32_t>(strtol(attr.value(), &__sanity, 0));
-              if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, attr.value(), read_params.s.get_line_no(), read_params.s.get_line_pos());
+              num = oks::read_num<int32_t>(attr.value(), attr.value_len(), read_params.s.get_line_no(), read_params.s.get_line_pos());
             }
             else if(read_params.format == 'n' && oks::cmp_str3(attr.name(), value_xml_attribute)) {
               value = read_params.s.get_value(attr.p_value_len);
@@ -715,7 +722,7 @@ OksObject::read_body(const oks::ReadFileParams& read_params, bool re_read)
                 if(read_params.format != 'n')
                   dx->read(read_params, a);
                 else
-                  dx->read(a, value);
+                  dx->read(a, value, read_params.shared_strings);
               }
             }
             else {
@@ -868,8 +875,7 @@ OksObject::read_body(const oks::ReadFileParams& read_params, bool re_read)
             }
             else {
               if(oks::cmp_str3(attr.name(), num_xml_attribute)) {
-                num = static_cast<int32_t>(strtol(attr.value(), &__sanity, 0));
-                if( __builtin_expect((*__sanity != 0 || errno == ERANGE), 0) ) OksXmlInputStream::__throw_strto("strtoul", __sanity, attr.value(), read_params.s.get_line_no(), read_params.s.get_line_pos());
+                num = oks::read_num<int32_t>(attr.value(), attr.value_len(), read_params.s.get_line_no(), read_params.s.get_line_pos());
                 continue;
               }
             }
@@ -1149,7 +1155,7 @@ OksObject::read_body(const oks::ReadFileParams& read_params, bool re_read)
   if(was_updated) change_notify();
 }
 
-OksObject::OksObject(const oks::ReadFileParams& read_params, OksClass * c, const std::string& id) : data(nullptr), p_duplicated_object_id_idx(-1)
+OksObject::OksObject(const oks::ReadFileParams& read_params, OksClass * c, const std::string& id) : data(nullptr), p_lazy(nullptr), p_duplicated_object_id_idx(-1)
 {
   if(c) {
     OSK_PROFILING(OksProfiler::ObjectStreamConstructor, c->p_kernel)
@@ -1164,7 +1170,22 @@ OksObject::OksObject(const oks::ReadFileParams& read_params, OksClass * c, const
     init1(read_params.f);  // can throw exception; to be caught by caller (i.e. OksKernel)
   }
 
-  read_body(read_params, false);
+  if(read_params.lazy_objects && c && can_read_lazy(c)) {
+    static const char __end_tag[] = "</obj>";
+
+    const size_t begin(read_params.s.get_position());
+    const unsigned long line_no(read_params.s.get_line_no());
+    const unsigned long line_pos(read_params.s.get_line_pos());
+
+    if(read_params.s.skip_element(__end_tag, sizeof(__end_tag) - 1)) {
+      p_lazy = new oks::LazyBody(read_params.s.get_mapped_file(), begin, read_params.s.get_position(), line_no, line_pos, read_params.format);
+      file = read_params.f;
+    }
+  }
+
+  if(!p_lazy) {
+    read_body(read_params, false);
+  }
 
   if(c) {
     init3(c);
@@ -1172,7 +1193,432 @@ OksObject::OksObject(const oks::ReadFileParams& read_params, OksClass * c, const
 }
 
 
-OksObject::OksObject(const OksClass* c, const char *object_id, bool skip_init) : data(nullptr), p_duplicated_object_id_idx(-1)
+  // the body of object can be read on first access, if there are no indices on object's class
+  // and the object has no composite relationships (its reverse composite relationships have to be known after load)
+
+bool
+OksObject::can_read_lazy(const OksClass * c)
+{
+  bool has_indices = (c->p_indices != nullptr);
+  c->for_each_hash_index([&has_indices](OksHashIndex *) { has_indices = true; });
+  c->for_each_composite_index([&has_indices](OksCompositeIndex *) { has_indices = true; });
+  c->for_each_inverted_index([&has_indices](OksInvertedIndex *) { has_indices = true; });
+
+  if(has_indices) {
+    return false;
+  }
+
+  if(c->p_all_relationships) {
+    for(const auto& r : *c->p_all_relationships) {
+      if(r->get_is_composite()) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+
+bool
+OksObject::is_read() const noexcept
+{
+  return (p_lazy == nullptr || p_lazy->m_state.load(std::memory_order_acquire) != oks::LazyBody::unread);
+}
+
+
+  // serialize concurrent first access to objects; use several mutexes to reduce contention
+
+static std::mutex&
+lazy_body_mutex(const OksObject * o)
+{
+  static std::mutex s_mutexes[64];
+  return s_mutexes[(reinterpret_cast<uintptr_t>(o) >> 4) % 64];
+}
+
+void
+OksObject::read_lazy_body() const
+{
+  oks::LazyBody * lb(p_lazy);
+
+  if( __builtin_expect((lb->m_state.load(std::memory_order_acquire) == oks::LazyBody::bound), 1) ) return;
+
+  std::lock_guard lock(lazy_body_mutex(this));
+
+  if(lb->m_state.load(std::memory_order_relaxed) == oks::LazyBody::bound) return;
+
+  OksObject * o(const_cast<OksObject *>(this));
+  const OksClass * c(uid.class_id);
+  OksKernel * k(c->p_kernel);
+
+  TLOG_DEBUG(4) << "read body of object " << this << " on first access";
+
+  try {
+    OksXmlInputStream s(lb->m_file, lb->m_begin, lb->m_end, lb->m_line_no, lb->m_line_pos);
+    OksAliasTable alias_table;
+    oks::ReadFileParams read_params(file, s, ((lb->m_format == 'X') ? nullptr : &alias_table), k, lb->m_format, nullptr);
+    o->read_body(read_params, false);
+  }
+  catch(std::exception& ex) {
+    OksData *d_end = data + c->number_of_all_attributes() + c->number_of_all_relationships();
+    for(OksData *di = data; di < d_end; ++di) {
+      di->Clear();
+    }
+
+    o->init2();
+
+    std::lock_guard out_lock(OksKernel::p_parallel_out_mutex);
+    Oks::error_msg("OksObject::read_lazy_body()")
+      << "  cannot read object " << this << " from file \"" << file->get_full_file_name() << "\":\n" << ex.what() << std::endl;
+  }
+
+  lb->m_state.store(oks::LazyBody::read, std::memory_order_release);
+
+
+    // binding changes reverse composite relationships of referenced objects; it is not thread-safe
+
+  {
+    static std::mutex s_bind_mutex;
+    std::lock_guard bind_lock(s_bind_mutex);
+
+    try {
+      o->bind_objects();
+    }
+    catch(oks::ObjectBindError& ex) {
+      if(ex.p_is_error || !k->get_silence_mode()) {
+        std::lock_guard out_lock(OksKernel::p_parallel_out_mutex);
+        Oks::warning_msg("OksObject::read_lazy_body()") << ex.what() << std::endl;
+      }
+    }
+  }
+
+  lb->m_file.reset();
+  lb->m_state.store(oks::LazyBody::bound, std::memory_order_release);
+}
+
+
+void
+OksObject::visit_values(OksXmlInputStream& s, oks::DataVisitor& visitor, bool is_attr, bool accept)
+{
+  std::string class_name;
+
+  while(true) {
+    const char * tag_start = s.get_tag_start();
+
+      // check for closing tag
+
+    if(is_attr) {
+      if(*tag_start == '/' && oks::cmp_str5n(tag_start+1, OksObject::attribute_xml_tag)) break;
+      if(!oks::cmp_str4(tag_start, OksObject::data_xml_tag)) s.throw_unexpected_tag(tag_start, OksObject::data_xml_tag);
+    }
+    else {
+      if(*tag_start == '/' && oks::cmp_str4n(tag_start+1, OksObject::relationship_xml_tag)) break;
+      if(!oks::cmp_str3(tag_start, OksObject::ref_xml_tag)) s.throw_unexpected_tag(tag_start, OksObject::ref_xml_tag);
+    }
+
+    OksXmlValue value;
+    class_name.clear();
+
+    while(true) {
+      OksXmlAttribute attr(s);
+
+      if(oks::cmp_str1(attr.name(), ">") || oks::cmp_str1(attr.name(), "/")) { break; }
+      else if(is_attr && oks::cmp_str3(attr.name(), OksObject::value_xml_attribute)) value = s.get_value(attr.p_value_len);
+      else if(!is_attr && oks::cmp_str5(attr.name(), OksObject::class_xml_attribute)) class_name.assign(attr.value(), attr.value_len());
+      else if(!is_attr && oks::cmp_str2(attr.name(), OksObject::id_xml_attribute)) value = s.get_value(attr.p_value_len);
+      else s.throw_unexpected_attribute(attr.name());
+    }
+
+    if(accept && !value.is_empty()) {
+      if(is_attr)
+        visitor.attribute_value(value.buf(), value.len());
+      else
+        visitor.relationship_value(class_name.c_str(), value.buf());
+    }
+  }
+}
+
+bool
+OksObject::visit(const oks::ReadFileParams& read_params, oks::DataVisitor& visitor)
+{
+  OksXmlInputStream& s(read_params.s);
+
+    // read 'object' tag header
+
+  try {
+    const char * tag_start(s.get_tag_start());
+
+    if(memcmp(tag_start, read_params.object_tag, read_params.object_tag_len)) {
+      if(!oks::cmp_str9(tag_start, "/oks-data")) {
+        s.throw_unexpected_tag(tag_start, read_params.object_tag);
+      }
+      return false;
+    }
+  }
+  catch (oks::exception & e) {
+    throw oks::FailedRead("start-of-object tag", e);
+  }
+  catch (std::exception & e) {
+    throw oks::FailedRead("start-of-object tag", e.what());
+  }
+
+
+    // read object tag attributes
+
+  std::string class_name;
+  std::string& id((const_cast<oks::ReadFileParams&>(read_params)).tmp);
+  bool is_closed(false);
+
+  id.clear();
+
+  try {
+    while(true) {
+      OksXmlAttribute attr(s);
+
+      if(oks::cmp_str1(attr.name(), ">")) { break; }
+      else if(oks::cmp_str1(attr.name(), "/")) { is_closed = true; break; }
+      else if(oks::cmp_str5(attr.name(), class_xml_attribute)) class_name.assign(attr.value(), attr.value_len());
+      else if(oks::cmp_str2(attr.name(), id_xml_attribute)) id.assign(attr.value(), attr.value_len());
+      else s.throw_unexpected_attribute(attr.name());
+    }
+  }
+  catch(oks::exception & e) {
+    throw oks::FailedRead("object header", e);
+  }
+  catch (std::exception & e) {
+    throw oks::FailedRead("object header", e.what());
+  }
+
+  if(class_name.empty()) {
+    throw oks::BadFileData("object without class", s.get_line_no(), s.get_line_pos());
+  }
+
+  try {
+    oks::validate_not_empty(id, "object id");
+  }
+  catch(std::exception& ex) {
+    throw oks::FailedRead("oks object", oks::BadFileData(ex.what(), s.get_line_no(), s.get_line_pos()));
+  }
+
+  const bool accept(visitor.begin_object(class_name.c_str(), id.c_str()));
+
+  if(is_closed) {
+    if(accept) visitor.end_object();
+    return true;
+  }
+
+
+    // skip body of not accepted object without parsing, when possible
+
+  if(!accept && s.is_mapped()) {
+    static const char __end_tag[] = "</obj>";
+    if(s.skip_element(__end_tag, sizeof(__end_tag) - 1)) return true;
+  }
+
+
+    // read object body
+
+  std::string name, type, ref_class;
+
+  try {
+    while(true) {
+      const char * tag_start = s.get_tag_start();
+
+        // check for closing tag
+
+      if(*tag_start == '/' && !memcmp(tag_start + 1, read_params.object_tag, read_params.object_tag_len)) { break; }
+
+        // extra check, if the object is empty
+
+      if(oks::cmp_str3(tag_start, "obj")) {
+        s.seek_position(-5);
+        break;
+      }
+
+      const bool is_attr(oks::cmp_str4(tag_start, attribute_xml_tag));
+
+      if(!is_attr && !oks::cmp_str3(tag_start, relationship_xml_tag)) {
+        s.throw_unexpected_tag(tag_start);
+      }
+
+      OksXmlValue value;
+      bool is_value_closed(false);
+
+      name.clear();
+      type.clear();
+      ref_class.clear();
+
+      while(true) {
+        OksXmlAttribute attr(s);
+
+        if(oks::cmp_str1(attr.name(), ">")) { break; }
+        else if(oks::cmp_str1(attr.name(), "/")) { is_value_closed = true; break; }
+        else if(oks::cmp_str4(attr.name(), name_xml_attribute)) name.assign(attr.value(), attr.value_len());
+        else if(is_attr && oks::cmp_str4(attr.name(), type_xml_attribute)) type.assign(attr.value(), attr.value_len());
+        else if(is_attr && oks::cmp_str3(attr.name(), value_xml_attribute)) value = s.get_value(attr.p_value_len);
+        else if(!is_attr && oks::cmp_str5(attr.name(), class_xml_attribute)) ref_class.assign(attr.value(), attr.value_len());
+        else if(!is_attr && oks::cmp_str2(attr.name(), id_xml_attribute)) value = s.get_value(attr.p_value_len);
+        else s.throw_unexpected_attribute(attr.name());
+      }
+
+      if(name.empty()) {
+        throw oks::BadFileData((is_attr ? "attribute without name" : "relationship without name"), s.get_line_no(), s.get_line_pos());
+      }
+
+        // single value is stored in the tag; multi-value is stored in nested tags
+
+      if(!value.is_empty()) {
+        if(accept) {
+          if(is_attr)
+            visitor.attribute(name.c_str(), type.c_str(), value.buf(), value.len());
+          else
+            visitor.relationship(name.c_str(), ref_class.c_str(), value.buf());
+        }
+      }
+      else {
+        if(accept) {
+          if(is_attr)
+            visitor.begin_multi_value_attribute(name.c_str(), type.c_str());
+          else
+            visitor.begin_multi_value_relationship(name.c_str());
+        }
+
+        if(!is_value_closed) {
+          visit_values(s, visitor, is_attr, accept);
+        }
+
+        if(accept) {
+          if(is_attr)
+            visitor.end_multi_value_attribute();
+          else
+            visitor.end_multi_value_relationship();
+        }
+      }
+    }
+  }
+  catch (oks::exception & e) {
+    throw oks::FailedRead(std::string("object \"") + id + '@' + class_name + '\"', e);
+  }
+  catch (std::exception & e) {
+    throw oks::FailedRead(std::string("object \"") + id + '@' + class_name + '\"', e.what());
+  }
+
+  if(accept) visitor.end_object();
+
+  return true;
+}
+
+
+OksObject *
+OksObject::read(oks::BinaryInputStream& s, OksFile * f)
+{
+    // check if this is the end of file
+
+  if(s.at_end()) { return nullptr; }
+
+  const oks::BinaryClassInfo& c(s.get_class());
+  const std::string& id(s.get_string());
+
+  if( __builtin_expect((c.oks_class == nullptr), 0) ) {
+    std::ostringstream text;
+    text << "cannot find class \"" << *c.name << "\" (offset " << s.get_position() << ')';
+    throw std::runtime_error( text.str().c_str() );
+  }
+
+  return new OksObject(s, c, id, f);  // can throw exception
+}
+
+void
+OksObject::read_body(oks::BinaryInputStream& s, const oks::BinaryClassInfo& c)
+{
+  try {
+
+      // fast path: the values are stored in the order of schema and have schema types
+
+    if( __builtin_expect((c.same_layout), 1) ) {
+      OksData * d(data);
+
+      for(const auto& x : c.attributes) {
+        d->read(s, x.info->attribute);
+        d->check_range(x.info->attribute);
+        ++d;
+      }
+
+      for(const auto& x : c.relationships) {
+        (d++)->read(s, x.info->relationship, this);
+      }
+    }
+
+      // the schema was changed since the snapshot was written
+
+    else {
+      init2();
+
+      for(const auto& x : c.attributes) {
+        const OksData::Type type(x.type != OksData::enum_type ? static_cast<OksData::Type>(x.type) : OksData::string_type);
+
+        if( __builtin_expect((x.info == nullptr), 0) ) {
+          OksAttribute a2(type, uid.class_id);
+          OksData d2;
+          d2.read(s, &a2);
+        }
+        else if( __builtin_expect((x.convert), 0) ) {
+          OksAttribute a2(type, uid.class_id);
+          OksData d2;
+          d2.read(s, &a2);
+          d2.cvt(&data[x.info->offset], x.info->attribute);
+          data[x.info->offset].check_range(x.info->attribute);
+        }
+        else {
+          data[x.info->offset].read(s, x.info->attribute);
+          data[x.info->offset].check_range(x.info->attribute);
+        }
+      }
+
+      for(const auto& x : c.relationships) {
+        if( __builtin_expect((x.info == nullptr), 0) ) {
+          OksData d2;
+          d2.read(s, nullptr, this);
+        }
+        else if( __builtin_expect((x.convert), 0) ) {
+          OksData d2;
+          d2.read(s, nullptr, this);
+          d2.ConvertTo(&data[x.info->offset], x.info->relationship);
+        }
+        else {
+          data[x.info->offset].read(s, x.info->relationship, this);
+        }
+      }
+    }
+  }
+  catch (oks::exception & e) {
+    throw oks::FailedRead(std::string("object \"") + uid.object_id + '@' + uid.class_id->get_name() + '\"', e);
+  }
+  catch (std::exception & e) {
+    throw oks::FailedRead(std::string("object \"") + uid.object_id + '@' + uid.class_id->get_name() + '\"', e.what());
+  }
+}
+
+OksObject::OksObject(oks::BinaryInputStream& s, const oks::BinaryClassInfo& c, const std::string& id, OksFile * f) : data(nullptr), p_lazy(nullptr), p_duplicated_object_id_idx(-1)
+{
+  OSK_PROFILING(OksProfiler::ObjectStreamConstructor, c.oks_class->p_kernel)
+
+  uid.object_id = id;
+  uid.class_id = c.oks_class;
+
+  std::shared_lock lock(c.oks_class->p_kernel->p_schema_mutex);  // protect schema and all objects from changes
+
+  init1(f);  // can throw exception; to be caught by caller (i.e. OksKernel)
+
+  file = f;
+
+  read_body(s, c);
+
+  init3(c.oks_class);
+}
+
+
+OksObject::OksObject(const OksClass* c, const char *object_id, bool skip_init) : data(nullptr), p_lazy(nullptr), p_duplicated_object_id_idx(-1)
 {
   OSK_PROFILING(OksProfiler::ObjectNormalConstructor, c->p_kernel)
 
@@ -1198,10 +1644,12 @@ OksObject::OksObject(const OksClass* c, const char *object_id, bool skip_init) :
   file->set_updated();
 }
 
-OksObject::OksObject(const OksObject& parentObj, const char *object_id) : data(nullptr), p_duplicated_object_id_idx(-1)
+OksObject::OksObject(const OksObject& parentObj, const char *object_id) : data(nullptr), p_lazy(nullptr), p_duplicated_object_id_idx(-1)
 {
   OSK_PROFILING(OksProfiler::ObjectCopyConstructor, parentObj.uid.class_id->p_kernel)
 
+  parentObj.materialize();
+
   if(!parentObj.uid.class_id->p_kernel->get_active_data()) {
     Oks::error_msg("OksObject::OksObject(const OksObject&, const char *)") << "  Can not create new object since there is no active data file\n";
     return;
@@ -1273,7 +1721,7 @@ OksObject::OksObject(const OksObject& parentObj, const char *object_id) : data(n
   file->set_updated();
 }
 
-OksObject::OksObject(size_t offset, const OksData *d) : data(nullptr), p_duplicated_object_id_idx(-1)
+OksObject::OksObject(size_t offset, const OksData *d) : data(nullptr), p_lazy(nullptr), p_duplicated_object_id_idx(-1)
 {
   uid.class_id = nullptr;
   data = new OksData[offset+1];
@@ -1282,6 +1730,7 @@ OksObject::OksObject(size_t offset, const OksData *d) : data(nullptr), p_duplica
 
 OksObject::OksObject(OksClass * c, const std::string& id, void * user_data, int32_t int32_id, int32_t duplicated_object_id_idx, OksFile * f) :
   data            (new OksData[c->p_instance_size]),
+  p_lazy          (nullptr),
   p_user_data     (user_data),
   p_int32_id      (int32_id),
   p_duplicated_object_id_idx (duplicated_object_id_idx),
@@ -1309,39 +1758,22 @@ OksObject::destroy(OksObject *o, bool fast)
 
   std::unique_ptr<std::ostringstream> error_text;
 
-  const OksClass::Map & classes = o->uid.class_id->p_kernel->classes();
+  {
+    OksKernel * k(o->uid.class_id->p_kernel);
 
-  for(OksClass::Map::const_iterator i = classes.begin(); i != classes.end(); ++i) {
-    OksClass *c(i->second);
-    if(c->p_all_relationships == nullptr || c->p_all_relationships->empty()) continue;
-
-    if(const OksObject::Map * objects = c->objects()) {
-      for(OksObject::Map::const_iterator j = objects->begin(); j != objects->end(); ++j) {
-        size_t offset = c->number_of_all_attributes();
-	for(std::list<OksRelationship *>::iterator k = c->p_all_relationships->begin(); k != c->p_all_relationships->end(); ++k, ++offset) {
-	  OksData * d = j->second->data + offset;
-	  OksObject * ref = nullptr;
-
-	  if(d->type == OksData::object_type && d->data.OBJECT == o) {
-	    ref = j->second;
-	  }
-	  else if(d->type == OksData::list_type && d->data.LIST != nullptr) {
-	    for(const auto& l : *d->data.LIST) {
-	      if(l->type == OksData::object_type && l->data.OBJECT == o) {
-	        ref = j->second;
-		break;
-	      }
-	    }
-	  }
+    std::lock_guard lock(k->p_reverse_refs_mutex);
 
-	  if(ref) {
-            if(!error_text.get()) {
-              error_text.reset(new std::ostringstream());
-              *error_text << "since it is referenced by:";
-            }
-            *error_text << "\n   * object " << ref << " via relationship \"" << (*k)->get_name() << '\"';
-	  }
-	}
+    if(const auto * refs = k->k_get_reverse_refs(o)) {
+      std::set<std::pair<OksObject *, const OksRelationship *>> reported;
+
+      for(const auto& i : *refs) {
+        if(reported.insert(i).second) {
+          if(!error_text.get()) {
+            error_text.reset(new std::ostringstream());
+            *error_text << "since it is referenced by:";
+          }
+          *error_text << "\n   * object " << i.first << " via relationship \"" << i.second->get_name() << '\"';
+        }
       }
     }
   }
@@ -1388,6 +1820,8 @@ OksObject::~OksObject()
 
     delete_notify();
 
+    k->k_remove_reverse_refs(this);
+
     if(data) {
       if(c->p_all_relationships && !c->p_all_relationships->empty()) {
         OksData *di = data + c->number_of_all_attributes();
@@ -1449,6 +1883,10 @@ OksObject::~OksObject()
           i.second->remove_obj(this);
       }
 
+      c->for_each_hash_index([this](OksHashIndex * i) { i->remove_obj(this); });
+      c->for_each_composite_index([this](OksCompositeIndex * i) { i->remove_obj(this); });
+      c->for_each_inverted_index([this](OksInvertedIndex * i) { i->remove_obj(this); });
+
       int count = c->p_instance_size;
       while(count--) data[count].Clear();
 
@@ -1472,6 +1910,8 @@ OksObject::~OksObject()
       delete p_rcr;
     }
 
+    delete p_lazy;
+
     if(k->p_close_all == false) {
       std::lock_guard lock(s_mutex);
       oset.erase(this);
@@ -1493,7 +1933,17 @@ OksObject::set_file(OksFile * f, bool update_owner)
       f->lock();
       f->set_updated();
 
-      file = f;
+      OksKernel * k = uid.class_id->p_kernel;
+
+      if(k->p_journal) {
+        k->journal_remove(this);
+      }
+
+      k->redefine(this, f);
+
+      if(k->p_journal) {
+        k->journal_update(this);
+      }
     }
     catch(oks::exception& ex) {
       throw oks::CanNotSetFile(0, this, *f, ex);
@@ -1542,6 +1992,7 @@ OksObject::set_id(const std::string &new_id)
 
           // avoid multiple notification, when renamed object contains references to self
         if(o != this) {
+          o->materialize();
           for(size_t k = d_begin; k != d_end && o; ++k) {
             const OksData & d = o->data[k];
             if(d.type == OksData::object_type && d.data.OBJECT == this) {
@@ -1576,12 +2027,22 @@ OksObject::set_id(const std::string &new_id)
     throw oks::FailedRenameObject(this, ex);
   }
 
+  OksKernel * k = c->p_kernel;
+
   try {
+    if(k->p_journal) {
+      k->journal_remove(this);  // record old id
+    }
+
     c->remove(this);          // remove object from hash table
     uid.object_id = new_id;   // change id
     c->add(this);             // add object to hash table
   }
   catch(oks::exception& ex) {
+    if(k->p_journal) {
+      k->journal_update(this);  // the journal replays removal and creation of object
+    }
+
     throw oks::FailedRenameObject(this, ex);
   }
 
@@ -1589,7 +2050,7 @@ OksObject::set_id(const std::string &new_id)
     (*i)->set_updated();
   }
 
-  if(get_change_notify()) {
+  if(get_change_notify() || k->p_journal) {
     for(std::list<OksObject *>::const_iterator i = updated_objects.begin(); i != updated_objects.end(); ++i) {
       (*i)->change_notify();
     }
@@ -1616,6 +2077,9 @@ OksObject::operator==(const OksObject &o) const
 
   OSK_PROFILING(OksProfiler::ObjectOperatorEqual, uid.class_id->p_kernel)
 
+  materialize();
+  o.materialize();
+
   size_t count(0);
 
   while (count < uid.class_id->p_instance_size)
@@ -1650,6 +2114,8 @@ std::ostream&
 operator<<(std::ostream& s, const OksObject& o)
 {
   OSK_PROFILING(OksProfiler::ObjectOperatorOut, o.uid.class_id->p_kernel)
+
+  o.materialize();
   
   const OksClass * c = o.uid.class_id;
 
@@ -1781,6 +2247,8 @@ OksObject::put(OksXmlOutputStream& xmls, bool force_defaults) const
 {
   OSK_PROFILING(OksProfiler::ObjectPutObject, uid.class_id->p_kernel)
 
+  materialize();
+
   try
     {
       const OksClass * class_id = uid.class_id;
@@ -1810,8 +2278,7 @@ OksObject::put(OksXmlOutputStream& xmls, bool force_defaults) const
 
                   if (a->is_integer() && a->get_format() != OksAttribute::Dec)
                     {
-                      xmls.get_stream().setf((a->get_format() == OksAttribute::Hex ? std::ios::hex : std::ios::oct), std::ios::basefield);
-                      xmls.get_stream().setf(std::ios::showbase);
+                      xmls.set_base(a->get_format() == OksAttribute::Hex ? 16 : 8);
                     }
 
                   if (a->get_is_multi_values() == false)
@@ -1848,8 +2315,7 @@ OksObject::put(OksXmlOutputStream& xmls, bool force_defaults) const
 
                   if (a->is_integer() && a->get_format() != OksAttribute::Dec)
                     {
-                      xmls.get_stream().setf(std::ios::dec, std::ios::basefield);
-                      xmls.get_stream().unsetf(std::ios::showbase);
+                      xmls.set_base(10);
                     }
                 }
             }
@@ -1915,6 +2381,40 @@ OksObject::put(OksXmlOutputStream& xmls, bool force_defaults) const
     }
 }
 
+void
+OksObject::put(oks::BinaryOutputStream& s) const
+{
+  materialize();
+
+  try
+    {
+      const OksClass * class_id = uid.class_id;
+
+      s.put(class_id);
+      s.put(uid.object_id);
+
+      const size_t num_of_attrs(class_id->number_of_all_attributes());
+      const size_t count(num_of_attrs + class_id->number_of_all_relationships());
+
+      for (size_t i = 0; i < num_of_attrs; ++i)
+        data[i].write(s);
+
+      for (size_t i = num_of_attrs; i < count; ++i)
+        {
+          trim_dangling(data[i], *class_id->p_kernel);
+          data[i].write(s);
+        }
+    }
+  catch (oks::exception & ex)
+    {
+      throw(oks::FailedSaveObject(this, ex));
+    }
+  catch (std::exception & ex)
+    {
+      throw(oks::FailedSaveObject(this, std::string("caught std::exception \"") + ex.what() + '\"'));
+    }
+}
+
 OksData *
 OksObject::GetAttributeValue(const std::string& name) const
 {
@@ -1933,6 +2433,8 @@ OksObject::GetAttributeValue(const std::string& name) const
 void
 OksObject::SetAttributeValue(const OksDataInfo *odi, OksData *d)
 {
+  materialize();
+
   size_t offset = odi->offset;
   const OksAttribute * a = odi->attribute;
   OksData d2; // can be needed by type conversion
@@ -1977,9 +2479,33 @@ OksObject::SetAttributeValue(const OksDataInfo *odi, OksData *d)
       }
     }
 
+    std::vector<OksHashIndex *> hi;
+
+    uid.class_id->for_each_hash_index([a,&hi](OksHashIndex * j) {
+      if(j->a->get_name() == a->get_name()) hi.push_back(j);
+    });
+
+    std::vector<OksCompositeIndex *> ci;
+
+    uid.class_id->for_each_composite_index([a,&ci](OksCompositeIndex * j) {
+      if(j->contains(a)) ci.push_back(j);
+    });
+
+    std::vector<OksInvertedIndex *> ii;
+
+    uid.class_id->for_each_inverted_index([a,&ii](OksInvertedIndex * j) {
+      if(j->a->get_name() == a->get_name()) ii.push_back(j);
+    });
+
     if(i) i->remove_obj(this);
+    for(const auto& j : hi) j->remove_obj(this);
+    for(const auto& j : ci) j->remove_obj(this);
+    for(const auto& j : ii) j->remove_obj(this);
     data[offset] = *d;
     if(i) i->insert(this);
+    for(const auto& j : hi) j->insert(this);
+    for(const auto& j : ci) j->insert(this);
+    for(const auto& j : ii) j->insert(this);
   }
 
   notify();
@@ -2002,6 +2528,14 @@ OksObject::SetAttributeValue(const std::string& name, OksData *d)
 
 OksData *
 OksObject::GetRelationshipValue(const std::string& name) const
+{
+  OksData * d(get_relationship_value(name));
+  drop_reverse_refs();
+  return d;
+}
+
+OksData *
+OksObject::get_relationship_value(const std::string& name) const
 {
   OksDataInfo::Map::iterator i = uid.class_id->p_data_info->find(name);
   
@@ -2011,7 +2545,17 @@ OksObject::GetRelationshipValue(const std::string& name) const
     throw oks::ObjectGetError(this, false, name, text.str());
   }
 
-  return GetRelationshipValue(i->second);
+  return get_relationship_value(i->second);
+}
+
+  // the value returned to user can be modified in place bypassing reverse references index
+
+void
+OksObject::drop_reverse_refs() const noexcept
+{
+  if(uid.class_id) {
+    uid.class_id->p_kernel->k_drop_reverse_refs();
+  }
 }
 
 
@@ -2054,6 +2598,8 @@ OksObject::check_class_type(const OksRelationship *r, const OksClass *class_type
 void
 OksObject::SetRelationshipValue(const OksDataInfo *odi, OksData *d, bool skip_non_null_check)
 {
+  materialize();
+
   const OksRelationship * r = odi->relationship;
   size_t offset = odi->offset;
 
@@ -2179,6 +2725,9 @@ OksObject::SetRelationshipValue(const OksDataInfo *odi, OksData *d, bool skip_no
     }
   }
 
+  uid.class_id->p_kernel->k_update_reverse_refs(this, r, data[offset], false);
+  uid.class_id->p_kernel->k_update_reverse_refs(this, r, *d, true);
+
   data[offset] = *d;
 
   notify();
@@ -2203,6 +2752,8 @@ OksObject::SetRelationshipValue(const std::string& name, OksData *d, bool skip_n
 void
 OksObject::SetRelationshipValue(const OksDataInfo *odi, OksObject *object)
 {
+  materialize();
+
   const OksRelationship	*r = odi->relationship;
   OksData& d(data[odi->offset]);
 
@@ -2237,8 +2788,12 @@ OksObject::SetRelationshipValue(const OksDataInfo *odi, OksObject *object)
     }
   }
 
+  uid.class_id->p_kernel->k_update_reverse_refs(this, r, d, false);
+
   d.Set(object);
 
+  uid.class_id->p_kernel->k_update_reverse_refs(this, r, d, true);
+
   notify();
 }
 
@@ -2302,6 +2857,8 @@ cmp_data(OksData * d, OksData * d2)
 void
 OksObject::AddRelationshipValue(const OksDataInfo *odi, OksObject *object)
 {
+  materialize();
+
   const OksRelationship	* r = odi->relationship;
   size_t offset = odi->offset;
 
@@ -2328,6 +2885,8 @@ OksObject::AddRelationshipValue(const OksDataInfo *odi, OksObject *object)
 
   data[offset].data.LIST->push_back(new OksData(object));
 
+  uid.class_id->p_kernel->k_update_reverse_refs(this, r, *data[offset].data.LIST->back(), true);
+
   notify();
 }
 
@@ -2350,6 +2909,8 @@ OksObject::AddRelationshipValue(const std::string& name, OksObject *object)
 void
 OksObject::RemoveRelationshipValue(const OksDataInfo *odi, OksObject *object)
 {
+  materialize();
+
   const OksRelationship	* r = odi->relationship;
   
   if(!object) {
@@ -2371,6 +2932,7 @@ OksObject::RemoveRelationshipValue(const OksDataInfo *odi, OksObject *object)
     if(cmp_data(d2, &d)) {
       check_file_lock(0, r);
       object->remove_RCR(this, r);
+      uid.class_id->p_kernel->k_update_reverse_refs(this, r, *d2, false);
       list->erase(i);
       delete d2;
       notify();
@@ -2402,6 +2964,8 @@ OksObject::RemoveRelationshipValue(const std::string& name, OksObject * object)
 void
 OksObject::SetRelationshipValue(const std::string& name, const std::string& class_id, const std::string& object_id)
 {
+  materialize();
+
   OksDataInfo::Map::iterator i = uid.class_id->p_data_info->find(name);
   
   if(i == uid.class_id->p_data_info->end()) {
@@ -2422,6 +2986,7 @@ OksObject::SetRelationshipValue(const std::string& name, const std::string& clas
 
     if( (data[offset].type == OksData::object_type) && data[offset].data.OBJECT ) {
       data[offset].data.OBJECT->remove_RCR(this, r);
+      uid.class_id->p_kernel->k_update_reverse_refs(this, r, data[offset], false);
     }
 
     data[offset].Set((OksObject *)0);
@@ -2461,6 +3026,7 @@ OksObject::SetRelationshipValue(const std::string& name, const std::string& clas
 
     if( (data[offset].type == OksData::object_type) && data[offset].data.OBJECT ) {
       data[offset].data.OBJECT->remove_RCR(this, r);
+      uid.class_id->p_kernel->k_update_reverse_refs(this, r, data[offset], false);
     }
 
     data[offset].Set(class_id, object_id); 
@@ -2473,6 +3039,8 @@ OksObject::SetRelationshipValue(const std::string& name, const std::string& clas
 void
 OksObject::AddRelationshipValue(const std::string& name, const std::string& class_id, const std::string& object_id)
 {
+  materialize();
+
   OksDataInfo::Map::iterator i = uid.class_id->p_data_info->find(name);
   
   if(i == uid.class_id->p_data_info->end()) {
@@ -2527,6 +3095,8 @@ OksObject::AddRelationshipValue(const std::string& name, const std::string& clas
 void
 OksObject::RemoveRelationshipValue(const std::string& name, const std::string& class_id, const std::string& object_id)
 {
+  materialize();
+
   OksDataInfo::Map::iterator i = uid.class_id->p_data_info->find(name);
 
   if(i == uid.class_id->p_data_info->end()) {
@@ -2556,6 +3126,7 @@ OksObject::RemoveRelationshipValue(const std::string& name, const std::string& c
     OksData * d2 = *j;
     if(cmp_data(d2, &d)) {
       check_file_lock(0, r);
+      uid.class_id->p_kernel->k_update_reverse_refs(this, r, *d2, false);
       list->erase(j);
       delete d2;
       notify();
@@ -2577,6 +3148,8 @@ OksObject::add_RCR(OksObject *o, const OksRelationship *r)
 
   TLOG_DEBUG(4) << "object " << this << " adds RCR to object " << o << " throught relationship \"" << r->get_name() << '\"';
 
+  std::lock_guard lock(uid.class_id->p_kernel->p_objects_refs_mutex);  // object can be referenced by objects read in parallel
+
   if(!p_rcr) {
     p_rcr = new std::list<OksRCR *>();
   }
@@ -2682,6 +3255,7 @@ OksObject::bind(OksData *d, const BindInfo& info)
 
   try {
     d->Set(o);
+    info.k->k_update_reverse_refs(info.o, info.r, *d, true);
     o->add_RCR(info.o, info.r);
   }
   catch(oks::exception& ex) {
@@ -2730,6 +3304,8 @@ BindWarning::add(const OksRelationship * r)
 void
 OksObject::bind_objects()
 {
+  if(!is_read()) return;  // will be bound on first access
+
   const OksClass * c = uid.class_id;
 
   if(c->p_all_relationships->empty()) return;  // if class has no relationships then nothing to do
@@ -2824,6 +3400,8 @@ OksObject::bind_objects()
 void
 OksObject::unbind_file(const OksFile * f)
 {
+  if(!is_read()) return;  // has no references on objects yet
+
   const size_t num_of_attrs (uid.class_id->number_of_all_attributes());
   const size_t num_of_rels  (uid.class_id->number_of_all_relationships());
 
@@ -2880,6 +3458,10 @@ OksObject::create_notify()
 {
   OksKernel * k = uid.class_id->p_kernel;
 
+  if(k->p_journal) {
+    k->journal_update(this);
+  }
+
   if(k->p_create_object_notify_fn) {
     (*k->p_create_object_notify_fn)(this, k->p_create_object_notify_param);
   }
@@ -2893,6 +3475,11 @@ void
 OksObject::change_notify()
 {
   OksKernel * k = uid.class_id->p_kernel;
+
+  if(k->p_journal) {
+    k->journal_update(this);
+  }
+
   if(k->p_change_object_notify_fn) {
     (*k->p_change_object_notify_fn)(this, k->p_change_object_notify_param);
   }
@@ -2907,6 +3494,10 @@ OksObject::delete_notify()
 {
   OksKernel * k = uid.class_id->p_kernel;
 
+  if(k->p_journal && k->p_close_all == false) {
+    k->journal_remove(this);
+  }
+
   if(k->p_delete_object_notify_fn) {
     (*k->p_delete_object_notify_fn)(this, k->p_delete_object_notify_param);
   }
@@ -2965,7 +3556,7 @@ OksObject::report_dangling_references() const
 
   while(l1 < l2) {
     OksDataInfo odi(l1, *ri);
-    OksData * d(GetRelationshipValue(&odi));
+    OksData * d(get_relationship_value(&odi));
 
     if(d->type == OksData::list_type) {
       for(OksData::List::const_iterator li = d->data.LIST->begin(); li != d->data.LIST->end(); ++li) {
@@ -2996,7 +3587,7 @@ OksObject::is_consistent(const std::set<OksFile *>& includes, const char * msg)
 
   while(l1 < l2) {
     OksDataInfo odi(l1, *ri);
-    OksData * d(GetRelationshipValue(&odi));
+    OksData * d(get_relationship_value(&odi));
 
     if(d->type == OksData::object_type) {
       if(OksObject * o2 = d->data.OBJECT) {
@@ -3049,6 +3640,12 @@ struct RefData {
   RefData(OksObject::FSet& r, oks::ClassSet * cs) : refs(r), classes(cs) {
     if(classes && classes->empty()) classes = nullptr;
   }
+
+    // references are only read, so the reverse references index is kept
+
+  static OksData * get_value(const OksObject * o, const OksDataInfo * i) noexcept {
+    return o->get_relationship_value(i);
+  }
 };
 
 
@@ -3085,7 +3682,7 @@ _references(const OksObject * obj, unsigned long recursion_depth, RefData& data)
 
   while(l1 < l2) {
     OksDataInfo odi(l1, (OksRelationship *)0);
-    OksData * d(obj->GetRelationshipValue(&odi));
+    OksData * d(RefData::get_value(obj, &odi));
 
     if(d->type == OksData::object_type) {
       if(OksObject * o2 = d->data.OBJECT) {
@@ -3129,61 +3726,24 @@ OksObject::FList *
 OksObject::get_all_rels(const std::string& name) const
 {
   bool any_name = (name == "*");
-  
+
   OksObject::FList * result = nullptr;
-  
-  const OksClass::Map& all_classes(GetClass()->get_kernel()->classes());
-
-  for(OksClass::Map::const_iterator i = all_classes.begin(); i != all_classes.end(); ++i) {
-    OksClass * c(i->second);
-    if(any_name || c->find_relationship(name) != nullptr) {
-      if(const OksObject::Map * objs = i->second->objects()) {
-        for(OksObject::Map::const_iterator j = objs->begin(); j != objs->end(); ++j) {
-          OksObject *o(j->second);
-	  unsigned short l1, l2;
-	  
-	  if(any_name) {
-            l1 = c->number_of_all_attributes();
-            l2 = l1 + c->number_of_all_relationships();
-	  }
-	  else {
-	    l1 = c->data_info(name)->offset;
-	    l2 = l1+1;
-	  }
 
-          while(l1 < l2) {
-            OksDataInfo odi(l1, (OksRelationship *)0);
-            OksData * d(o->GetRelationshipValue(&odi));
+  OksKernel * k(GetClass()->get_kernel());
 
-            if(d->type == OksData::object_type) {
-              if(this == d->data.OBJECT) {
-                if(!result) result = new OksObject::FList();
-		result->push_back(o);
-		break;
-              }
-            }
-            else if(d->type == OksData::list_type) {
-	      bool found = false;
-              for(OksData::List::const_iterator li = d->data.LIST->begin(); li != d->data.LIST->end(); ++li) {
-                OksData * lid(*li);
-                if(lid->type == OksData::object_type) {
-                  if(this == lid->data.OBJECT) {
-                    if(!result) result = new OksObject::FList();
-		    result->push_back(o);
-		    found = true;
-		    break; // exit given relationship value iterator
-                  }
-                }
-              }
-              if(found) break; //exit relationships iterator for given object
-            }
-            ++l1;
-          }
-        }
+  std::lock_guard lock(k->p_reverse_refs_mutex);
+
+  if(const auto * refs = k->k_get_reverse_refs(this)) {
+    OksObject::FSet added;
+
+    for(const auto& i : *refs) {
+      if((any_name || i.second->get_name() == name) && added.insert(i.first).second) {
+        if(!result) result = new OksObject::FList();
+        result->push_back(i.first);
       }
     }
   }
-  
+
   return result;
 }
 
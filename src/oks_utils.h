@@ -1,14 +1,25 @@
 #ifndef OKS_KERNEL_UTILS_H
 #define OKS_KERNEL_UTILS_H
 
+#include <atomic>
+#include <charconv>
+#include <limits>
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <stdint.h>
+#include <string.h>
 
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/date_time/gregorian/gregorian_types.hpp>
 
 #include "oks/config/map.hpp"
 #include "oks/exceptions.hpp"
+#include "oks/file.hpp"
 
 class OksClass;
 class OksObject;
@@ -16,9 +27,97 @@ class OksXmlInputStream;
 class OksFile;
 struct OksAliasTable;
 class OksKernel;
+struct OksDataInfo;
 
 namespace oks {
 
+  class MappedFile;
+
+    // detect gzip or zstd compression of file by its magic bytes
+
+  OksFile::Compression get_compression(const std::string& file_name);
+
+
+    // read compressed file via decompressing stream into memory; throw std::runtime_error if failed
+
+  std::shared_ptr<MappedFile> decompress_file(const std::string& file_name, OksFile::Compression c);
+
+
+    // locale-free conversion of numeric value [s, e) using std::from_chars();
+    // accepts the same input as strtol(s, 0, 0) and strtod(s) do: leading spaces, sign, hexadecimal and octal prefixes;
+    // the integer values are converted via 64-bit types and then narrowed as it was done by static_cast<T>(strtol())
+
+  template<class T>
+  inline std::from_chars_result
+  str2num(const char * s, const char * e, T& value) noexcept
+  {
+    while (s != e && (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'))
+      ++s;
+
+    bool negative(false);
+
+    if (s != e && (*s == '-' || *s == '+'))
+      {
+        negative = (*s++ == '-');
+
+        if (s != e && (*s == '-' || *s == '+'))
+          return {s, std::errc::invalid_argument};
+      }
+
+    const bool hex(e - s > 1 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X'));
+
+    if constexpr (std::is_floating_point_v<T>)
+      {
+        std::from_chars_result r = (hex ? std::from_chars(s + 2, e, value, std::chars_format::hex) : std::from_chars(s, e, value));
+
+        if (negative && r.ec == std::errc())
+          value = -value;
+
+        return r;
+      }
+    else
+      {
+        uint64_t v;
+        std::from_chars_result r = std::from_chars(hex ? s + 2 : s, e, v, hex ? 16 : (e - s > 1 && *s == '0') ? 8 : 10);
+
+        if (r.ec != std::errc())
+          return r;
+
+        if constexpr (std::is_signed_v<T>)
+          {
+            if (v > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + negative)
+              return {r.ptr, std::errc::result_out_of_range};
+          }
+
+        value = static_cast<T>(negative ? (~v + 1) : v);
+
+        return r;
+      }
+  }
+
+
+    // throw oks::BadFileData for numeric value which cannot be converted by str2num()
+
+  [[noreturn]] void throw_bad_num(const char * value, const std::from_chars_result& r, unsigned long line_no, unsigned long line_pos);
+
+
+    // read numeric value of OKS file; throw oks::BadFileData in case of bad value
+
+  template<class T>
+  inline T
+  read_num(const char * value, size_t len, unsigned long line_no, unsigned long line_pos)
+  {
+    T v{};
+    const char * e(value + len);
+    std::from_chars_result r(str2num(value, e, v));
+
+    if (__builtin_expect((r.ec != std::errc() || r.ptr != e), 0))
+      throw_bad_num(value, r, line_no, line_pos);
+
+    return v;
+  }
+
+
     // read date and time strings from OKS files (oks::Date, oks::Time or Boost ISO strings)
 
   boost::posix_time::ptime str2time(const char * value, size_t len, const char * file_name = nullptr);
@@ -50,14 +149,169 @@ namespace oks {
     size_t object_tag_len;
     OksObject * owner;
     std::string tmp;
+    bool lazy_objects;
+    bool shared_strings;
 
-    ReadFileParams(OksFile* f_, OksXmlInputStream& s_, OksAliasTable * t_, OksKernel * k_, char m_, ReloadObjects * l_) :
-      f(f_), s(s_), alias_table(t_), oks_kernel(k_), format(m_), reload_objects(l_) { init(); }
+    ReadFileParams(OksFile* f_, OksXmlInputStream& s_, OksAliasTable * t_, OksKernel * k_, char m_, ReloadObjects * l_, bool z_ = false) :
+      f(f_), s(s_), alias_table(t_), oks_kernel(k_), format(m_), reload_objects(l_), lazy_objects(z_) { init(); }
 
     void init();
   };
 
 
+    // the position of not yet parsed object body in mapped data file (lazy objects mode);
+    // the state is changed from unread to read and then to bound, when the relationships are bound
+
+  struct LazyBody {
+    enum State { unread, read, bound };
+
+    std::shared_ptr<MappedFile> m_file;
+    size_t m_begin;
+    size_t m_end;
+    unsigned long m_line_no;
+    unsigned long m_line_pos;
+    char m_format;
+    std::atomic<uint8_t> m_state;
+
+    LazyBody(const std::shared_ptr<MappedFile>& file, size_t begin, size_t end, unsigned long line_no, unsigned long line_pos, char format) :
+      m_file(file), m_begin(begin), m_end(end), m_line_no(line_no), m_line_pos(line_pos), m_format(format), m_state(unread) { ; }
+  };
+
+
+    // the binary snapshot format of data files:
+    //  - header (magic, version, byte order mark and source key)
+    //  - table of strings (all names, identities and string values)
+    //  - table of classes (names and types of stored attributes and relationships)
+    //  - file info (format and as the xml info, include and comments sections)
+    //  - objects (class index, id and type-tagged values of attributes and relationships)
+    //
+    // the schema image stored in parse cache uses the same header and file info followed by
+    //  - names and cache keys of files defining superclasses
+    //  - definitions of classes
+    //  - registration of classes (all superclasses, attributes, relationships and methods)
+
+  struct BinaryFormat {
+    static const char magic[8];
+    static const uint32_t version;
+    static const uint32_t byte_order_mark;
+
+      // check magic of file mapped into memory or on disk
+
+    static bool test(const char * data, size_t len) noexcept { return (len >= sizeof(magic) && !memcmp(data, magic, sizeof(magic))); }
+    static bool test(const std::string& file_name) noexcept;
+
+      // fast non-cryptographic 64-bit hash of file content or name
+
+    static uint64_t hash(const char * data, size_t len) noexcept;
+  };
+
+
+    // write binary snapshot; the tables are built while data are put and written by flush()
+
+  class BinaryOutputStream {
+
+    public:
+
+        // the source key is stored in the header; it is empty for snapshots and used to validate cache images
+
+      BinaryOutputStream(const std::string& source = "") : m_source(source) { ; }
+
+      template<class T> typename std::enable_if<std::is_arithmetic<T>::value>::type put(T v) { m_data.append(reinterpret_cast<const char *>(&v), sizeof(T)); }
+      void put(const std::string& s) { put(string_index(s)); }
+      void put(const OksClass * c);
+
+      void flush(std::ostream& s);
+
+    private:
+
+      uint32_t string_index(const std::string& s);
+
+      std::unordered_map<std::string, uint32_t> m_strings_idx;
+      std::vector<const std::string *> m_strings;
+      std::unordered_map<const OksClass *, uint32_t> m_classes_idx;
+      std::vector<const OksClass *> m_classes;
+      std::string m_source;
+      std::string m_data;
+  };
+
+
+    // attribute or relationship stored in binary snapshot
+
+  struct BinaryItemInfo {
+    const std::string * name;
+    uint8_t type;               // stored type of attribute or high cardinality of relationship
+    bool multi;                 // stored multi-value property
+    const OksDataInfo * info;   // schema data info; null, if it is not defined by the schema
+    bool convert;               // the stored type does not match the schema
+  };
+
+
+    // class stored in binary snapshot
+
+  struct BinaryClassInfo {
+    const std::string * name;
+    OksClass * oks_class;                     // null, if the class is not defined by the schema
+    std::vector<BinaryItemInfo> attributes;
+    std::vector<BinaryItemInfo> relationships;
+    bool same_layout;                         // the stored values can be read in place without conversion
+  };
+
+
+    // read binary snapshot mapped into memory
+
+  class BinaryInputStream {
+
+    public:
+
+      BinaryInputStream(std::shared_ptr<MappedFile> file);
+
+      template<class T> T get() {
+        if( __builtin_expect((static_cast<size_t>(m_end - m_ptr) < sizeof(T)), 0) ) throw_bad_data("unexpected end of file");
+        T v; memcpy(&v, m_ptr, sizeof(T)); m_ptr += sizeof(T);
+        return v;
+      }
+
+      const std::string& get_string() {
+        uint32_t idx = get<uint32_t>();
+        if( __builtin_expect((idx >= m_strings.size()), 0) ) throw_bad_data("bad string index");
+        return m_strings[idx];
+      }
+
+      BinaryClassInfo& get_class() {
+        uint32_t idx = get<uint32_t>();
+        if( __builtin_expect((idx >= m_classes.size()), 0) ) throw_bad_data("bad class index");
+        return m_classes[idx];
+      }
+
+      bool at_end() const { return (m_ptr == m_end); }
+
+      size_t get_position() const;
+      size_t size() const;
+
+      const std::string& get_source() const { return m_source; }
+
+        // read string values using oks::SharedStrings pool (is set by resolve() from kernel's mode)
+
+      bool shared_strings() const { return m_shared_strings; }
+
+        // resolve stored classes, attributes and relationships against schema
+
+      void resolve(OksKernel * kernel);
+
+      [[noreturn]] void throw_bad_data(const char * reason) const;
+
+    private:
+
+      std::shared_ptr<MappedFile> m_file;
+      const char * m_ptr;
+      const char * m_end;
+      std::string m_source;
+      std::vector<std::string> m_strings;
+      std::vector<BinaryClassInfo> m_classes;
+      bool m_shared_strings;
+  };
+
+
   // 17-SEP-2009: for compatibility with previous OKS versions
   // FIXME: remove later ...
 
@@ -26,6 +26,7 @@ const char * OksQuery::LE = "<=";
 const char * OksQuery::GE = ">=";
 const char * OksQuery::LS = "<";
 const char * OksQuery::GT = ">";
+const char * OksQuery::CT = "contains";
 const char * OksQuery::PATH_TO = "path-to";
 const char * OksQuery::DIRECT = "direct";
 const char * OksQuery::NESTED = "nested";
@@ -58,6 +59,22 @@ bool OksQuery::reg_exp_cmp(const OksData *d, const OksData * re) {
   return boost::regex_match(d->str(), *reinterpret_cast<const boost::regex *>(re));
 }
 
+  // for multi-value attribute test if an item is equal to given value, otherwise compare values
+
+bool OksQuery::contains_cmp(const OksData *d, const OksData * item) {
+  if(d->type == OksData::list_type) {
+    if(d->data.LIST) {
+      for(const auto& x : *d->data.LIST) {
+        if(*x == *item) return true;
+      }
+    }
+
+    return false;
+  }
+
+  return (*d == *item);
+}
+
 
 void OksComparator::SetValue(OksData *v)
 {
@@ -396,6 +413,7 @@ OksQuery::create_expression(const OksClass *c, const std::string & str)
         (third == OksQuery::GE) ? OksQuery::greater_or_equal_cmp :
         (third == OksQuery::LS) ? OksQuery::less_cmp :
         (third == OksQuery::GT) ? OksQuery::greater_cmp :
+        (third == OksQuery::CT) ? OksQuery::contains_cmp :
         0
       );
 
@@ -404,6 +422,9 @@ OksQuery::create_expression(const OksClass *c, const std::string & str)
 	  d->type = OksData::string_type;
 	  d->data.STRING = new OksString(second);
         }
+        else if(f == OksQuery::contains_cmp && a->get_is_multi_values()) {
+          d->ReadFrom(second.c_str(), a->get_data_type(), a);
+        }
         else {
           d->type = OksData::unknown_type;
           d->SetValues(second.c_str(), a);
@@ -427,6 +448,171 @@ OksQuery::create_expression(const OksClass *c, const std::string & str)
 
 
 
+  //
+  // Find objects using hash index of attribute used by equality comparator.
+  // If subclasses_only is true, use index built with subclasses only.
+  // Return the index or null, if there is no such index.
+  //
+
+static const OksHashIndex *
+find_by_hash_index(const OksHashIndex::Map * indices, OksQueryExpression *qe, bool subclasses_only, OksObject::List *& olist)
+{
+  if(indices && qe->type() == OksQuery::comparator_type) {
+    OksComparator *cq = (OksComparator *)qe;
+
+    if(cq->GetAttribute() && cq->GetFunction() == OksQuery::equal_cmp) {
+      OksHashIndex::Map::const_iterator j = indices->find(cq->GetAttribute());
+
+      if(j != indices->end() && (subclasses_only == false || (*j).second->spans_subclasses())) {
+        olist = (*j).second->FindEqual(cq->GetValue());
+        return (*j).second;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+
+  //
+  // Find objects using composite index, which attributes prefix is covered by equality comparators
+  // of the expression (optionally followed by range comparators for the next attribute).
+  // If subclasses_only is true, use indices built with subclasses only.
+  // Return the index or null, if there is no such index. The check_found is set to true, if the expression
+  // has comparators not used by the index and the found objects have to be tested.
+  //
+
+static const OksCompositeIndex *
+find_by_composite_index(const OksCompositeIndex::List * indices, OksQueryExpression *qe, bool subclasses_only, OksObject::List *& olist, bool& check_found)
+{
+  if(!indices) return nullptr;
+
+  std::vector<OksComparator *> cmps;
+  size_t num_of_expressions = 1;
+
+  if(qe->type() == OksQuery::comparator_type) {
+    cmps.push_back((OksComparator *)qe);
+  }
+  else if(qe->type() == OksQuery::and_type) {
+    const std::list<OksQueryExpression *>& elist(((OksAndExpression *)qe)->expressions());
+    num_of_expressions = elist.size();
+
+    for(const auto& x : elist) {
+      if(x->type() == OksQuery::comparator_type && ((OksComparator *)x)->GetAttribute()) {
+        cmps.push_back((OksComparator *)x);
+      }
+    }
+  }
+  else {
+    return nullptr;
+  }
+
+  auto find_cmp = [&cmps](const OksAttribute * a, OksQuery::Comparator f1, OksQuery::Comparator f2) -> OksComparator * {
+    for(const auto& x : cmps) {
+      if((x->GetFunction() == f1 || x->GetFunction() == f2) && x->GetAttribute() && x->GetAttribute()->get_name() == a->get_name()) {
+        return x;
+      }
+    }
+    return nullptr;
+  };
+
+  const OksCompositeIndex * index = nullptr;
+  std::vector<const OksData *> eq;
+  OksComparator * low = nullptr;
+  OksComparator * high = nullptr;
+  size_t score = 0;
+
+  for(const auto& i : *indices) {
+    if(subclasses_only && !i->spans_subclasses()) continue;
+
+    std::vector<const OksData *> i_eq;
+    OksComparator * i_low = nullptr;
+    OksComparator * i_high = nullptr;
+
+    for(const auto& a : i->attributes()) {
+      if(OksComparator * x = find_cmp(a, OksQuery::equal_cmp, OksQuery::equal_cmp)) {
+        i_eq.push_back(x->GetValue());
+      }
+      else {
+        i_low = find_cmp(a, OksQuery::greater_cmp, OksQuery::greater_or_equal_cmp);
+        i_high = find_cmp(a, OksQuery::less_cmp, OksQuery::less_or_equal_cmp);
+        break;
+      }
+    }
+
+    size_t i_score = i_eq.size() * 2 + ((i_low || i_high) ? 1 : 0);
+
+    if(i_score > score) {
+      index = i;
+      eq.swap(i_eq);
+      low = i_low;
+      high = i_high;
+      score = i_score;
+    }
+  }
+
+  if(!index) return nullptr;
+
+  olist = index->find_all(
+    eq,
+    (low ? low->GetValue() : nullptr), (low ? low->GetFunction() == OksQuery::greater_or_equal_cmp : true),
+    (high ? high->GetValue() : nullptr), (high ? high->GetFunction() == OksQuery::less_or_equal_cmp : true)
+  );
+
+  check_found = (eq.size() + (low ? 1 : 0) + (high ? 1 : 0) != num_of_expressions);
+
+  return index;
+}
+
+
+  //
+  // Find objects using inverted index of attribute used by contains comparator, which can be
+  // the expression itself or one of the comparators of \b and expression.
+  // If subclasses_only is true, use index built with subclasses only.
+  // Return the index or null, if there is no such index. The check_found is set to true, if the expression
+  // has comparators not used by the index and the found objects have to be tested.
+  //
+
+static const OksInvertedIndex *
+find_by_inverted_index(const OksInvertedIndex::Map * indices, OksQueryExpression *qe, bool subclasses_only, OksObject::List *& olist, bool& check_found)
+{
+  if(!indices) return nullptr;
+
+  auto find = [&](OksQueryExpression * x) -> const OksInvertedIndex * {
+    if(x->type() == OksQuery::comparator_type) {
+      OksComparator *cq = (OksComparator *)x;
+
+      if(cq->GetAttribute() && cq->GetFunction() == OksQuery::contains_cmp) {
+        OksInvertedIndex::Map::const_iterator j = indices->find(cq->GetAttribute());
+
+        if(j != indices->end() && (subclasses_only == false || (*j).second->spans_subclasses())) {
+          olist = (*j).second->FindContaining(cq->GetValue());
+          return (*j).second;
+        }
+      }
+    }
+
+    return nullptr;
+  };
+
+  if(qe->type() == OksQuery::comparator_type) {
+    return find(qe);
+  }
+  else if(qe->type() == OksQuery::and_type) {
+    const std::list<OksQueryExpression *>& elist(((OksAndExpression *)qe)->expressions());
+
+    for(const auto& x : elist) {
+      if(const OksInvertedIndex * i = find(x)) {
+        check_found = (elist.size() != 1);
+        return i;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+
 OksObject::List *
 OksClass::execute_query(OksQuery *qe) const
 {
@@ -443,15 +629,39 @@ OksClass::execute_query(OksQuery *qe) const
     return 0;
   }
 
-  if(p_objects && !p_objects->empty()) {
-    bool indexedSearch = false;
+  const bool subclasses = (qe->search_in_subclasses() == true && p_all_sub_classes && !p_all_sub_classes->empty());
+
+  bool indexedSearch = false;    // objects were found by index
+  bool spansSubclasses = false;  // the index contains objects of subclasses
+  bool check_found = false;      // objects found by index have to be tested by query expression
+
+
+    // search in subclasses can be done by index built with subclasses
+
+  if(subclasses) {
+    if(find_by_hash_index(p_hash_indices, sqe, true, olist)) {
+      indexedSearch = spansSubclasses = true;
+    }
+    else if(find_by_composite_index(p_composite_indices, sqe, true, olist, check_found)) {
+      indexedSearch = spansSubclasses = true;
+    }
+    else if(find_by_inverted_index(p_inverted_indices, sqe, true, olist, check_found)) {
+      indexedSearch = spansSubclasses = true;
+    }
+  }
+
+  if(indexedSearch == false && p_objects && !p_objects->empty()) {
+    if(const OksHashIndex * i = find_by_hash_index(p_hash_indices, sqe, false, olist)) {
+      indexedSearch = true;
+      spansSubclasses = i->spans_subclasses();
+    }
   	
-    if(p_indices) {
+    if(p_indices && indexedSearch == false) {
       if(sqe->type() == OksQuery::comparator_type) {
         OksComparator *cq = (OksComparator *)sqe;
 	OksIndex::Map::iterator j = p_indices->find(cq->GetAttribute());
 	
-        if(j != p_indices->end()) {
+        if(j != p_indices->end() && cq->GetFunction() != OksQuery::contains_cmp) {
           indexedSearch = true;
           olist = (*j).second->find_all(cq->GetValue(), cq->GetFunction());
         }
@@ -460,7 +670,11 @@ OksClass::execute_query(OksQuery *qe) const
        (sqe->type() == OksQuery::and_type) ||
        (sqe->type() == OksQuery::or_type)
       ) {
-        std::list<OksQueryExpression *> * qlist = &((OksListBaseQueryExpression *)sqe)->p_expressions;
+        std::list<OksQueryExpression *> * qlist = (
+          (sqe->type() == OksQuery::and_type)
+            ? &((OksAndExpression *)sqe)->p_expressions
+            : &((OksOrExpression *)sqe)->p_expressions
+        );
         OksQueryExpression *q1, *q2;
         OksComparator *cq1 = 0, *cq2 = 0;
 			
@@ -470,7 +684,9 @@ OksClass::execute_query(OksQuery *qe) const
          ((q2 = qlist->back())->type() == OksQuery::comparator_type) &&
          ((cq1 = (OksComparator *)q1) != 0) &&
          ((cq2 = (OksComparator *)q2) != 0) &&
-         (cq1->GetAttribute() == cq2->GetAttribute())
+         (cq1->GetAttribute() == cq2->GetAttribute()) &&
+         (cq1->GetFunction() != OksQuery::contains_cmp) &&
+         (cq2->GetFunction() != OksQuery::contains_cmp)
         ) {
 	  OksIndex::Map::iterator j = p_indices->find(cq1->GetAttribute());
 				
@@ -489,6 +705,20 @@ OksClass::execute_query(OksQuery *qe) const
       }
     }
 	
+    if(indexedSearch == false) {
+      if(const OksCompositeIndex * i = find_by_composite_index(p_composite_indices, sqe, false, olist, check_found)) {
+        indexedSearch = true;
+        spansSubclasses = i->spans_subclasses();
+      }
+    }
+
+    if(indexedSearch == false) {
+      if(const OksInvertedIndex * i = find_by_inverted_index(p_inverted_indices, sqe, false, olist, check_found)) {
+        indexedSearch = true;
+        spansSubclasses = i->spans_subclasses();
+      }
+    }
+
     if(indexedSearch == false) {
       for(OksObject::Map::iterator i = p_objects->begin(); i != p_objects->end(); ++i) {
         OksObject *o = (*i).second;
@@ -510,7 +740,35 @@ OksClass::execute_query(OksQuery *qe) const
   }
 
 
-  if(qe->search_in_subclasses() == true && p_all_sub_classes && !p_all_sub_classes->empty()) {
+    // remove objects of subclasses, if the search is not done in subclasses,
+    // and test objects on expressions not used by index
+
+  const bool skip_subclasses = (spansSubclasses && !subclasses);
+
+  if(olist && (check_found || skip_subclasses)) {
+    for(OksObject::List::iterator i = olist->begin(); i != olist->end();) {
+      try {
+        if((skip_subclasses == false || (*i)->GetClass() == this) && (check_found == false || (*i)->SatisfiesQueryExpression(sqe) == true)) ++i;
+        else i = olist->erase(i);
+      }
+      catch(oks::exception& ex) {
+        delete olist;
+        throw oks::QueryFailed(*sqe, *this, ex);
+      }
+      catch(std::exception& ex) {
+        delete olist;
+        throw oks::QueryFailed(*sqe, *this, ex.what());
+      }
+    }
+
+    if(olist->empty()) {
+      delete olist;
+      olist = 0;
+    }
+  }
+
+
+  if(subclasses && spansSubclasses == false) {
     for(OksClass::FList::iterator i = p_all_sub_classes->begin(); i != p_all_sub_classes->end(); ++i) {
       OksClass *c = *i;
 
@@ -635,6 +893,8 @@ OksObject::SatisfiesQueryExpression(OksQueryExpression *qe) const
     throw std::runtime_error("cannot execute nil query");
   }
 
+  materialize();
+
   switch(qe->type()) {
     case OksQuery::comparator_type: {
       OksComparator *cmp = (OksComparator *)qe;
@@ -812,6 +1072,7 @@ operator<<(std::ostream& s, const OksQueryExpression& qe)
         else if(f == OksQuery::greater_or_equal_cmp) s << OksQuery::GE;
         else if(f == OksQuery::less_cmp) s << OksQuery::LS;
         else if(f == OksQuery::greater_cmp) s << OksQuery::GT;
+        else if(f == OksQuery::contains_cmp) s << OksQuery::CT;
       }
       else
         s << "(null)";
@@ -968,7 +1229,7 @@ OksObject::satisfies(const OksObject * goal, const oks::QueryPathExpression& exp
       OksDataInfo::Map::iterator i = uid.class_id->p_data_info->find(nm);
 
       if(i != uid.class_id->p_data_info->end()) {
-        d = GetRelationshipValue((*i).second);
+        d = get_relationship_value((*i).second);
       }
       else {
         continue;
@@ -976,7 +1237,7 @@ OksObject::satisfies(const OksObject * goal, const oks::QueryPathExpression& exp
     }
     else {
       try {
-        d = GetRelationshipValue(*i);
+        d = get_relationship_value(*i);
       }
       catch(oks::exception& ex) {
         Oks::error_msg("OksObject::satisfies") << ex.what() << std::endl;
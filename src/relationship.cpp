@@ -8,6 +8,8 @@
 
 #include <sstream>
 
+#include "oks_utils.h"
+
 
 const char OksRelationship::relationship_xml_tag[]  = "relationship";
 const char OksRelationship::name_xml_attr[]         = "name";
@@ -195,6 +197,36 @@ OksRelationship::OksRelationship(OksXmlInputStream& s, OksClass *parent) :
 }
 
 
+OksRelationship::OksRelationship(oks::BinaryInputStream& s, OksClass *parent) :
+  p_name           (s.get_string()),
+  p_rclass         (s.get_string()),
+  p_low_cc         (static_cast<CardinalityConstraint>(s.get<uint8_t>())),
+  p_high_cc        (static_cast<CardinalityConstraint>(s.get<uint8_t>())),
+  p_composite      (s.get<uint8_t>()),
+  p_exclusive      (s.get<uint8_t>()),
+  p_dependent      (s.get<uint8_t>()),
+  p_description    (s.get_string()),
+  p_class          (parent),
+  p_class_type     (nullptr),
+  p_ordered        (s.get<uint8_t>())
+{
+}
+
+void
+OksRelationship::put(oks::BinaryOutputStream& s) const
+{
+  s.put(p_name);
+  s.put(p_rclass);
+  s.put(static_cast<uint8_t>(p_low_cc));
+  s.put(static_cast<uint8_t>(p_high_cc));
+  s.put(static_cast<uint8_t>(p_composite));
+  s.put(static_cast<uint8_t>(p_exclusive));
+  s.put(static_cast<uint8_t>(p_dependent));
+  s.put(p_description);
+  s.put(static_cast<uint8_t>(p_ordered));
+}
+
+
 void
 OksRelationship::set_name(const std::string& new_name)
 {
@@ -5,13 +5,22 @@
 #include "oks/object.hpp"
 #include "oks/cstring.hpp"
 
+#include "oks_utils.h"
+
 #include <iostream>
+#include <limits>
 #include <sstream>
 
-#include <boost/spirit/include/karma.hpp>
-
 #include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #include "ers/ers.hpp"
 #include "logging/Logging.hpp"
@@ -31,6 +40,142 @@ namespace oks {
     const char single_quote[]           = "&apos;";
     const char double_quote[]           = "&quot;";
 
+
+      // scalar implementation of the scanners
+
+    static const char *
+    find_first_of_scalar(const char * p, const char * end, const char * set, size_t n)
+    {
+      for (; p != end; ++p)
+        for (size_t i = 0; i < n; ++i)
+          if (*p == set[i])
+            return p;
+
+      return end;
+    }
+
+    static const char *
+    find_first_not_of_scalar(const char * p, const char * end, const char * set, size_t n)
+    {
+      for (; p != end; ++p)
+        {
+          size_t i = 0;
+
+          while (i < n && *p != set[i])
+            ++i;
+
+          if (i == n)
+            return p;
+        }
+
+      return end;
+    }
+
+
+#if defined(__x86_64__)
+
+      // the vectorized implementations compare 16 (SSE2) or 32 (AVX2) symbols per step;
+      // the tail shorter than vector is processed by scalar implementation to never read beyond end
+
+    static inline __m128i
+    match_sse2(__m128i x, const __m128i * v, size_t n)
+    {
+      __m128i m = _mm_cmpeq_epi8(x, v[0]);
+
+      for (size_t i = 1; i < n; ++i)
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(x, v[i]));
+
+      return m;
+    }
+
+    static const char *
+    find_first_of_sse2(const char * p, const char * end, const char * set, size_t n)
+    {
+      __m128i v[8];
+
+      for (size_t i = 0; i < n; ++i)
+        v[i] = _mm_set1_epi8(set[i]);
+
+      for (; end - p >= 16; p += 16)
+        if (unsigned int bits = _mm_movemask_epi8(match_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), v, n)))
+          return p + __builtin_ctz(bits);
+
+      return find_first_of_scalar(p, end, set, n);
+    }
+
+    static const char *
+    find_first_not_of_sse2(const char * p, const char * end, const char * set, size_t n)
+    {
+      __m128i v[8];
+
+      for (size_t i = 0; i < n; ++i)
+        v[i] = _mm_set1_epi8(set[i]);
+
+      for (; end - p >= 16; p += 16)
+        if (unsigned int bits = (~_mm_movemask_epi8(match_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), v, n)) & 0xFFFF))
+          return p + __builtin_ctz(bits);
+
+      return find_first_not_of_scalar(p, end, set, n);
+    }
+
+    __attribute__((target("avx2"))) static inline __m256i
+    match_avx2(__m256i x, const __m256i * v, size_t n)
+    {
+      __m256i m = _mm256_cmpeq_epi8(x, v[0]);
+
+      for (size_t i = 1; i < n; ++i)
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, v[i]));
+
+      return m;
+    }
+
+    __attribute__((target("avx2"))) static const char *
+    find_first_of_avx2(const char * p, const char * end, const char * set, size_t n)
+    {
+      __m256i v[8];
+
+      for (size_t i = 0; i < n; ++i)
+        v[i] = _mm256_set1_epi8(set[i]);
+
+      for (; end - p >= 32; p += 32)
+        if (unsigned int bits = _mm256_movemask_epi8(match_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), v, n)))
+          return p + __builtin_ctz(bits);
+
+      return find_first_of_sse2(p, end, set, n);
+    }
+
+    __attribute__((target("avx2"))) static const char *
+    find_first_not_of_avx2(const char * p, const char * end, const char * set, size_t n)
+    {
+      __m256i v[8];
+
+      for (size_t i = 0; i < n; ++i)
+        v[i] = _mm256_set1_epi8(set[i]);
+
+      for (; end - p >= 32; p += 32)
+        if (unsigned int bits = ~static_cast<unsigned int>(_mm256_movemask_epi8(match_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), v, n))))
+          return p + __builtin_ctz(bits);
+
+      return find_first_not_of_sse2(p, end, set, n);
+    }
+
+    static bool
+    has_avx2()
+    {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+    }
+
+    const char * (* const find_first_of)(const char *, const char *, const char *, size_t) = (has_avx2() ? find_first_of_avx2 : find_first_of_sse2);
+    const char * (* const find_first_not_of)(const char *, const char *, const char *, size_t) = (has_avx2() ? find_first_not_of_avx2 : find_first_not_of_sse2);
+
+#else
+
+    const char * (* const find_first_of)(const char *, const char *, const char *, size_t) = find_first_of_scalar;
+    const char * (* const find_first_not_of)(const char *, const char *, const char *, size_t) = find_first_not_of_scalar;
+
+#endif
+
   }
   
   exception::exception(const std::string& what_arg, int level_arg) noexcept : p_level (level_arg)
@@ -73,6 +218,106 @@ namespace oks {
     return (std::string("Read end-of-stream tag \'") + tag + '\'');
   }
 
+  MappedFile::MappedFile(const std::string& file_name) : m_data(nullptr), m_size(0)
+  {
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+
+    if (fd < 0)
+      throw std::runtime_error(std::string("cannot open file: ") + oks::strerror(errno));
+
+    struct stat buf;
+
+    if (fstat(fd, &buf) != 0)
+      {
+        const int error(errno);
+        ::close(fd);
+        throw std::runtime_error(std::string("cannot get size of file: ") + oks::strerror(error));
+      }
+
+    m_size = buf.st_size;
+
+    if (m_size > 0)
+      {
+        void * ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (ptr == MAP_FAILED)
+          {
+            const int error(errno);
+            ::close(fd);
+            throw std::runtime_error(std::string("cannot map file into memory: ") + oks::strerror(error));
+          }
+
+        madvise(ptr, m_size, MADV_SEQUENTIAL);
+
+        m_data = static_cast<const char *>(ptr);
+      }
+
+    ::close(fd);
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if (m_data && m_data != m_content.data())
+      munmap(const_cast<char *>(m_data), m_size);
+  }
+
+
+    // FNV-1a like mixing of 8-byte words followed by tail bytes and length
+
+  static const uint64_t s_checksum_prime(0x100000001b3ULL);
+
+  static inline uint64_t
+  checksum_mix(uint64_t h, const char * data) noexcept
+  {
+    uint64_t w;
+    memcpy(&w, data, sizeof(w));
+    h = (h ^ w) * s_checksum_prime;
+    return (h ^ (h >> 29));
+  }
+
+  void
+  Checksum::update(const char * data, size_t len) noexcept
+  {
+    m_len += len;
+
+    if (m_tail_len)
+      {
+        const size_t n(std::min(len, sizeof(m_tail) - m_tail_len));
+        memcpy(m_tail + m_tail_len, data, n);
+        m_tail_len += n;
+        data += n;
+        len -= n;
+
+        if (m_tail_len < sizeof(m_tail))
+          return;
+
+        m_value = checksum_mix(m_value, m_tail);
+        m_tail_len = 0;
+      }
+
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), data += sizeof(uint64_t))
+      m_value = checksum_mix(m_value, data);
+
+    if (len)
+      {
+        memcpy(m_tail, data, len);
+        m_tail_len = len;
+      }
+  }
+
+  uint64_t
+  Checksum::value() const noexcept
+  {
+    uint64_t h(m_value);
+
+    for (size_t i = 0; i < m_tail_len; ++i)
+      h = (h ^ static_cast<uint8_t>(m_tail[i])) * s_checksum_prime;
+
+    h = (h ^ m_len) * s_checksum_prime;
+
+    return (h ^ (h >> 32));
+  }
+
 }
 
 static std::string
@@ -115,6 +360,101 @@ OksXmlOutputStream::__throw_write_failed()
 }
 
 
+  //
+  // Escape sequences of symbols which cannot be written to xml as is
+  //
+
+namespace oks {
+  namespace xml {
+
+    struct EscapeTable {
+
+      const char * m_seq[256];   // escape sequence or nullptr
+      unsigned char m_len[256];  // length of escape sequence
+      bool m_stop[256];          // symbol has escape sequence or is end of string
+
+      EscapeTable()
+      {
+        for (unsigned int i = 0; i < 256; ++i)
+          {
+            m_seq[i] = nullptr;
+            m_len[i] = 0;
+            m_stop[i] = false;
+          }
+
+        m_stop[0] = true;
+
+        set('<', left_angle_bracket, sizeof(left_angle_bracket) - 1);
+        set('>', right_angle_bracket, sizeof(right_angle_bracket) - 1);
+        set('&', ampersand, sizeof(ampersand) - 1);
+        set('\'', single_quote, sizeof(single_quote) - 1);
+        set('\"', double_quote, sizeof(double_quote) - 1);
+        set('\r', carriage_return, sizeof(carriage_return) - 1);
+        set('\n', new_line, sizeof(new_line) - 1);
+        set('\t', tabulation, sizeof(tabulation) - 1);
+      }
+
+      void
+      set(unsigned char c, const char * seq, size_t len)
+      {
+        m_seq[c] = seq;
+        m_len[c] = len;
+        m_stop[c] = true;
+      }
+
+    };
+
+    static const EscapeTable s_escape_table;
+  }
+}
+
+
+  //
+  // Write buffer to the stream
+  // Throw std::exception if failed
+  //
+
+void
+OksXmlOutputStream::flush()
+{
+  const long len(m_ptr - m_buf.get());
+
+  if (len)
+    {
+      m_ptr = m_buf.get();
+
+      if (__builtin_expect((f.rdbuf()->sputn(m_buf.get(), len) != len), 0))
+        __throw_write_failed();
+
+      for (auto& x : m_checksums)
+        if (x.second)
+          x.first.update(m_buf.get(), len);
+    }
+}
+
+void
+OksXmlOutputStream::put_raw_block(const char * s, long len)
+{
+  flush();
+
+  if (len < s_buffer_size)
+    {
+      memcpy(m_ptr, s, len);
+      m_ptr += len;
+    }
+  else if (f.rdbuf()->sputn(s, len) != len)
+    {
+      __throw_write_failed();
+    }
+  else
+    {
+      for (auto& x : m_checksums)
+        if (x.second)
+          x.first.update(s, len);
+    }
+}
+
+
   //
   // Save char to xml output stream
   // Throw std::exception if failed
@@ -123,16 +463,12 @@ OksXmlOutputStream::__throw_write_failed()
 void
 OksXmlOutputStream::put(char c)
 {
-  if(c == '<')       put_raw(oks::xml::left_angle_bracket, sizeof(oks::xml::left_angle_bracket)-1);
-  else if(c == '>')  put_raw(oks::xml::right_angle_bracket, sizeof(oks::xml::right_angle_bracket)-1);
-  else if(c == '&')  put_raw(oks::xml::ampersand, sizeof(oks::xml::ampersand)-1);
-  else if(c == '\'') put_raw(oks::xml::single_quote, sizeof(oks::xml::single_quote)-1);
-  else if(c == '\"') put_raw(oks::xml::double_quote, sizeof(oks::xml::double_quote)-1);
-  else if(c == '\r') put_raw(oks::xml::carriage_return, sizeof(oks::xml::carriage_return)-1);
-  else if(c == '\n') put_raw(oks::xml::new_line, sizeof(oks::xml::new_line)-1);
-  else if(c == '\t') put_raw(oks::xml::tabulation, sizeof(oks::xml::tabulation)-1);
-  else               put_raw(c);
+  const unsigned char i(c);
 
+  if (const unsigned char len = oks::xml::s_escape_table.m_len[i])
+    put_raw(oks::xml::s_escape_table.m_seq[i], len);
+  else
+    put_raw(c);
 }
 
 
@@ -144,7 +480,43 @@ OksXmlOutputStream::put(char c)
 void
 OksXmlOutputStream::put(const char * str)
 {
-  while(*str) put(*str++);
+  while (true)
+    {
+      const char * p(str);
+
+      while (!oks::xml::s_escape_table.m_stop[static_cast<unsigned char>(*p)])
+        ++p;
+
+      if (p != str)
+        put_raw(str, p - str);
+
+      if (*p == 0)
+        return;
+
+      put(*p);
+
+      str = p + 1;
+    }
+}
+
+
+    //
+    // Save floating point numbers
+    // Throw std::exception if failed
+    //
+
+void
+OksXmlOutputStream::put_value(float value)
+{
+  char buf[64];
+  put_raw(buf, std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, std::numeric_limits<float>::digits10).ptr - buf);
+}
+
+void
+OksXmlOutputStream::put_value(double value)
+{
+  char buf[64];
+  put_raw(buf, std::to_chars(buf, buf + sizeof(buf), value, std::chars_format::general, std::numeric_limits<double>::digits10).ptr - buf);
 }
 
 
@@ -234,15 +606,8 @@ OksXmlOutputStream::put_attribute(const char * name, size_t len, uint32_t value)
   put_raw(name, len);
   put_raw('=');
   put_raw('\"');
-  if(value == 0) {
-    put_raw('0');
-  }
-  else {
-    char buf[12];
-    char * ptr = buf;
-    boost::spirit::karma::generate(ptr, boost::spirit::uint_, (unsigned int)value);
-    put_raw(buf, ptr - buf);
-  }
+  char buf[12];
+  put_raw(buf, std::to_chars(buf, buf + sizeof(buf), value).ptr - buf);
   put_raw('\"');
 }
 
@@ -299,6 +664,10 @@ OksXmlInputStream::get_quoted()
     }
 
     while(true) {
+      if(m_mapped) {
+        pos = copy_mapped(*m_v1, pos, scan_mapped('\"'));
+      }
+
       c = get();
 
       if( __builtin_expect((c == '\"'), 0) ) {
@@ -361,6 +730,12 @@ OksXmlInputStream::get_tag()
       int count(1);
 
       while(true) {
+        if(m_mapped) {
+          // symbols other than angle brackets and '-' cannot change the count or complete the comment start
+          static const char __tag_symbols[3] = { '<', '>', '-' };
+          pos = copy_mapped(*m_v1, pos, oks::xml::find_first_of(m_ptr, m_end, __tag_symbols, 3));
+        }
+
         char c2 = get();
 
         if(c2 == '<') count++;
@@ -425,6 +800,10 @@ OksXmlInputStream::get_token(const char __s1, OksXmlToken& token)
   size_t pos(0);
 
   while(true) {
+    if(m_mapped) {
+      pos = copy_mapped(token, pos, scan_mapped(__s1));
+    }
+
     last_read_c = get();
 
     if(last_read_c == __s1) { token.m_buf[pos] = '\0'; return pos; }
@@ -447,6 +826,11 @@ OksXmlInputStream::get_token2(char __fs, const char __s1, const char __s2, OksXm
   if(__fs == __s1 || __fs == __s2) { token.m_buf[1] = '\0'; return 1; }
 
   while(true) {
+    if(m_mapped) {
+      const char set[3] = { __s1, __s2, '&' };
+      pos = copy_mapped(token, pos, oks::xml::find_first_of(m_ptr, m_end, set, 3));
+    }
+
     last_read_c = get();
 
     if(last_read_c == __s1 || last_read_c == __s2) { token.m_buf[pos] = '\0'; return pos; }
@@ -467,6 +851,11 @@ OksXmlInputStream::get_token5(const char __s1, const char __s2, const char __s3,
   size_t pos(0);
 
   while(true) {
+    if(m_mapped) {
+      const char set[6] = { __s1, __s2, __s3, __s4, __s5, '&' };
+      pos = copy_mapped(token, pos, oks::xml::find_first_of(m_ptr, m_end, set, 6));
+    }
+
     last_read_c = get();
 
     if(last_read_c == __s1 || last_read_c == __s2 || last_read_c == __s3 || last_read_c == __s4 || last_read_c == __s5) { token.m_buf[pos] = '\0'; return; }
@@ -617,11 +1006,12 @@ OksXmlInputStream::__throw_eof() const
 }
 
 void
-OksXmlInputStream::__throw_strto(const char * f, const char * where, const char * what, unsigned long line_no, unsigned long line_pos)
+oks::throw_bad_num(const char * value, const std::from_chars_result& r, unsigned long line_no, unsigned long line_pos)
 {
   std::ostringstream text;
-  text << "function " << f << "(\'" << what << "\') has failed";
-  if(*where) text << " on unrecognized characters \'" << where << "\'";
-  if(errno) text << " with code " << errno << ", reason = \'" << oks::strerror(errno) << '\'';
+  text << "cannot convert \'" << value << "\' to number";
+  if(r.ec == std::errc::result_out_of_range) text << ": the value is out of range";
+  else if(r.ec != std::errc()) text << ": no digits found";
+  else text << " on unrecognized characters \'" << r.ptr << "\'";
   throw oks::BadFileData(text.str(), line_no, line_pos);
 }
@@ -0,0 +1,234 @@
+/**
+ *  \file BinarySnapshot_test.cxx
+ *
+ *  Test binary snapshot of data file (see OksKernel::save_binary_data()): the objects loaded from the snapshot
+ *  have to be the same as ones loaded from xml file, including multi-values, bound and not bound references.
+ */
+
+#define BOOST_TEST_MODULE BinarySnapshot_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/object.hpp"
+#include "oks/attribute.hpp"
+#include "oks/relationship.hpp"
+#include "oks/file.hpp"
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct TestDir {
+  std::string path;
+
+  TestDir() {
+    char tmpl[] = "/tmp/oks-binary-test-XXXXXX";
+    path = mkdtemp(tmpl);
+  }
+
+  ~TestDir() { std::filesystem::remove_all(path); }
+
+  std::string schema_file() const { return path + "/s.schema.xml"; }
+  std::string data_file() const { return path + "/d.data.xml"; }
+  std::string other_data_file() const { return path + "/o.data.xml"; }
+  std::string binary_file() const { return path + "/snapshot.bin"; }
+};
+
+
+  // create schema, data file with objects a0 ... a9 and other data file with objects b0 and b1;
+  // the data file references objects of other file without including it, so such references are not bound on load
+
+static void
+create_files(const TestDir& dir)
+{
+  OksKernel k(true);
+
+  OksFile * sf = k.new_schema(dir.schema_file());
+  OksClass * a = new OksClass("A", "", false, &k);
+  a->add(new OksAttribute("n", "s32", false, "", "0", "", false));
+  a->add(new OksAttribute("text", "string", false, "", "", "", false));
+  a->add(new OksAttribute("values", "s32", true, "", "", "", false));
+  a->add(new OksAttribute("names", "string", true, "", "", "", false));
+  a->add(new OksRelationship("next", "A", OksRelationship::Zero, OksRelationship::One, false, false, false, ""));
+  a->add(new OksRelationship("refs", "A", OksRelationship::Zero, OksRelationship::Many, false, false, false, ""));
+  k.save_schema(sf);
+
+  OksFile * of = k.new_data(dir.other_data_file());
+  of->add_include_file(dir.schema_file());
+
+  OksObject * b0 = new OksObject(a, "b0");
+  OksObject * b1 = new OksObject(a, "b1");
+
+  k.save_data(of);
+
+  OksFile * df = k.new_data(dir.data_file());
+  df->add_include_file(dir.schema_file());
+
+  std::vector<OksObject *> objs;
+
+  for (int32_t i = 0; i < 10; ++i)
+    objs.push_back(new OksObject(a, ("a" + std::to_string(i)).c_str()));
+
+  for (int32_t i = 0; i < 10; ++i)
+    {
+      OksObject * o = objs[i];
+
+      OksData n(i);
+      o->SetAttributeValue("n", &n);
+
+      OksData text(std::string("text of a") + std::to_string(i));
+      o->SetAttributeValue("text", &text);
+
+      OksData values(new OksData::List());
+      values.data.LIST->push_back(new OksData(i));
+      values.data.LIST->push_back(new OksData(-i * 2));
+      o->SetAttributeValue("values", &values);
+
+      OksData names(new OksData::List());
+      names.data.LIST->push_back(new OksData(std::string("x") + std::to_string(i)));
+      names.data.LIST->push_back(new OksData(std::string()));
+      o->SetAttributeValue("names", &names);
+
+      o->SetRelationshipValue("next", i ? objs[i - 1] : b0);
+
+      if (i % 2 == 0)
+        {
+          o->AddRelationshipValue("refs", objs[(i + 1) % 10]);
+          o->AddRelationshipValue("refs", b1);
+        }
+    }
+
+  k.save_data(df);
+}
+
+
+  // describe value including types of data
+
+static std::string
+describe(const OksData& d)
+{
+  std::ostringstream s;
+
+  if (d.type == OksData::list_type)
+    {
+      s << '(';
+      for (const auto& x : *d.data.LIST)
+        s << describe(*x) << ' ';
+      s << ')';
+    }
+  else
+    {
+      s << d.type << ':' << d;
+    }
+
+  return s.str();
+}
+
+
+  // describe objects of kernel: identity, values of attributes and relationships
+
+static std::map<std::string, std::string>
+get_objects(OksKernel& k)
+{
+  std::map<std::string, std::string> objs;
+
+  if (const OksObject::Map * m = k.find_class("A")->objects())
+    for (const auto& x : *m)
+      {
+        std::ostringstream s;
+
+        for (const char * name : { "n", "text", "values", "names" })
+          s << describe(*x.second->GetAttributeValue(name)) << '\n';
+
+        for (const char * name : { "next", "refs" })
+          s << describe(*x.second->GetRelationshipValue(name)) << '\n';
+
+        objs[x.first->c_str()] = s.str();
+      }
+
+  return objs;
+}
+
+
+BOOST_AUTO_TEST_CASE(save_and_load)
+{
+  TestDir dir;
+  create_files(dir);
+
+  std::map<std::string, std::string> objs;
+
+  {
+    OksKernel k(true);
+    OksFile * fp = k.load_file(dir.data_file());
+    objs = get_objects(k);
+    k.save_binary_data(fp, dir.binary_file());
+  }
+
+  BOOST_REQUIRE_EQUAL(objs.size(), 10);
+
+  OksKernel k(true);
+  k.load_file(dir.binary_file());
+
+  BOOST_CHECK(get_objects(k) == objs);
+
+  OksClass * a = k.find_class("A");
+
+    // a0 references object of not included file, a1 references a0
+
+  BOOST_CHECK_EQUAL(a->get_object("a0")->GetRelationshipValue("next")->type, OksData::uid_type);
+  BOOST_CHECK_EQUAL(a->get_object("a1")->GetRelationshipValue("next")->type, OksData::object_type);
+  BOOST_CHECK_EQUAL(a->get_object("a1")->GetRelationshipValue("next")->data.OBJECT, a->get_object("a0"));
+
+  const OksData::List * refs = a->get_object("a2")->GetRelationshipValue("refs")->data.LIST;
+  BOOST_REQUIRE_EQUAL(refs->size(), 2);
+  BOOST_CHECK_EQUAL(refs->front()->data.OBJECT, a->get_object("a3"));
+  BOOST_CHECK_EQUAL(refs->back()->type, OksData::uid_type);
+
+  BOOST_CHECK(a->get_object("a9")->GetRelationshipValue("refs")->data.LIST->empty());
+}
+
+
+BOOST_AUTO_TEST_CASE(load_included)
+{
+  TestDir dir;
+  create_files(dir);
+
+  {
+    OksKernel k(true);
+    OksFile * fp = k.load_file(dir.other_data_file());
+    k.save_binary_data(fp, dir.binary_file());
+  }
+
+    // the top file includes the data file and the other file or its binary snapshot, so all references are bound
+
+  auto load_top = [&dir](const std::string& other)
+    {
+      const std::string top(dir.path + "/top.data.xml");
+
+      {
+        OksKernel k(true);
+        OksFile * fp = k.new_data(top);
+        fp->add_include_file(dir.data_file());
+        fp->add_include_file(other);
+        k.save_data(fp);
+      }
+
+      OksKernel k(true);
+      k.load_file(top);
+
+      BOOST_CHECK_EQUAL(k.find_class("A")->get_object("a0")->GetRelationshipValue("next")->type, OksData::object_type);
+
+      return get_objects(k);
+    };
+
+  std::map<std::string, std::string> objs(load_top(dir.other_data_file()));
+
+  BOOST_CHECK_EQUAL(objs.size(), 12);
+  BOOST_CHECK(load_top(dir.binary_file()) == objs);
+}
@@ -0,0 +1,178 @@
+/**
+ *  \file CompositeIndex_test.cxx
+ *
+ *  Test queries using composite index of objects by values of several attributes (see OksCompositeIndex)
+ *  against full scan of objects.
+ */
+
+#define BOOST_TEST_MODULE CompositeIndex_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "IndexTestFixture.hpp"
+
+#include "oks/attribute.hpp"
+#include "oks/index.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+  // kernel with class A having attributes "x", "y", "z" and "w" and its subclass B
+
+struct Fixture : public IndexTestFixture {
+  OksClass * a;
+  OksClass * b;
+  std::vector<OksObject *> objs;
+
+  Fixture() : IndexTestFixture("composite-index-test")
+  {
+    a = new OksClass("A", "", false, &k);
+    a->add(new OksAttribute("x", "s32", false, "", "0", "", false));
+    a->add(new OksAttribute("y", "s32", false, "", "0", "", false));
+    a->add(new OksAttribute("z", "string", false, "", "", "", false));
+    a->add(new OksAttribute("w", "u16", false, "", "0", "", false));
+    b = new OksClass("B", "", false, &k);
+    b->add_super_class("A");
+    new_data();
+
+    for (int32_t i = 0; i < 2000; ++i)
+      {
+        OksObject * o = new OksObject((i % 5 == 0 ? b : a), ("o" + std::to_string(i)).c_str());
+        set(o, i % 10, (i / 10) % 20);
+        OksData z("s" + std::to_string(i % 7));
+        o->SetAttributeValue("z", &z);
+        OksData w(static_cast<uint16_t>(i % 3));
+        o->SetAttributeValue("w", &w);
+        objs.push_back(o);
+      }
+  }
+
+  static void set(OksObject * o, int32_t x, int32_t y)
+  {
+    OksData dx(x);
+    o->SetAttributeValue("x", &dx);
+    OksData dy(y);
+    o->SetAttributeValue("y", &dy);
+  }
+
+  std::vector<OksAttribute *> attributes(const std::vector<std::string>& names) const
+  {
+    std::vector<OksAttribute *> result;
+
+    for (const auto& x : names)
+      result.push_back(a->find_attribute(x));
+
+    return result;
+  }
+
+    // run queries using index (or not using it, if used is false), then remove the index and compare with results of queries scanning objects
+
+  static void check(std::unique_ptr<OksCompositeIndex>& index, OksClass * c, const std::vector<std::string>& queries, bool used = true)
+  {
+    std::vector<Objects> results;
+
+    for (const auto& x : queries)
+      results.push_back(indexed_query(*index, c, x, used));
+
+    index.reset();
+
+    for (size_t i = 0; i < queries.size(); ++i)
+      {
+        const Objects expected(query(c, queries[i]));
+        BOOST_CHECK_MESSAGE(results[i] == expected, "query " << queries[i] << " found " << results[i].size() << " objects instead of " << expected.size());
+      }
+  }
+};
+
+
+static std::vector<std::string>
+range_queries(const std::string& x, const std::string& y, const std::string& mode)
+{
+  std::vector<std::string> result;
+
+  for (const char * cmp : { "<", "<=", ">", ">=" })
+    result.push_back("(" + mode + " (and (\"x\" \"" + x + "\" =) (\"y\" \"" + y + "\" " + cmp + ")))");
+
+  return result;
+}
+
+
+BOOST_FIXTURE_TEST_CASE(equality_prefix_and_range, Fixture)
+{
+  std::vector<std::string> queries {
+    "(this (\"x\" \"3\" =))",
+    "(this (and (\"x\" \"3\" =) (\"y\" \"5\" =)))",
+    "(this (and (\"x\" \"3\" =) (\"y\" \"5\" =) (\"z\" \"s2\" =)))",
+    "(this (and (\"x\" \"42\" =) (\"y\" \"5\" =)))"
+  };
+
+  for (const auto& y : { "0", "5", "19", "-1", "20" })
+    for (const auto& x : range_queries("3", y, "this"))
+      queries.push_back(x);
+
+  for (int i = 0; i < 2; ++i)
+    {
+      std::unique_ptr<OksCompositeIndex> index(new OksCompositeIndex(a, attributes({"x", "y", "z"})));
+      BOOST_CHECK_EQUAL(index->size(), a->number_of_objects());
+      check(index, a, queries);
+
+        // repeat after update of objects
+
+      for (size_t j = 0; j < objs.size(); j += 7)
+        set(objs[j], (j / 7) % 10, 19 - (j % 20));
+    }
+}
+
+
+BOOST_FIXTURE_TEST_CASE(and_with_extra_comparators, Fixture)
+{
+  const std::vector<std::string> queries {
+    "(this (and (\"x\" \"3\" =) (\"y\" \"5\" <) (\"w\" \"1\" =)))",
+    "(this (and (\"w\" \"2\" !=) (\"y\" \"12\" >=) (\"x\" \"7\" =)))",
+    "(this (and (\"x\" \"3\" =) (\"y\" \"2\" >) (\"y\" \"17\" <=)))",
+    "(this (and (\"x\" \"3\" =) (\"y\" \"2\" >=) (\"y\" \"17\" <) (\"z\" \"s4\" !=)))",
+    "(this (and (\"x\" \"3\" =) (\"z\" \"s1\" =)))",
+    "(this (and (\"x\" \"3\" =) (or (\"y\" \"1\" =) (\"y\" \"2\" =))))"
+  };
+
+  std::unique_ptr<OksCompositeIndex> index(new OksCompositeIndex(a, attributes({"x", "y", "z"})));
+  check(index, a, queries);
+
+    // the index cannot be used without comparator of its first attribute
+
+  index.reset(new OksCompositeIndex(a, attributes({"x", "y", "z"})));
+  check(index, a, { "(this (and (\"y\" \"5\" =) (\"z\" \"s1\" =)))" }, false);
+}
+
+
+BOOST_FIXTURE_TEST_CASE(subclasses, Fixture)
+{
+  std::vector<std::string> queries {
+    "(all (and (\"x\" \"5\" =) (\"y\" \"7\" =)))",
+    "(all (and (\"x\" \"5\" =) (\"y\" \"7\" <) (\"w\" \"0\" =)))"
+  };
+
+  for (const auto& x : range_queries("5", "10", "all"))
+    queries.push_back(x);
+
+  {
+    std::unique_ptr<OksCompositeIndex> index(new OksCompositeIndex(a, attributes({"x", "y"}), true));
+    BOOST_CHECK_EQUAL(index->size(), a->number_of_objects() + b->number_of_objects());
+    check(index, a, queries);
+  }
+
+    // the index is registered in superclass only, so queries of subclass scan its objects
+
+  {
+    std::unique_ptr<OksCompositeIndex> index(new OksCompositeIndex(a, attributes({"x", "y"}), true));
+
+    std::vector<std::string> this_queries;
+
+    for (const auto& x : range_queries("5", "10", "this"))
+      this_queries.push_back(x);
+
+    check(index, b, this_queries, false);
+  }
+}
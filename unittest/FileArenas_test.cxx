@@ -0,0 +1,161 @@
+/**
+ *  \file FileArenas_test.cxx
+ *
+ *  Test file arenas mode (see OksKernel::set_file_arenas_mode()): the memory of arenas used to load a data file
+ *  has to be returned when the file is closed and must not grow when the file is reloaded several times.
+ */
+
+#define BOOST_TEST_MODULE FileArenas_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/object.hpp"
+#include "oks/attribute.hpp"
+#include "oks/file.hpp"
+#include "oks/arena.hpp"
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <set>
+#include <string>
+
+struct TestDir {
+  std::string path;
+
+  TestDir() {
+    char tmpl[] = "/tmp/oks-file-arenas-test-XXXXXX";
+    path = mkdtemp(tmpl);
+  }
+
+  ~TestDir() { std::filesystem::remove_all(path); }
+
+  std::string schema_file() const { return path + "/s.schema.xml"; }
+  std::string data_file() const { return path + "/d.data.xml"; }
+};
+
+static const int32_t s_num_of_objects = 20000;
+
+
+  // create data file with objects having single and multi-value attributes; the values depend on version
+
+static void
+create_files(const TestDir& dir, int32_t version)
+{
+  OksKernel k(true);
+
+  OksFile * sf = k.new_schema(dir.schema_file());
+  OksClass * a = new OksClass("A", "", false, &k);
+  a->add(new OksAttribute("n", "s32", false, "", "0", "", false));
+  a->add(new OksAttribute("text", "string", false, "", "", "", false));
+  a->add(new OksAttribute("names", "string", true, "", "", "", false));
+  k.save_schema(sf);
+
+  OksFile * df = k.new_data(dir.data_file());
+  df->add_include_file(dir.schema_file());
+
+  for (int32_t i = 0; i < s_num_of_objects; ++i)
+    {
+      OksObject * o = new OksObject(a, ("a" + std::to_string(i)).c_str());
+
+      OksData n(i + version);
+      o->SetAttributeValue("n", &n);
+
+      OksData text("text of object a" + std::to_string(i) + " version " + std::to_string(version));
+      o->SetAttributeValue("text", &text);
+
+      OksData names(new OksData::List());
+      for (int32_t j = 0; j < 4; ++j)
+        names.data.LIST->push_back(new OksData("name " + std::to_string(j + version)));
+      o->SetAttributeValue("names", &names);
+    }
+
+  k.save_data(df);
+}
+
+
+BOOST_AUTO_TEST_CASE(close_file)
+{
+  TestDir dir;
+  create_files(dir, 0);
+
+  OksKernel k(true);
+  k.set_file_arenas_mode(true);
+  k.load_schema(dir.schema_file());
+
+  const size_t initial(oks::Arena::chunks_in_use());
+
+  for (int i = 0; i < 3; ++i)
+    {
+      OksFile * fp = k.load_data(dir.data_file());
+      BOOST_CHECK_EQUAL(k.find_class("A")->number_of_objects(), s_num_of_objects);
+
+      const size_t loaded(oks::Arena::chunks_in_use());
+      BOOST_TEST_MESSAGE("chunks in use: " << initial << " => " << loaded);
+      BOOST_CHECK(loaded > initial);
+
+      k.close_data(fp);
+      BOOST_CHECK_EQUAL(oks::Arena::chunks_in_use(), initial);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(reload_file)
+{
+  TestDir dir;
+  create_files(dir, 0);
+
+  OksKernel k(true);
+  k.set_file_arenas_mode(true);
+
+  const size_t initial(oks::Arena::chunks_in_use());
+
+  OksFile * fp = k.load_file(dir.data_file());
+  const size_t loaded(oks::Arena::chunks_in_use());
+  BOOST_CHECK(loaded > initial);
+
+    // the reloaded objects keep the chunks of first load, the values of previous load are freed
+
+  size_t reloaded(0);
+
+  for (int32_t version = 1; version < 6; ++version)
+    {
+      create_files(dir, version);
+
+      std::set<OksFile *> files { fp };
+      k.reload_data(files);
+
+      OksObject * o = k.find_class("A")->get_object("a7");
+      BOOST_REQUIRE(o != nullptr);
+      BOOST_CHECK_EQUAL(o->GetAttributeValue("n")->data.S32_INT, 7 + version);
+
+      const size_t used(oks::Arena::chunks_in_use());
+      BOOST_TEST_MESSAGE("chunks in use after reload " << version << ": " << used);
+
+      if (reloaded == 0)
+        reloaded = used;
+      else
+        BOOST_CHECK_EQUAL(used, reloaded);
+    }
+
+  BOOST_CHECK(reloaded < loaded * 2);
+
+  k.close_data(fp);
+  BOOST_CHECK_EQUAL(oks::Arena::chunks_in_use(), initial);
+}
+
+
+BOOST_AUTO_TEST_CASE(without_arenas)
+{
+  TestDir dir;
+  create_files(dir, 0);
+
+  OksKernel k(true);
+
+  const size_t initial(oks::Arena::chunks_in_use());
+
+  k.load_file(dir.data_file());
+  BOOST_CHECK_EQUAL(oks::Arena::chunks_in_use(), initial);
+}
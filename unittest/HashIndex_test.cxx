@@ -0,0 +1,180 @@
+/**
+ *  \file HashIndex_test.cxx
+ *
+ *  Test hash index of objects by value of attribute (see OksHashIndex) against full scan of objects.
+ */
+
+#define BOOST_TEST_MODULE HashIndex_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "IndexTestFixture.hpp"
+
+#include "oks/attribute.hpp"
+#include "oks/index.hpp"
+
+#include <string>
+#include <vector>
+
+
+  // kernel with class A having s32 attribute "n" and string attribute "s" and objects a0 ... a999
+
+struct Fixture : public IndexTestFixture {
+  OksClass * a;
+  std::vector<OksObject *> objs;
+
+  Fixture() : IndexTestFixture("hash-index-test")
+  {
+    a = new OksClass("A", "", false, &k);
+    a->add(new OksAttribute("n", "s32", false, "", "0", "", false));
+    a->add(new OksAttribute("s", "string", false, "", "", "", false));
+    new_data();
+
+    for (int32_t i = 0; i < 1000; ++i)
+      objs.push_back(create("a" + std::to_string(i), i % 37, "s" + std::to_string(i % 11)));
+  }
+
+  OksObject * create(const std::string& id, int32_t n, const std::string& s)
+  {
+    OksObject * o = new OksObject(a, id.c_str());
+    set_n(o, n);
+    OksData d(s);
+    o->SetAttributeValue("s", &d);
+    return o;
+  }
+
+  static void set_n(OksObject * o, int32_t n)
+  {
+    OksData d(n);
+    o->SetAttributeValue("n", &d);
+  }
+
+  Objects scan(const std::string& name, const OksData& value) const
+  {
+    Objects result;
+
+    for (const auto& x : *a->objects())
+      if (*x.second->GetAttributeValue(name) == value)
+        result.insert(x.second);
+
+    return result;
+  }
+
+  Objects query(const OksHashIndex& index, const std::string& name, const std::string& value) const
+  {
+    return indexed_query(index, a, "(this (\"" + name + "\" \"" + value + "\" =))");
+  }
+
+  static Objects find(const OksHashIndex& index, const OksData& value)
+  {
+    return to_set(index.FindEqual(&value));
+  }
+
+    // compare index and queries with scan for all values of "n" in given range
+
+  void check_n(const OksHashIndex& index, int32_t from, int32_t to) const
+  {
+    for (int32_t v = from; v < to; ++v)
+      {
+        const OksData d(v);
+        const Objects expected(scan("n", d));
+        BOOST_CHECK_MESSAGE(find(index, d) == expected, "index lookup of n = " << v);
+        BOOST_CHECK_MESSAGE(query(index, "n", std::to_string(v)) == expected, "query of n = " << v);
+      }
+
+    BOOST_CHECK_EQUAL(index.size(), a->number_of_objects());
+  }
+};
+
+
+BOOST_FIXTURE_TEST_CASE(find_equal, Fixture)
+{
+  OksHashIndex index(a, a->find_attribute("n"));
+  check_n(index, -1, 40);
+
+  OksHashIndex s_index(a, a->find_attribute("s"));
+
+  for (int i = 0; i < 12; ++i)
+    {
+      const std::string s("s" + std::to_string(i));
+      const Objects expected(scan("s", OksData(s)));
+      BOOST_CHECK(find(s_index, OksData(s)) == expected);
+      BOOST_CHECK(query(s_index, "s", s) == expected);
+    }
+}
+
+
+BOOST_FIXTURE_TEST_CASE(insert_remove, Fixture)
+{
+  OksHashIndex index(a, a->find_attribute("n"));
+
+  for (int32_t i = 0; i < 200; ++i)
+    create("b" + std::to_string(i), i % 41, "b");
+
+  check_n(index, -1, 45);
+
+  for (size_t i = 0; i < objs.size(); i += 3)
+    OksObject::destroy(objs[i]);
+
+  check_n(index, -1, 45);
+}
+
+
+BOOST_FIXTURE_TEST_CASE(set_attribute_value, Fixture)
+{
+  OksHashIndex index(a, a->find_attribute("n"));
+
+  for (size_t i = 0; i < objs.size(); i += 2)
+    set_n(objs[i], 100 + i % 13);
+
+  check_n(index, -1, 120);
+
+    // move all objects out of some values and back
+
+  for (const auto& o : objs)
+    if (o->GetAttributeValue("n")->data.S32_INT == 5)
+      set_n(o, 6);
+
+  check_n(index, -1, 120);
+
+  for (size_t i = 0; i < objs.size(); i += 2)
+    set_n(objs[i], i % 37);
+
+  check_n(index, -1, 120);
+}
+
+
+BOOST_FIXTURE_TEST_CASE(rehash_with_tombstones, Fixture)
+{
+  OksHashIndex index(a, a->find_attribute("n"));
+
+    // each value is used once, so removal of object leaves removed slot
+
+  for (int32_t round = 0; round < 20; ++round)
+    {
+      std::vector<OksObject *> created;
+
+      for (int32_t i = 0; i < 300; ++i)
+        created.push_back(create("r" + std::to_string(round) + '-' + std::to_string(i), 1000 + round * 300 + i, "r"));
+
+      for (size_t i = 0; i < created.size(); ++i)
+        if (i % 10)
+          OksObject::destroy(created[i]);
+
+      BOOST_CHECK_EQUAL(index.size(), a->number_of_objects());
+    }
+
+  check_n(index, -1, 40);
+
+  size_t num = 0;
+
+  for (int32_t v = 1000; v < 1000 + 20 * 300; ++v)
+    {
+      const OksData d(v);
+      const Objects expected(scan("n", d));
+      num += expected.size();
+      BOOST_CHECK_MESSAGE(find(index, d) == expected, "index lookup of n = " << v);
+    }
+
+  BOOST_CHECK_EQUAL(num, 20 * 30);
+}
@@ -0,0 +1,91 @@
+/**
+ *  \file IndexTestFixture.hpp
+ *
+ *  Common part of the fixtures of index tests: the kernel with schema and data files in unique temporary directory,
+ *  and the execution of queries checking that the index was used.
+ */
+
+#ifndef OKS_UNITTEST_INDEX_TEST_FIXTURE_HPP
+#define OKS_UNITTEST_INDEX_TEST_FIXTURE_HPP
+
+#include "boost/test/unit_test.hpp"
+
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/object.hpp"
+#include "oks/query.hpp"
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <set>
+#include <string>
+
+typedef std::set<OksObject *> Objects;
+
+struct TestDir {
+  std::string path;
+
+  TestDir(const std::string& name) {
+    std::string tmpl("/tmp/oks-" + name + "-XXXXXX");
+    path = mkdtemp(tmpl.data());
+  }
+
+  ~TestDir() { std::filesystem::remove_all(path); }
+
+  std::string schema_file() const { return path + "/s.schema.xml"; }
+  std::string data_file() const { return path + "/d.data.xml"; }
+};
+
+
+  // the derived fixture creates classes after creation of schema file, and then calls new_data()
+
+struct IndexTestFixture {
+  TestDir dir;
+  OksKernel k;
+
+  IndexTestFixture(const std::string& name) : dir(name), k(true)
+  {
+    k.new_schema(dir.schema_file());
+  }
+
+  void new_data()
+  {
+    k.new_data(dir.data_file());
+  }
+
+    // take objects from the list returned by index or query and destroy it
+
+  static Objects to_set(OksObject::List * l)
+  {
+    Objects result;
+
+    if (l)
+      {
+        result.insert(l->begin(), l->end());
+        delete l;
+      }
+
+    return result;
+  }
+
+  static Objects query(OksClass * c, const std::string& str)
+  {
+    OksQuery q(c, str);
+    BOOST_REQUIRE_MESSAGE(q.good(), "parse query " << str);
+    return to_set(c->execute_query(&q));
+  }
+
+    // execute query and check it was (or was not, if used is false) executed using given index
+
+  template<class Index>
+  static Objects indexed_query(const Index& index, OksClass * c, const std::string& str, bool used = true)
+  {
+    const size_t lookups = index.number_of_lookups();
+    Objects result(query(c, str));
+    BOOST_CHECK_MESSAGE((index.number_of_lookups() == lookups + 1) == used, "query " << str << (used ? " did not use" : " used") << " the index");
+    return result;
+  }
+};
+
+#endif
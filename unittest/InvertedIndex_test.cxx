@@ -0,0 +1,287 @@
+/**
+ *  \file InvertedIndex_test.cxx
+ *
+ *  Test \b contains comparator of queries and inverted index of objects by items of multi-value attribute
+ *  (see OksInvertedIndex) against full scan of objects.
+ */
+
+#define BOOST_TEST_MODULE InvertedIndex_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "IndexTestFixture.hpp"
+
+#include "oks/attribute.hpp"
+#include "oks/index.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+  // kernel with class A having multi-value attributes "tags" and "ports" and single-value attribute "n",
+  // and with classes B and C derived from A
+
+struct Fixture : public IndexTestFixture {
+  OksClass * a;
+  OksClass * b;
+  OksClass * c;
+  std::vector<OksObject *> objs;
+
+  Fixture() : IndexTestFixture("inverted-index-test")
+  {
+    a = new OksClass("A", "", false, &k);
+    a->add(new OksAttribute("tags", "string", true, "", "", "", false));
+    a->add(new OksAttribute("ports", "u16", true, "", "", "", false));
+    a->add(new OksAttribute("n", "s32", false, "", "0", "", false));
+    b = new OksClass("B", "", false, &k);
+    b->add_super_class("A");
+    c = new OksClass("C", "", false, &k);
+    c->add_super_class("B");
+    new_data();
+
+    OksClass * classes[] = { a, b, c };
+
+    for (int32_t i = 0; i < 1500; ++i)
+      {
+        OksObject * o = new OksObject(classes[i % 3], ("o" + std::to_string(i)).c_str());
+
+        if (i % 10)
+          set_tags(o, { "t" + std::to_string(i % 13), "t" + std::to_string(20 + i % 7), "t" + std::to_string(i % 13) });
+
+        std::vector<uint16_t> ports;
+
+        for (int32_t j = 0; j < i % 4; ++j)
+          ports.push_back(8000 + (i + j) % 9);
+
+        set_ports(o, ports);
+
+        OksData n(i % 17);
+        o->SetAttributeValue("n", &n);
+
+        objs.push_back(o);
+      }
+  }
+
+  static void set_tags(OksObject * o, const std::vector<std::string>& values)
+  {
+    OksData d(new OksData::List());
+
+    for (const auto& x : values)
+      d.data.LIST->push_back(new OksData(x));
+
+    o->SetAttributeValue("tags", &d);
+  }
+
+  static void set_ports(OksObject * o, const std::vector<uint16_t>& values)
+  {
+    OksData d(new OksData::List());
+
+    for (const auto& x : values)
+      d.data.LIST->push_back(new OksData(x));
+
+    o->SetAttributeValue("ports", &d);
+  }
+
+    // objects of class (and of its subclasses) which multi-value attribute contains given item
+
+  static Objects scan(const OksClass * cl, bool subclasses, const std::string& name, const OksData& item)
+  {
+    std::vector<const OksClass *> classes(1, cl);
+
+    if (subclasses && cl->all_sub_classes())
+      classes.insert(classes.end(), cl->all_sub_classes()->begin(), cl->all_sub_classes()->end());
+
+    Objects result;
+
+    for (const auto& x : classes)
+      if (x->objects())
+        for (const auto& o : *x->objects())
+          for (const auto& d : *o.second->GetAttributeValue(x->data_info(name))->data.LIST)
+            if (*d == item)
+              result.insert(o.second);
+
+    return result;
+  }
+
+  static Objects find(const OksInvertedIndex& index, const OksData& item)
+  {
+    return to_set(index.FindContaining(&item));
+  }
+
+    // execute query using index, if it is given
+
+  static Objects query(const OksInvertedIndex * index, OksClass * cl, const std::string& str)
+  {
+    return (index ? indexed_query(*index, cl, str) : IndexTestFixture::query(cl, str));
+  }
+
+  static std::string contains(bool subclasses, const std::string& name, const std::string& value)
+  {
+    return std::string("(") + (subclasses ? "all" : "this") + " (\"" + name + "\" \"" + value + "\" contains))";
+  }
+
+    // number of objects of class A (or of all classes) having non-empty multi-value attribute
+
+  size_t number_of_objects_with_values(bool subclasses, const std::string& name) const
+  {
+    size_t num = 0;
+
+    for (const auto& o : objs)
+      if ((subclasses || o->GetClass() == a) && !o->GetAttributeValue(name)->data.LIST->empty())
+        num++;
+
+    return num;
+  }
+
+    // compare index lookups and queries of tags with scan; the queries have to use the index, if it is given
+
+  void check_tags(const OksInvertedIndex * index, OksClass * cl, bool subclasses) const
+  {
+    for (int i = 0; i < 30; ++i)
+      {
+        const std::string value("t" + std::to_string(i));
+        const Objects expected(scan(cl, subclasses, "tags", OksData(value)));
+
+        if (index)
+          BOOST_CHECK_MESSAGE(find(*index, OksData(value)) == expected, "index lookup of " << value);
+
+        BOOST_CHECK_MESSAGE(query(index, cl, contains(subclasses, "tags", value)) == expected, "query " << contains(subclasses, "tags", value));
+      }
+  }
+
+    // compare index lookups and queries of ports with scan; the queries have to use the index, if it is given
+
+  void check_ports(const OksInvertedIndex * index, OksClass * cl, bool subclasses) const
+  {
+    for (uint16_t i = 7999; i < 8010; ++i)
+      {
+        const Objects expected(scan(cl, subclasses, "ports", OksData(i)));
+
+        if (index)
+          BOOST_CHECK_MESSAGE(find(*index, OksData(i)) == expected, "index lookup of " << i);
+
+        BOOST_CHECK_MESSAGE(query(index, cl, contains(subclasses, "ports", std::to_string(i))) == expected, "query " << contains(subclasses, "ports", std::to_string(i)));
+      }
+  }
+};
+
+
+BOOST_FIXTURE_TEST_CASE(parse_and_print, Fixture)
+{
+  const std::vector<std::string> queries {
+    contains(false, "tags", "t3"),
+    contains(true, "ports", "8001"),
+    "(all (and (\"tags\" \"t3\" contains) (\"n\" \"5\" >)))",
+    "(this (or (\"tags\" \"t21\" contains) (not (\"ports\" \"8002\" contains))))"
+  };
+
+  for (const auto& x : queries)
+    {
+      OksQuery q(a, x);
+      BOOST_REQUIRE_MESSAGE(q.good(), "parse query " << x);
+
+      std::ostringstream s;
+      s << q;
+
+      BOOST_CHECK_MESSAGE(s.str().find(std::string(" ") + OksQuery::CT + ')') != std::string::npos, "print query " << s.str());
+
+      OksQuery q2(a, s.str());
+      BOOST_REQUIRE_MESSAGE(q2.good(), "parse printed query " << s.str());
+
+      std::ostringstream s2;
+      s2 << q2;
+
+      BOOST_CHECK_EQUAL(s.str(), s2.str());
+      BOOST_CHECK(query(nullptr, a, x) == query(nullptr, a, s.str()));
+    }
+
+    // the value of multi-value attribute is parsed as item
+
+  OksQuery q(a, contains(false, "ports", "8001"));
+  BOOST_REQUIRE(q.good() && q.get()->type() == OksQuery::comparator_type);
+
+  OksComparator * cmp = static_cast<OksComparator *>(q.get());
+  BOOST_CHECK(cmp->GetFunction() == OksQuery::contains_cmp);
+  BOOST_CHECK_EQUAL(cmp->GetValue()->type, OksData::u16_int_type);
+  BOOST_CHECK_EQUAL(cmp->GetValue()->data.U16_INT, 8001);
+}
+
+
+BOOST_FIXTURE_TEST_CASE(contains_without_index, Fixture)
+{
+  check_tags(nullptr, a, false);
+  check_tags(nullptr, a, true);
+  check_ports(nullptr, b, false);
+  check_ports(nullptr, b, true);
+}
+
+
+BOOST_FIXTURE_TEST_CASE(inverted_index, Fixture)
+{
+  std::unique_ptr<OksInvertedIndex> index(new OksInvertedIndex(a, a->find_attribute("tags")));
+
+  BOOST_CHECK_EQUAL(index->size(), number_of_objects_with_values(false, "tags"));
+  check_tags(index.get(), a, false);
+  check_tags(nullptr, a, true);
+
+    // update, create and destroy objects
+
+  for (size_t i = 0; i < objs.size(); i += 4)
+    set_tags(objs[i], { "t" + std::to_string(i % 29) });
+
+  for (size_t i = 3; i < objs.size(); i += 9)
+    set_tags(objs[i], { });
+
+  for (int i = 0; i < 100; ++i)
+    {
+      OksObject * o = new OksObject(a, ("new" + std::to_string(i)).c_str());
+      set_tags(o, { "t" + std::to_string(i % 5), "t29" });
+      objs.push_back(o);
+    }
+
+  for (size_t i = 1; i < objs.size(); i += 6)
+    {
+      OksObject::destroy(objs[i]);
+      objs[i] = nullptr;
+    }
+
+  objs.erase(std::remove(objs.begin(), objs.end(), nullptr), objs.end());
+
+  BOOST_CHECK_EQUAL(index->size(), number_of_objects_with_values(false, "tags"));
+  check_tags(index.get(), a, false);
+  check_tags(nullptr, a, true);
+}
+
+
+BOOST_FIXTURE_TEST_CASE(subclasses, Fixture)
+{
+  std::unique_ptr<OksInvertedIndex> index(new OksInvertedIndex(a, a->find_attribute("ports"), true));
+
+  BOOST_CHECK_EQUAL(index->size(), number_of_objects_with_values(true, "ports"));
+  check_ports(index.get(), a, true);
+  check_ports(nullptr, a, false);
+  check_ports(nullptr, b, false);
+  check_ports(nullptr, c, true);
+
+    // update objects of subclasses
+
+  for (size_t i = 1; i < objs.size(); i += 3)
+    set_ports(objs[i], { static_cast<uint16_t>(8000 + i % 3), 8009 });
+
+  for (size_t i = 2; i < objs.size(); i += 6)
+    {
+      OksObject::destroy(objs[i]);
+      objs[i] = nullptr;
+    }
+
+  objs.erase(std::remove(objs.begin(), objs.end(), nullptr), objs.end());
+
+  BOOST_CHECK_EQUAL(index->size(), number_of_objects_with_values(true, "ports"));
+  check_ports(index.get(), a, true);
+  check_ports(nullptr, b, false);
+  check_ports(nullptr, b, true);
+  check_ports(nullptr, c, false);
+}
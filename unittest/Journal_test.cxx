@@ -0,0 +1,247 @@
+/**
+ *  \file Journal_test.cxx
+ *
+ *  Test journal of data files (see OksKernel::set_journal_mode()): append, replay on load and reload, compact
+ *  and recovery of journal having partially written commit.
+ */
+
+#define BOOST_TEST_MODULE Journal_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/object.hpp"
+#include "oks/attribute.hpp"
+#include "oks/relationship.hpp"
+#include "oks/file.hpp"
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+
+struct TestDir {
+  std::string path;
+
+  TestDir() {
+    char tmpl[] = "/tmp/oks-journal-test-XXXXXX";
+    path = mkdtemp(tmpl);
+  }
+
+  ~TestDir() { std::filesystem::remove_all(path); }
+
+  std::string schema_file() const { return path + "/s.schema.xml"; }
+  std::string data_file() const { return path + "/d.data.xml"; }
+  std::string journal_file() const { return data_file() + ".journal"; }
+};
+
+static std::string
+read_file(const std::string& name)
+{
+  std::ifstream f(name);
+  std::stringstream s;
+  s << f.rdbuf();
+  return s.str();
+}
+
+static void
+set_value(OksObject * o, int32_t value)
+{
+  OksData d(value);
+  o->SetAttributeValue("n", &d);
+}
+
+
+  // create schema and data file with objects a0 ... a9, each referencing previous one
+
+static void
+create_files(const TestDir& dir)
+{
+  OksKernel k(true);
+
+  OksFile * sf = k.new_schema(dir.schema_file());
+  OksClass * a = new OksClass("A", "", false, &k);
+  a->add(new OksAttribute("n", "s32", false, "", "0", "", false));
+  a->add(new OksRelationship("next", "A", OksRelationship::Zero, OksRelationship::One, false, false, false, ""));
+  k.save_schema(sf);
+
+  OksFile * df = k.new_data(dir.data_file());
+  df->add_include_file(dir.schema_file());
+
+  OksObject * prev = nullptr;
+
+  for (int32_t i = 0; i < 10; ++i)
+    {
+      OksObject * o = new OksObject(a, ("a" + std::to_string(i)).c_str());
+      set_value(o, i);
+
+      if (prev)
+        o->SetRelationshipValue("next", prev);
+
+      prev = o;
+    }
+
+  k.save_data(df);
+}
+
+
+  // describe objects of kernel: identity, attribute value and reference
+
+static std::map<std::string, std::string>
+get_objects(OksKernel& k)
+{
+  std::map<std::string, std::string> objs;
+
+  if (const OksObject::Map * m = k.find_class("A")->objects())
+    for (const auto& x : *m)
+      {
+        std::ostringstream s;
+        s << *x.second->GetAttributeValue("n") << ' ' << *x.second->GetRelationshipValue("next");
+        objs[x.first->c_str()] = s.str();
+      }
+
+  return objs;
+}
+
+static std::map<std::string, std::string>
+load_objects(const std::string& data_file)
+{
+  OksKernel k(true);
+  k.load_file(data_file);
+  return get_objects(k);
+}
+
+
+  // modify, remove, create and rename objects, save them to journal and return expected description of objects
+
+static std::map<std::string, std::string>
+append_changes(OksKernel& k, OksFile * fp)
+{
+  OksClass * a = k.find_class("A");
+
+  set_value(a->get_object("a5"), 42);
+  OksObject::destroy(a->get_object("a9"));
+  (new OksObject(a, "a20"))->SetRelationshipValue("next", a->get_object("a5"));
+  a->get_object("a3")->set_id("a3x");
+
+  std::map<std::string, std::string> objs(get_objects(k));
+
+  k.save_data(fp);
+
+  return objs;
+}
+
+
+BOOST_AUTO_TEST_CASE(append_replay_compact)
+{
+  TestDir dir;
+  create_files(dir);
+
+  const std::string data(read_file(dir.data_file()));
+  std::map<std::string, std::string> objs;
+
+  {
+    OksKernel k(true);
+    OksFile * fp = k.load_file(dir.data_file());
+    k.set_active_data(fp);
+    k.set_journal_mode(true);
+
+    objs = append_changes(k, fp);
+
+    BOOST_CHECK_EQUAL(objs.size(), 10);
+    BOOST_CHECK(data == read_file(dir.data_file()));
+    BOOST_REQUIRE(std::filesystem::exists(dir.journal_file()));
+  }
+
+    // replay on load
+
+  BOOST_CHECK(load_objects(dir.data_file()) == objs);
+
+    // replay on reload after second commit
+
+  {
+    OksKernel k(true);
+    OksFile * fp = k.load_file(dir.data_file());
+    k.set_active_data(fp);
+    k.set_journal_mode(true);
+
+    OksClass * a = k.find_class("A");
+    set_value(a->get_object("a6"), 43);
+    OksObject::destroy(a->get_object("a20"));
+    objs = get_objects(k);
+    k.save_data(fp);
+
+    set_value(a->get_object("a7"), 0);
+    OksObject::destroy(a->get_object("a8"));
+
+    std::set<OksFile *> files { fp };
+    k.reload_data(files);
+
+    BOOST_CHECK(get_objects(k) == objs);
+    BOOST_CHECK(data == read_file(dir.data_file()));
+
+      // compact
+
+    k.compact_data(fp);
+
+    BOOST_CHECK(!std::filesystem::exists(dir.journal_file()));
+    BOOST_CHECK(data != read_file(dir.data_file()));
+  }
+
+  BOOST_CHECK(load_objects(dir.data_file()) == objs);
+}
+
+
+BOOST_AUTO_TEST_CASE(partial_commit)
+{
+  TestDir dir;
+  create_files(dir);
+
+  std::map<std::string, std::string> objs;
+
+  {
+    OksKernel k(true);
+    OksFile * fp = k.load_file(dir.data_file());
+    k.set_active_data(fp);
+    k.set_journal_mode(true);
+
+    objs = append_changes(k, fp);
+  }
+
+  const std::string journal(read_file(dir.journal_file()));
+
+    // simulate process crashed while appending commit
+
+  {
+    std::ofstream f(dir.journal_file(), std::ios::app);
+    f << "<obj class=\"A\" id=\"a1\">\n <attr name=\"n\" type=\"s32\" val=\"7";
+  }
+
+  BOOST_CHECK(load_objects(dir.data_file()) == objs);
+
+    // the partial commit is truncated by next append
+
+  {
+    OksKernel k(true);
+    OksFile * fp = k.load_file(dir.data_file());
+    k.set_active_data(fp);
+    k.set_journal_mode(true);
+
+    set_value(k.find_class("A")->get_object("a1"), 11);
+    objs = get_objects(k);
+    k.save_data(fp);
+  }
+
+  const std::string journal2(read_file(dir.journal_file()));
+
+  BOOST_CHECK(journal2.compare(0, journal.size(), journal) == 0);
+  BOOST_CHECK(journal2.find("val=\"7", journal.size()) == std::string::npos);
+  BOOST_CHECK(journal2.size() >= sizeof("<commit/>\n") - 1 && journal2.compare(journal2.size() - sizeof("<commit/>\n") + 1, std::string::npos, "<commit/>\n") == 0);
+
+  BOOST_CHECK(load_objects(dir.data_file()) == objs);
+}
@@ -0,0 +1,176 @@
+/**
+ *  \file ParallelSave_test.cxx
+ *
+ *  Test saving of data files by several threads (see OksKernel::set_parallel_save_mode()) and reporting of errors.
+ */
+
+#define BOOST_TEST_MODULE ParallelSave_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/object.hpp"
+#include "oks/attribute.hpp"
+#include "oks/file.hpp"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+  // the threads pool size is read once on first creation of kernel
+
+struct ThreadsPoolSize {
+  ThreadsPoolSize() { setenv("OKS_KERNEL_THREADS_POOL_SIZE", "4", 1); }
+};
+
+BOOST_TEST_GLOBAL_FIXTURE(ThreadsPoolSize);
+
+struct TestDir {
+  std::string path;
+
+  TestDir() {
+    char tmpl[] = "/tmp/oks-parallel-save-test-XXXXXX";
+    path = mkdtemp(tmpl);
+  }
+
+  ~TestDir() { std::filesystem::remove_all(path); }
+
+  std::string schema_file() const { return path + "/s.schema.xml"; }
+  std::string data_file(size_t idx) const { return path + "/d" + std::to_string(idx) + ".data.xml"; }
+};
+
+static const size_t s_num_of_files = 6;
+
+static size_t
+count(const std::string& s, const std::string& item)
+{
+  size_t n(0);
+
+  for (std::string::size_type p = s.find(item); p != std::string::npos; p = s.find(item, p + item.size()))
+    ++n;
+
+  return n;
+}
+
+
+  // create data files with objects; the files which do not include the schema cannot be saved
+
+static std::vector<OksFile *>
+create_files(OksKernel& k, const TestDir& dir, const std::vector<size_t>& bad_files)
+{
+  OksFile * sf = k.new_schema(dir.schema_file());
+  OksClass * a = new OksClass("A", "", false, &k);
+  a->add(new OksAttribute("n", "s32", false, "", "0", "", false));
+  k.save_schema(sf);
+
+  std::vector<OksFile *> files;
+
+  for (size_t i = 0; i < s_num_of_files; ++i)
+    {
+      OksFile * df = k.new_data(dir.data_file(i));
+
+      if (std::find(bad_files.begin(), bad_files.end(), i) == bad_files.end())
+        df->add_include_file(dir.schema_file());
+
+      for (int32_t j = 0; j < 10; ++j)
+        {
+          OksObject * o = new OksObject(a, ("a" + std::to_string(i) + '.' + std::to_string(j)).c_str());
+          OksData d(j);
+          o->SetAttributeValue("n", &d);
+        }
+
+      files.push_back(df);
+    }
+
+  return files;
+}
+
+
+BOOST_AUTO_TEST_CASE(save_all)
+{
+  TestDir dir;
+
+  {
+    OksKernel k(true);
+    k.set_parallel_save_mode(true);
+    create_files(k, dir, {});
+    k.save_all_data();
+  }
+
+  OksKernel k(true);
+
+  for (size_t i = 0; i < s_num_of_files; ++i)
+    k.load_file(dir.data_file(i));
+
+  BOOST_CHECK_EQUAL(k.find_class("A")->number_of_objects(), s_num_of_files * 10);
+}
+
+
+BOOST_AUTO_TEST_CASE(errors_of_several_files)
+{
+  TestDir dir;
+
+  const std::vector<size_t> bad_files { 1, 4 };
+
+  OksKernel k(true);
+  k.set_parallel_save_mode(true);
+  create_files(k, dir, bad_files);
+
+  std::string text;
+
+  try
+    {
+      k.save_all_data();
+    }
+  catch (const oks::CanNotWriteToFile& ex)
+    {
+      text = ex.what();
+    }
+
+  BOOST_TEST_MESSAGE(text);
+  BOOST_REQUIRE(!text.empty());
+
+    // each failed file is reported once, followed by the nested reasons
+
+  BOOST_CHECK(text.find("save_all_data(): failed to write data files") != std::string::npos);
+  BOOST_CHECK_EQUAL(count(text, "the file contains inconsistent/duplicated objects or misses includes"), bad_files.size());
+
+  for (size_t i = 0; i < s_num_of_files; ++i)
+    {
+      const bool is_bad(std::find(bad_files.begin(), bad_files.end(), i) != bad_files.end());
+      BOOST_CHECK_EQUAL(count(text, dir.data_file(i)), is_bad ? 1 : 0);
+
+      if (!is_bad)
+        BOOST_CHECK(std::filesystem::file_size(dir.data_file(i)) > 0);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(error_of_single_file)
+{
+  TestDir dir;
+
+  OksKernel k(true);
+  k.set_parallel_save_mode(true);
+  create_files(k, dir, { 2 });
+
+  std::string text;
+
+  try
+    {
+      k.save_all_data();
+    }
+  catch (const oks::CanNotWriteToFile& ex)
+    {
+      text = ex.what();
+    }
+
+    // the exception of single failed file is thrown as is
+
+  BOOST_CHECK(text.find("k_save_data(): failed to write data file") != std::string::npos);
+  BOOST_CHECK_EQUAL(count(text, dir.data_file(2)), 1);
+}
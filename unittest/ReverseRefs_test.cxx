@@ -0,0 +1,204 @@
+/**
+ *  \file ReverseRefs_test.cxx
+ *
+ *  Test reverse references index of kernel used by OksObject::destroy() and OksObject::get_all_rels():
+ *  the index has to follow references bound on load, modified by relationship set methods and modified in place
+ *  via the value returned by OksObject::GetRelationshipValue().
+ */
+
+#define BOOST_TEST_MODULE ReverseRefs_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/object.hpp"
+#include "oks/relationship.hpp"
+#include "oks/file.hpp"
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <string>
+
+struct TestDir {
+  std::string path;
+
+  TestDir() {
+    char tmpl[] = "/tmp/oks-reverse-refs-test-XXXXXX";
+    path = mkdtemp(tmpl);
+  }
+
+  ~TestDir() { std::filesystem::remove_all(path); }
+
+  std::string schema_file() const { return path + "/s.schema.xml"; }
+  std::string data_file() const { return path + "/d.data.xml"; }
+};
+
+
+  // create schema and data file with objects a0 ... a3, where a1 and a2 reference a0, and a2 references a1
+
+static void
+create_files(const TestDir& dir)
+{
+  OksKernel k(true);
+
+  OksFile * sf = k.new_schema(dir.schema_file());
+  OksClass * a = new OksClass("A", "", false, &k);
+  a->add(new OksRelationship("next", "A", OksRelationship::Zero, OksRelationship::One, false, false, false, ""));
+  a->add(new OksRelationship("refs", "A", OksRelationship::Zero, OksRelationship::Many, false, false, false, ""));
+  k.save_schema(sf);
+
+  OksFile * df = k.new_data(dir.data_file());
+  df->add_include_file(dir.schema_file());
+
+  OksObject * a0 = new OksObject(a, "a0");
+  OksObject * a1 = new OksObject(a, "a1");
+  OksObject * a2 = new OksObject(a, "a2");
+  new OksObject(a, "a3");
+
+  a1->SetRelationshipValue("next", a0);
+  a2->AddRelationshipValue("refs", a0);
+  a2->AddRelationshipValue("refs", a1);
+
+  k.save_data(df);
+}
+
+
+  // return names of objects referencing given one via relationship
+
+static std::set<std::string>
+get_all_rels(const OksObject * o, const std::string& name = "*")
+{
+  std::set<std::string> result;
+
+  std::unique_ptr<OksObject::FList> refs(o->get_all_rels(name));
+
+  if (refs)
+    for (const auto& x : *refs)
+      result.insert(x->GetId());
+
+  return result;
+}
+
+
+static bool
+can_destroy(OksObject * o)
+{
+  try
+    {
+      OksObject::destroy(o);
+      return true;
+    }
+  catch (const oks::FailedDestoyObject& ex)
+    {
+      BOOST_TEST_MESSAGE(ex.what());
+      return false;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(bound_references)
+{
+  TestDir dir;
+  create_files(dir);
+
+  OksKernel k(true);
+  k.load_file(dir.data_file());
+
+  OksClass * a = k.find_class("A");
+
+  BOOST_CHECK(get_all_rels(a->get_object("a0")) == std::set<std::string>({ "a1", "a2" }));
+  BOOST_CHECK(get_all_rels(a->get_object("a0"), "next") == std::set<std::string>({ "a1" }));
+  BOOST_CHECK(get_all_rels(a->get_object("a1"), "refs") == std::set<std::string>({ "a2" }));
+  BOOST_CHECK(get_all_rels(a->get_object("a2")).empty());
+
+  BOOST_CHECK(!can_destroy(a->get_object("a0")));
+  BOOST_CHECK(!can_destroy(a->get_object("a1")));
+
+    // nobody references a2; once it is destroyed, a1 is referenced by nobody
+
+  BOOST_CHECK(can_destroy(a->get_object("a2")));
+  BOOST_CHECK(get_all_rels(a->get_object("a0")) == std::set<std::string>({ "a1" }));
+  BOOST_CHECK(can_destroy(a->get_object("a1")));
+  BOOST_CHECK(can_destroy(a->get_object("a0")));
+}
+
+
+BOOST_AUTO_TEST_CASE(set_methods)
+{
+  TestDir dir;
+  create_files(dir);
+
+  OksKernel k(true);
+  k.load_file(dir.data_file());
+
+  OksClass * a = k.find_class("A");
+  OksObject * a0 = a->get_object("a0");
+  OksObject * a1 = a->get_object("a1");
+  OksObject * a2 = a->get_object("a2");
+  OksObject * a3 = a->get_object("a3");
+
+    // build the index, then it is updated by set methods
+
+  BOOST_CHECK(get_all_rels(a0).size() == 2);
+
+  a3->AddRelationshipValue("refs", a0);
+  BOOST_CHECK(get_all_rels(a0, "refs") == std::set<std::string>({ "a2", "a3" }));
+
+  a1->SetRelationshipValue("next", a3);
+  BOOST_CHECK(get_all_rels(a0) == std::set<std::string>({ "a2", "a3" }));
+  BOOST_CHECK(get_all_rels(a3) == std::set<std::string>({ "a1" }));
+
+  a2->RemoveRelationshipValue("refs", a0);
+  a3->RemoveRelationshipValue("refs", a0);
+  BOOST_CHECK(get_all_rels(a0).empty());
+  BOOST_CHECK(!can_destroy(a3));
+  BOOST_CHECK(can_destroy(a0));
+
+  OksData d(new OksData::List());
+  d.data.LIST->push_back(new OksData(a1));
+  d.data.LIST->push_back(new OksData(a3));
+  a2->SetRelationshipValue("refs", &d);
+
+  BOOST_CHECK(get_all_rels(a1) == std::set<std::string>({ "a2" }));
+  BOOST_CHECK(get_all_rels(a3) == std::set<std::string>({ "a1", "a2" }));
+
+  a1->SetRelationshipValue("next", static_cast<OksObject *>(nullptr));
+  BOOST_CHECK(get_all_rels(a3) == std::set<std::string>({ "a2" }));
+  BOOST_CHECK(!can_destroy(a3));
+}
+
+
+BOOST_AUTO_TEST_CASE(modified_in_place)
+{
+  TestDir dir;
+  create_files(dir);
+
+  OksKernel k(true);
+  k.load_file(dir.data_file());
+
+  OksClass * a = k.find_class("A");
+  OksObject * a0 = a->get_object("a0");
+  OksObject * a3 = a->get_object("a3");
+
+  BOOST_CHECK(get_all_rels(a3).empty());
+
+    // the value returned by GetRelationshipValue() is modified directly, bypassing set methods
+
+  a0->GetRelationshipValue("next")->Set(a3);
+
+  BOOST_CHECK(get_all_rels(a3) == std::set<std::string>({ "a0" }));
+  BOOST_CHECK(!can_destroy(a3));
+
+  a->get_object("a2")->GetRelationshipValue("refs")->data.LIST->push_back(new OksData(a3));
+
+  BOOST_CHECK(get_all_rels(a3) == std::set<std::string>({ "a0", "a2" }));
+
+  a0->GetRelationshipValue("next")->Set(static_cast<OksObject *>(nullptr));
+
+  BOOST_CHECK(get_all_rels(a3) == std::set<std::string>({ "a2" }));
+  BOOST_CHECK(!can_destroy(a3));
+}
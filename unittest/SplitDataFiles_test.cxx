@@ -0,0 +1,224 @@
+/**
+ *  \file SplitDataFiles_test.cxx
+ *
+ *  Test loading of large data files parsed in parts by several threads (see OksKernel::set_split_data_files_mode()).
+ *  The data files using class aliases (see OksAliasTable) cannot be split, since the aliases depend on order of objects.
+ */
+
+#define BOOST_TEST_MODULE SplitDataFiles_test
+
+#include "boost/test/unit_test.hpp"
+
+#include "oks/kernel.hpp"
+#include "oks/class.hpp"
+#include "oks/object.hpp"
+#include "oks/attribute.hpp"
+#include "oks/relationship.hpp"
+#include "oks/file.hpp"
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+  // the threads pool size is read once on first creation of kernel
+
+struct ThreadsPoolSize {
+  ThreadsPoolSize() { setenv("OKS_KERNEL_THREADS_POOL_SIZE", "4", 1); }
+};
+
+BOOST_TEST_GLOBAL_FIXTURE(ThreadsPoolSize);
+
+struct TestDir {
+  std::string path;
+
+  TestDir() {
+    char tmpl[] = "/tmp/oks-split-test-XXXXXX";
+    path = mkdtemp(tmpl);
+  }
+
+  ~TestDir() { std::filesystem::remove_all(path); }
+};
+
+static const size_t s_num_of_objects = 40000;
+static const std::string s_text(80, 'x');
+
+
+  // create schema and data file with references to next object; the data file is larger than two parts of split
+
+static void
+create_files(const std::string& dir)
+{
+  OksKernel k(true);
+
+  OksFile * sf = k.new_schema(dir + "/s.schema.xml");
+  OksClass * a = new OksClass("A", "", false, &k);
+  a->add(new OksAttribute("n", "s32", false, "", "0", "", false));
+  a->add(new OksAttribute("text", "string", false, "", "", "", false));
+  a->add(new OksRelationship("next", "A", OksRelationship::Zero, OksRelationship::One, false, false, false, ""));
+  k.save_schema(sf);
+
+  OksFile * df = k.new_data(dir + "/d.data.xml");
+  df->add_include_file(dir + "/s.schema.xml");
+
+  std::vector<OksObject *> objs;
+
+  for (size_t i = 0; i < s_num_of_objects; ++i)
+    {
+      OksObject * o = new OksObject(a, ("a" + std::to_string(i)).c_str());
+      OksData n((int32_t)i);
+      o->SetAttributeValue("n", &n);
+      OksData t(s_text);
+      o->SetAttributeValue("text", &t);
+      objs.push_back(o);
+    }
+
+  for (size_t i = 0; i + 1 < s_num_of_objects; ++i)
+    objs[i]->SetRelationshipValue("next", objs[i + 1]);
+
+  k.save_data(df);
+}
+
+
+  // write the same objects into data file of compact format: the first reference defines alias "0" of class "A"
+  // by "@A" mark, and the next references use this alias instead of the class name
+
+static void
+create_compact_file(const std::string& dir)
+{
+  std::ofstream f(dir + "/c.data.xml");
+
+  f << "<?xml version=\"1.0\" encoding=\"ASCII\"?>\n\n"
+       "<!DOCTYPE oks-data [\n"
+       "  <!ELEMENT oks-data (info, (include)?, (o)+)>\n"
+       "]>\n\n"
+       "<oks-data>\n\n"
+       "<info name=\"\" type=\"\" num-of-items=\"" << s_num_of_objects << "\" oks-format=\"compact\" oks-version=\"test\"/>\n\n"
+       "<include>\n"
+       " <file path=\"s.schema.xml\"/>\n"
+       "</include>\n\n";
+
+  for (size_t i = 0; i < s_num_of_objects; ++i)
+    {
+      f << "<o c=\"A\" i=\"a" << i << "\">\n " << i << " \"" << s_text << "\" ";
+
+      if (i + 1 < s_num_of_objects)
+        f << (i ? "\"0\"" : "\"@A\"") << " \"a" << (i + 1) << '\"';
+      else
+        f << "\"\" \"\"";
+
+      f << "\n</o>\n";
+    }
+
+  f << "\n</oks-data>\n";
+}
+
+
+  // load data file and return description of objects: identity, attribute values and references
+
+static std::map<std::string, std::string>
+load_objects(const std::string& data_file, bool split, long& number_of_parts)
+{
+  OksKernel k(true);
+  k.set_use_mapped_files_mode(true);
+  k.set_split_data_files_mode(split);
+  number_of_parts = k.load_file(data_file)->get_number_of_parts();
+
+  std::map<std::string, std::string> objs;
+
+  if (const OksObject::Map * m = k.find_class("A")->objects())
+    for (const auto& x : *m)
+      {
+        std::ostringstream s;
+        const OksData * next(x.second->GetRelationshipValue("next"));
+        s << *x.second->GetAttributeValue("n") << ' ' << *x.second->GetAttributeValue("text") << ' ' << next->type << ':' << *next;
+        objs[x.first->c_str()] = s.str();
+      }
+
+  return objs;
+}
+
+
+BOOST_AUTO_TEST_CASE(class_aliases)
+{
+  TestDir dir;
+  create_files(dir.path);
+  create_compact_file(dir.path);
+
+  const std::string data_file(dir.path + "/c.data.xml");
+  BOOST_REQUIRE(std::filesystem::file_size(data_file) > 2 * 1024 * 1024);
+
+  long number_of_parts(0);
+
+    // the objects and references read from normal and compact files are the same
+
+  const std::map<std::string, std::string> objs(load_objects(dir.path + "/d.data.xml", false, number_of_parts));
+  BOOST_CHECK_EQUAL(number_of_parts, 1);
+
+  const std::map<std::string, std::string> compact_objs(load_objects(data_file, false, number_of_parts));
+  BOOST_CHECK_EQUAL(number_of_parts, 1);
+
+  const std::map<std::string, std::string> split_objs(load_objects(data_file, true, number_of_parts));
+  BOOST_CHECK_EQUAL(number_of_parts, 1);
+
+  BOOST_CHECK_EQUAL(objs.size(), s_num_of_objects);
+  BOOST_CHECK(objs == compact_objs);
+  BOOST_CHECK(objs == split_objs);
+}
+
+
+BOOST_AUTO_TEST_CASE(split)
+{
+  TestDir dir;
+  create_files(dir.path);
+
+  const std::string data_file(dir.path + "/d.data.xml");
+  BOOST_REQUIRE(std::filesystem::file_size(data_file) > 2 * 1024 * 1024);
+
+  long number_of_parts(0);
+
+  const std::map<std::string, std::string> objs(load_objects(data_file, false, number_of_parts));
+  BOOST_CHECK_EQUAL(number_of_parts, 1);
+
+    // the file without class aliases and comments is split
+
+  const std::map<std::string, std::string> split_objs(load_objects(data_file, true, number_of_parts));
+  BOOST_CHECK_GT(number_of_parts, 1);
+
+  BOOST_CHECK_EQUAL(objs.size(), s_num_of_objects);
+  BOOST_CHECK(objs == split_objs);
+}
+
+
+BOOST_AUTO_TEST_CASE(references)
+{
+  TestDir dir;
+  create_files(dir.path);
+
+  OksKernel k(true);
+  k.set_use_mapped_files_mode(true);
+  k.set_split_data_files_mode(true);
+  BOOST_CHECK_GT(k.load_file(dir.path + "/d.data.xml")->get_number_of_parts(), 1);
+
+  OksClass * a = k.find_class("A");
+  BOOST_REQUIRE(a != nullptr);
+  BOOST_CHECK_EQUAL(a->number_of_objects(), s_num_of_objects);
+
+  size_t num_of_bad_refs = 0;
+
+  for (size_t i = 0; i + 1 < s_num_of_objects; ++i)
+    {
+      OksObject * o = a->get_object("a" + std::to_string(i));
+      BOOST_REQUIRE(o != nullptr);
+
+      OksData * d = o->GetRelationshipValue("next");
+
+      if (d->type != OksData::object_type || d->data.OBJECT == nullptr || d->data.OBJECT->GetId() != "a" + std::to_string(i + 1))
+        num_of_bad_refs++;
+    }
+
+  BOOST_CHECK_EQUAL(num_of_bad_refs, 0);
+}